@@ -0,0 +1,188 @@
+/*
+    SPDX-License-Identifier: MIT
+    SPDX-FileCopyrightText: 2025 Kate Code contributors
+*/
+
+// Compares the two ways kate-mcp-server has called the editor service:
+// a QDBusInterface constructed per tool call and one long-lived generated
+// KateCodeEditorInterface proxy. Each QDBusInterface resolves the service
+// owner with a synchronous GetNameOwner and adds and removes a match rule;
+// only the first one per connection introspects, later ones hit the cache.
+//
+// Usage: dbus_call_bench [--iterations N] [--service NAME]
+// Without --service a stub editor is spawned as a child process on a private
+// service name; with --service org.kde.katecode.editor it runs against Kate.
+
+#include "katecode_editor_adaptor.h"
+#include "katecode_editor_interface.h"
+#include "stub_editor.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusError>
+#include <QDBusInterface>
+#include <QDBusReply>
+#include <QElapsedTimer>
+#include <QList>
+#include <QProcess>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+namespace {
+
+const QString OBJECT_PATH = QStringLiteral("/KateCode/Editor");
+const QString INTERFACE = QStringLiteral("org.kde.katecode.Editor");
+const int PIPELINE_DEPTH = 64;
+
+int serve(const QString &service)
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    StubEditor editor;
+    new EditorAdaptor(&editor);
+    if (!bus.registerObject(OBJECT_PATH, &editor, QDBusConnection::ExportAdaptors)
+        || !bus.registerService(service)) {
+        std::fprintf(stderr, "Cannot register %s: %s\n", qPrintable(service), qPrintable(bus.lastError().message()));
+        return 1;
+    }
+    return QCoreApplication::exec();
+}
+
+bool waitForService(const QString &service, int timeoutMs)
+{
+    QDBusConnectionInterface *busInterface = QDBusConnection::sessionBus().interface();
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < timeoutMs) {
+        if (busInterface->isServiceRegistered(service)) {
+            return true;
+        }
+        QThread::msleep(20);
+    }
+    return false;
+}
+
+// Runs call iterations times and prints per-call latency in microseconds
+void report(const char *label, int iterations, const std::function<bool()> &call)
+{
+    QList<double> samples;
+    samples.reserve(iterations);
+    QElapsedTimer total;
+    total.start();
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!call()) {
+            std::fprintf(stderr, "%s: call %d failed\n", label, i);
+            return;
+        }
+        samples.append(timer.nsecsElapsed() / 1000.0);
+    }
+    const double totalMs = total.nsecsElapsed() / 1e6;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : std::as_const(samples)) {
+        sum += sample;
+    }
+    std::printf("%-36s mean %8.1f us  median %8.1f us  p95 %8.1f us  (%d calls, %.0f ms)\n",
+                label, sum / samples.size(), samples[samples.size() / 2],
+                samples[qMin(int(samples.size()) - 1, int(samples.size() * 0.95))], iterations, totalMs);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption iterationsOption(QStringLiteral("iterations"), QStringLiteral("Calls per variant"),
+                                        QStringLiteral("n"), QStringLiteral("2000"));
+    QCommandLineOption serviceOption(QStringLiteral("service"), QStringLiteral("Benchmark against this running service"),
+                                     QStringLiteral("name"));
+    QCommandLineOption serveOption(QStringLiteral("serve"), QStringLiteral("Internal: run the stub editor"),
+                                   QStringLiteral("name"));
+    parser.addOption(iterationsOption);
+    parser.addOption(serviceOption);
+    parser.addOption(serveOption);
+    parser.process(app);
+
+    if (parser.isSet(serveOption)) {
+        return serve(parser.value(serveOption));
+    }
+
+    if (!QDBusConnection::sessionBus().isConnected()) {
+        std::fprintf(stderr, "No DBus session bus\n");
+        return 1;
+    }
+
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    QString service = parser.value(serviceOption);
+    QProcess stub;
+    if (service.isEmpty()) {
+        service = QStringLiteral("org.kde.katecode.bench%1").arg(QCoreApplication::applicationPid());
+        stub.start(QCoreApplication::applicationFilePath(), {QStringLiteral("--serve"), service});
+        if (!stub.waitForStarted() || !waitForService(service, 5000)) {
+            std::fprintf(stderr, "Stub editor did not come up\n");
+            return 1;
+        }
+    }
+    std::printf("Service %s, %d calls per variant, listDocuments()\n\n", qPrintable(service), iterations);
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+
+    // What kate-mcp-server did per tool call before the generated proxy
+    report("QDBusInterface per call", iterations, [&]() {
+        QDBusInterface iface(service, OBJECT_PATH, INTERFACE, bus);
+        if (!iface.isValid()) {
+            return false;
+        }
+        QDBusReply<QStringList> reply = iface.call(QStringLiteral("listDocuments"));
+        return reply.isValid();
+    });
+
+    // One QDBusInterface reused, to separate construction from call cost
+    QDBusInterface reused(service, OBJECT_PATH, INTERFACE, bus);
+    report("QDBusInterface reused", iterations, [&]() {
+        QDBusReply<QStringList> reply = reused.call(QStringLiteral("listDocuments"));
+        return reply.isValid();
+    });
+
+    // What kate-mcp-server does now
+    KateCodeEditorInterface proxy(service, OBJECT_PATH, bus);
+    report("Generated proxy, sequential", iterations, [&]() {
+        QDBusPendingReply<QStringList> reply = proxy.listDocuments();
+        reply.waitForFinished();
+        return !reply.isError();
+    });
+
+    // Async tool calls overlap; per-call figure is batch time / depth
+    const int batches = qMax(1, iterations / PIPELINE_DEPTH);
+    QElapsedTimer pipelined;
+    pipelined.start();
+    for (int batch = 0; batch < batches; ++batch) {
+        QList<QDBusPendingReply<QStringList>> replies;
+        replies.reserve(PIPELINE_DEPTH);
+        for (int i = 0; i < PIPELINE_DEPTH; ++i) {
+            replies.append(proxy.listDocuments());
+        }
+        for (QDBusPendingReply<QStringList> &reply : replies) {
+            reply.waitForFinished();
+        }
+    }
+    const int calls = batches * PIPELINE_DEPTH;
+    std::printf("%-36s mean %8.1f us  (%d calls, %d in flight)\n", "Generated proxy, pipelined",
+                pipelined.nsecsElapsed() / 1000.0 / calls, calls, PIPELINE_DEPTH);
+
+    if (stub.state() != QProcess::NotRunning) {
+        stub.terminate();
+        stub.waitForFinished(2000);
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+    SPDX-License-Identifier: MIT
+    SPDX-FileCopyrightText: 2025 Kate Code contributors
+*/
+
+// Times the tool call diff in src/web/code-render.js: computeDiffWithIndices
+// (Myers line diff) and generateUnifiedDiff (diff plus HTML, no highlighting),
+// on generated files of up to 100k lines.
+//
+// Usage: node bench/diff_bench.js [--runs N] [--highlight]
+// or open bench/diff_bench.html in a browser (QtWebEngine runs the same V8).
+// --highlight also loads the vendored highlight.js, as the chat page does.
+
+(function () {
+    'use strict';
+
+    const isNode = typeof window === 'undefined';
+    let runs = 5;
+    let highlight = false;
+
+    if (isNode) {
+        const fs = require('fs');
+        const path = require('path');
+        const vm = require('vm');
+        const args = process.argv.slice(2);
+        const runsArg = args.indexOf('--runs');
+        if (runsArg >= 0) {
+            runs = Math.max(1, parseInt(args[runsArg + 1], 10) || runs);
+        }
+        highlight = args.includes('--highlight');
+
+        // code-render.js is a plain script; run it in this context like the page does
+        const web = path.join(__dirname, '..', 'src', 'web');
+        globalThis.logToQt = () => {};
+        if (highlight) {
+            vm.runInThisContext(fs.readFileSync(path.join(web, 'vendor', 'highlight.min.js'), 'utf8'));
+        }
+        vm.runInThisContext(fs.readFileSync(path.join(web, 'code-render.js'), 'utf8'));
+    } else {
+        const params = new URLSearchParams(location.search);
+        runs = Math.max(1, parseInt(params.get('runs'), 10) || runs);
+        highlight = typeof hljs !== 'undefined';
+    }
+
+    const now = isNode ? () => Number(process.hrtime.bigint()) / 1e6 : () => performance.now();
+
+    // Deterministic inputs, so runs on different machines diff the same text
+    function random(seed) {
+        return () => {
+            seed = (seed + 0x6d2b79f5) | 0;
+            let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+            t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+            return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+        };
+    }
+
+    function sourceLines(count) {
+        const lines = new Array(count);
+        for (let i = 0; i < count; i++) {
+            switch (i % 8) {
+            case 0: lines[i] = `int function_${i}(int value)`; break;
+            case 1: lines[i] = '{'; break;
+            case 2: lines[i] = `    const int scaled = value * ${i % 97};`; break;
+            case 3: lines[i] = '    if (scaled > limit) {'; break;
+            case 4: lines[i] = `        return scaled - ${i % 13};`; break;
+            case 5: lines[i] = '    }'; break;
+            case 6: lines[i] = '    return scaled;'; break;
+            default: lines[i] = '}'; break;
+            }
+        }
+        return lines;
+    }
+
+    // Scatter changes over the file: a third each replaced, inserted and deleted
+    function changedLines(lines, changes, seed) {
+        const next = random(seed);
+        const result = lines.slice();
+        for (let c = 0; c < changes; c++) {
+            const at = Math.floor(next() * result.length);
+            switch (c % 3) {
+            case 0: result[at] = `    // changed ${c}: ${result[at]}`; break;
+            case 1: result.splice(at, 0, `    log("inserted ${c}");`); break;
+            default: result.splice(at, 1); break;
+            }
+        }
+        return result;
+    }
+
+    // Every line of the new side differs, the worst case for the search
+    function rewrittenLines(lines) {
+        return lines.map((line, i) => `${line} // rewritten ${i}`);
+    }
+
+    function measure(fn) {
+        fn();  // warm up
+        const samples = [];
+        for (let r = 0; r < runs; r++) {
+            const start = now();
+            fn();
+            samples.push(now() - start);
+        }
+        samples.sort((x, y) => x - y);
+        return samples[Math.floor(samples.length / 2)];
+    }
+
+    const cases = [];
+    for (const size of [1000, 10000, 100000]) {
+        for (const changes of [1, 50, 500]) {
+            cases.push({ size, changes });
+        }
+    }
+    cases.push({ size: 100000, changes: 5000 });
+    cases.push({ size: 10000, rewrite: true });
+    cases.push({ size: 100000, rewrite: true });
+
+    const out = [];
+    const print = line => {
+        out.push(line);
+        if (isNode) {
+            console.log(line);
+        }
+    };
+
+    print(`Median of ${runs} runs, highlight.js ${highlight ? 'on' : 'off'}`);
+    print('');
+    print('lines    changes    diff ms   unified ms   hunk lines');
+    for (const c of cases) {
+        const oldLines = sourceLines(c.size);
+        const newLines = c.rewrite ? rewrittenLines(oldLines) : changedLines(oldLines, c.changes, c.size + c.changes);
+        const oldText = oldLines.join('\n');
+        const newText = newLines.join('\n');
+
+        let diff = null;
+        const diffMs = measure(() => { diff = computeDiffWithIndices(oldLines, newLines); });
+        let html = '';
+        const unifiedMs = measure(() => { html = generateUnifiedDiff(oldText, newText, highlight ? 'bench.cpp' : 'bench'); });
+        const shown = (html.match(/<span class="diff-/g) || []).length - 2;
+
+        const label = c.rewrite ? 'all' : String(c.changes);
+        print(`${String(c.size).padStart(6)}  ${label.padStart(8)}  ${diffMs.toFixed(1).padStart(9)}  ${unifiedMs.toFixed(1).padStart(11)}  ${String(shown).padStart(11)}` +
+              (diff.length === 0 ? '  (empty diff)' : ''));
+    }
+
+    if (!isNode) {
+        document.getElementById('results').textContent = out.join('\n');
+    }
+})();
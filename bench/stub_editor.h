@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+/**
+ * StubEditor - Minimal org.kde.katecode.Editor for dbus_call_bench.
+ *
+ * Answers every method at once with a fixed reply, so the benchmark measures
+ * the DBus round trip and client-side call setup rather than editor work.
+ */
+class StubEditor : public QObject
+{
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+public Q_SLOTS:
+    QStringList listDocuments() { return {QStringLiteral("/tmp/a.cpp"), QStringLiteral("/tmp/b.h")}; }
+    QString socketPath() { return QString(); }
+    QString readDocument(const QString &) { return QString(); }
+    QString readDocumentRange(const QString &, int, int) { return QString(); }
+    QString readDocumentDelta(const QString &, qlonglong) { return QString(); }
+    QString editDocument(const QString &, const QString &, const QString &, const QString &) { return QStringLiteral("OK"); }
+    QString multiEditDocument(const QString &, const QStringList &, const QStringList &, const QString &) { return QStringLiteral("OK"); }
+    QString writeDocument(const QString &, const QString &, const QString &) { return QStringLiteral("OK"); }
+    QString askUserQuestion(const QString &, const QString &) { return QStringLiteral("{}"); }
+    void cancelQuestion(const QString &) { }
+};
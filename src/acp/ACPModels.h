@@ -96,6 +96,7 @@ struct ContextChunk {
 };
 
 struct TrackedEdit {
+    int id = 0;           // Assigned by EditTracker
     QString toolCallId;
     QString filePath;
     int startLine;        // 0-based line where edit starts
@@ -1,13 +1,12 @@
 #include "ACPSession.h"
 #include "ACPService.h"
 #include "TerminalManager.h"
+#include "../util/DocumentPatcher.h"
 #include "../util/EditTracker.h"
+#include "../util/SnapshotStore.h"
 #include "../util/TranscriptWriter.h"
 
-#include <KTextEditor/Cursor>
 #include <KTextEditor/Document>
-#include <KTextEditor/Range>
-#include <KTextEditor/View>
 
 #include <QDebug>
 #include <QDir>
@@ -38,7 +37,7 @@ static bool isWriteTool(const QString &name)
 static bool isEditTool(const QString &name)
 {
     return name == QStringLiteral("Edit") || name == QStringLiteral("mcp__acp__Edit") ||
-           name.endsWith(QStringLiteral("_katecode_edit"));
+           name.endsWith(QStringLiteral("_katecode_edit")) || name.endsWith(QStringLiteral("_katecode_multi_edit"));
 }
 
 static bool isBashTool(const QString &name)
@@ -99,6 +98,12 @@ ACPSession::~ACPSession()
         disconnect(m_service, nullptr, this, nullptr);
     }
     stop();
+    releaseSnapshots();
+}
+
+void ACPSession::setSnapshotStore(SnapshotStore *store)
+{
+    m_snapshotStore = store;
 }
 
 void ACPSession::setExecutable(const QString &executable, const QStringList &args)
@@ -117,6 +122,7 @@ void ACPSession::start(const QString &workingDir, const QString &permissionMode)
     m_workingDir = workingDir;
     m_status = ConnectionStatus::Connecting;
     m_editTracker->clear();
+    releaseSnapshots();
     Q_EMIT statusChanged(m_status);
 
     if (!m_service->start(workingDir)) {
@@ -144,6 +150,14 @@ void ACPSession::stop()
     Q_EMIT statusChanged(m_status);
 }
 
+void ACPSession::releaseSnapshots()
+{
+    if (m_snapshotStore && !m_snapshotToolCallIds.isEmpty()) {
+        m_snapshotStore->removeToolCalls(m_snapshotToolCallIds.values());
+    }
+    m_snapshotToolCallIds.clear();
+}
+
 void ACPSession::setTerminalSize(int columns, int rows)
 {
     m_terminalManager->setDefaultTerminalSize(columns, rows);
@@ -152,6 +166,7 @@ void ACPSession::setTerminalSize(int columns, int rows)
 void ACPSession::setDocumentProvider(DocumentProvider provider)
 {
     m_documentProvider = provider;
+    m_editTracker->setDocumentProvider(provider);
 }
 
 void ACPSession::cancelPrompt()
@@ -654,6 +669,8 @@ void ACPSession::handleSessionUpdate(const QJsonObject &params)
 
         // Track current tool call ID for edit tracking
         m_currentToolCallId = toolCall.id;
+        // Versions recorded under it, here or by the MCP tools, go with the session
+        m_snapshotToolCallIds.insert(toolCall.id);
 
         // Get tool name from _meta.claudeCode.toolName or fall back to title
         QJsonObject meta = update[QStringLiteral("_meta")].toObject();
@@ -803,6 +820,21 @@ void ACPSession::handleSessionUpdate(const QJsonObject &params)
                 qDebug() << "[ACPSession] Edit from rawInput - old:" << oldStr.length()
                          << "chars, new:" << newStr.length() << "chars";
             }
+
+            // katecode_multi_edit carries an ordered "edits" array instead
+            const QJsonArray rawEdits = toolCall.input[QStringLiteral("edits")].toArray();
+            for (const QJsonValue &rawEdit : rawEdits) {
+                EditDiff edit;
+                edit.oldText = rawEdit[QStringLiteral("old_string")].toString();
+                edit.newText = rawEdit[QStringLiteral("new_string")].toString();
+                edit.filePath = toolCall.filePath;
+                toolCall.edits.append(edit);
+            }
+            if (!rawEdits.isEmpty()) {
+                toolCall.oldText = toolCall.edits.first().oldText;
+                toolCall.newText = toolCall.edits.first().newText;
+                qDebug() << "[ACPSession] Multi-edit from rawInput:" << rawEdits.size() << "edits";
+            }
         }
 
         // Fallback: Extract write content from rawInput for MCP tools (e.g., mcp__kate__katecode_write)
@@ -1525,189 +1557,6 @@ void ACPSession::handleFsReadTextFile(const QJsonObject &params, int requestId)
     m_service->sendResponse(requestId, result);
 }
 
-// Helper struct for tracking line changes
-struct LineChange {
-    int startLine;      // 0-based start line in old document
-    int oldLineCount;   // Number of lines to remove
-    int newLineCount;   // Number of lines to insert
-    QStringList newLines;  // The new lines to insert
-};
-
-// Compute minimal line-based changes between old and new content
-static QList<LineChange> computeLineChanges(const QStringList &oldLines, const QStringList &newLines)
-{
-    QList<LineChange> changes;
-
-    int oldSize = oldLines.size();
-    int newSize = newLines.size();
-    int i = 0, j = 0;
-
-    while (i < oldSize || j < newSize) {
-        // Find common prefix from current position
-        int commonStart = 0;
-        while (i + commonStart < oldSize && j + commonStart < newSize &&
-               oldLines[i + commonStart] == newLines[j + commonStart]) {
-            ++commonStart;
-        }
-        i += commonStart;
-        j += commonStart;
-
-        if (i >= oldSize && j >= newSize) {
-            break;  // Done
-        }
-
-        // Find common suffix from the end of remaining content
-        int oldRemaining = oldSize - i;
-        int newRemaining = newSize - j;
-        int commonEnd = 0;
-        while (commonEnd < oldRemaining && commonEnd < newRemaining &&
-               oldLines[oldSize - 1 - commonEnd] == newLines[newSize - 1 - commonEnd]) {
-            ++commonEnd;
-        }
-
-        // The change spans from current position to just before the common suffix
-        int oldChangeCount = oldRemaining - commonEnd;
-        int newChangeCount = newRemaining - commonEnd;
-
-        if (oldChangeCount > 0 || newChangeCount > 0) {
-            LineChange change;
-            change.startLine = i;
-            change.oldLineCount = oldChangeCount;
-            change.newLineCount = newChangeCount;
-            for (int k = 0; k < newChangeCount; ++k) {
-                change.newLines.append(newLines[j + k]);
-            }
-            changes.append(change);
-        }
-
-        // Move past the changed region
-        i += oldChangeCount;
-        j += newChangeCount;
-    }
-
-    return changes;
-}
-
-// Apply surgical edits to a Kate document, preserving cursor position where possible
-// Returns the list of line changes applied (empty on failure or no changes)
-static QList<LineChange> applySurgicalEdits(KTextEditor::Document *doc, const QString &newContent)
-{
-    QString oldContent = doc->text();
-
-    // If content is identical, no changes needed
-    if (oldContent == newContent) {
-        return QList<LineChange>();
-    }
-
-    // Split into lines for comparison
-    QStringList oldLines = oldContent.split(QLatin1Char('\n'));
-    QStringList newLines = newContent.split(QLatin1Char('\n'));
-
-    // Compute the changes
-    QList<LineChange> changes = computeLineChanges(oldLines, newLines);
-
-    if (changes.isEmpty()) {
-        // Content differs only in ways not captured by line comparison (shouldn't happen)
-        if (doc->setText(newContent)) {
-            // Return a single change representing the whole document
-            LineChange wholeDoc;
-            wholeDoc.startLine = 0;
-            wholeDoc.oldLineCount = oldLines.size();
-            wholeDoc.newLineCount = newLines.size();
-            return QList<LineChange>() << wholeDoc;
-        }
-        return QList<LineChange>();
-    }
-
-    // Save cursor positions from all views
-    QList<KTextEditor::View *> views = doc->views();
-    QList<KTextEditor::Cursor> savedCursors;
-    for (KTextEditor::View *view : views) {
-        savedCursors.append(view->cursorPosition());
-    }
-
-    // Start an editing transaction for undo grouping (RAII - finishes when scope exits)
-    KTextEditor::Document::EditingTransaction transaction(doc);
-
-    // Apply changes in reverse order to avoid line number shifting issues
-    for (int changeIdx = changes.size() - 1; changeIdx >= 0; --changeIdx) {
-        const LineChange &change = changes[changeIdx];
-
-        // Calculate the range to replace
-        int startLine = change.startLine;
-        int endLine = change.startLine + change.oldLineCount;
-
-        KTextEditor::Cursor startPos(startLine, 0);
-        KTextEditor::Cursor endPos;
-
-        if (endLine >= oldLines.size()) {
-            // Replacing to end of document
-            int lastLine = oldLines.size() - 1;
-            endPos = KTextEditor::Cursor(lastLine, oldLines[lastLine].length());
-        } else {
-            // Replacing up to start of next unchanged line
-            endPos = KTextEditor::Cursor(endLine, 0);
-        }
-
-        // Build replacement text
-        QString replacement = change.newLines.join(QLatin1Char('\n'));
-
-        // Add trailing newline if we're not at document end and replacing full lines
-        if (endLine < oldLines.size() && !replacement.isEmpty()) {
-            replacement += QLatin1Char('\n');
-        } else if (change.oldLineCount > 0 && endLine < oldLines.size()) {
-            // We're deleting lines that had a trailing newline
-            // The replacement should not add one if empty
-        }
-
-        // Special case: inserting new lines at document end
-        if (startLine >= oldLines.size()) {
-            startPos = KTextEditor::Cursor(oldLines.size() - 1, oldLines.last().length());
-            if (!replacement.isEmpty()) {
-                replacement = QLatin1Char('\n') + replacement;
-            }
-        }
-
-        KTextEditor::Range range(startPos, endPos);
-        doc->replaceText(range, replacement);
-
-        // Update oldLines to reflect the change for subsequent iterations
-        // (since we're going in reverse, this updates line count for earlier changes)
-        for (int r = 0; r < change.oldLineCount && startLine < oldLines.size(); ++r) {
-            oldLines.removeAt(startLine);
-        }
-        for (int a = 0; a < change.newLines.size(); ++a) {
-            oldLines.insert(startLine + a, change.newLines[a]);
-        }
-    }
-
-    // Transaction finishes automatically when 'transaction' goes out of scope
-
-    // Restore cursor positions, clamping to valid positions
-    for (int v = 0; v < views.size(); ++v) {
-        KTextEditor::Cursor savedCursor = savedCursors[v];
-        int newLine = savedCursor.line();
-
-        // Clamp to valid range
-        if (newLine >= doc->lines()) {
-            newLine = doc->lines() - 1;
-        }
-        if (newLine < 0) {
-            newLine = 0;
-        }
-
-        int newCol = savedCursor.column();
-        int lineLength = doc->lineLength(newLine);
-        if (newCol > lineLength) {
-            newCol = lineLength;
-        }
-
-        views[v]->setCursorPosition(KTextEditor::Cursor(newLine, newCol));
-    }
-
-    return changes;
-}
-
 void ACPSession::handleFsWriteTextFile(const QJsonObject &params, int requestId)
 {
     QString path = params[QStringLiteral("path")].toString();
@@ -1728,33 +1577,50 @@ void ACPSession::handleFsWriteTextFile(const QJsonObject &params, int requestId)
     // Check if this is a new file
     bool isNewFile = !QFile::exists(path);
 
-    // Try to write through Kate document if open
-    if (m_documentProvider) {
-        KTextEditor::Document *doc = m_documentProvider(path);
+    KTextEditor::Document *doc = m_documentProvider ? m_documentProvider(path) : nullptr;
+
+    // Snapshot the pre-edit content (buffer if open, since it may have unsaved changes)
+    if (m_snapshotStore) {
         if (doc) {
-            qDebug() << "[ACPSession] Writing through Kate document:" << path;
-
-            // Use surgical edits to preserve cursor position and minimize gutter markers
-            QList<LineChange> changes = applySurgicalEdits(doc, content);
-            if (!changes.isEmpty()) {
-                bool saved = doc->save();
-                if (saved) {
-                    writtenViaKate = true;
-                    qDebug() << "[ACPSession] Kate document saved successfully (surgical edit)";
-
-                    // Record edits for tracking
-                    for (const LineChange &change : changes) {
-                        m_editTracker->recordEdit(m_currentToolCallId, path,
-                                                   change.startLine, change.oldLineCount, change.newLineCount);
-                    }
-                } else {
-                    qWarning() << "[ACPSession] Failed to save Kate document, falling back to direct write";
+            m_snapshotStore->recordBefore(m_currentToolCallId, path, doc->text());
+        } else if (isNewFile) {
+            m_snapshotStore->recordBefore(m_currentToolCallId, path, QString(), true);
+        } else {
+            QFile oldFile(path);
+            if (oldFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                m_snapshotStore->recordBefore(m_currentToolCallId, path, QString::fromUtf8(oldFile.readAll()));
+            }
+        }
+    }
+
+    // Try to write through Kate document if open
+    if (doc) {
+        qDebug() << "[ACPSession] Writing through Kate document:" << path;
+
+        // Use surgical edits to preserve cursor position and minimize gutter markers
+        const QList<DocumentPatcher::LineChange> changes = DocumentPatcher::apply(doc, content);
+        if (!changes.isEmpty()) {
+            bool saved = doc->save();
+            if (saved) {
+                writtenViaKate = true;
+                qDebug() << "[ACPSession] Kate document saved successfully (surgical edit)";
+
+                // Record edits for tracking and position-based highlighting
+                const QList<EditDiff> appliedEdits = DocumentPatcher::toEditDiffs(changes, path);
+                QList<EditTracker::EditSpan> spans;
+                for (const EditDiff &edit : appliedEdits) {
+                    spans.append({edit.startLine, edit.oldLineCount, edit.newLineCount});
                 }
+                // The document already holds the whole patch, so record it in one go
+                m_editTracker->recordEdits(m_currentToolCallId, path, spans);
+                Q_EMIT toolCallEditsApplied(m_currentToolCallId, appliedEdits);
             } else {
-                // Empty changes means content was identical - no edit to track
-                writtenViaKate = true;
-                qDebug() << "[ACPSession] Kate document unchanged (identical content)";
+                qWarning() << "[ACPSession] Failed to save Kate document, falling back to direct write";
             }
+        } else {
+            // Empty changes means content was identical - no edit to track
+            writtenViaKate = true;
+            qDebug() << "[ACPSession] Kate document unchanged (identical content)";
         }
     }
 
@@ -1797,6 +1663,10 @@ void ACPSession::handleFsWriteTextFile(const QJsonObject &params, int requestId)
         }
     }
 
+    if (m_snapshotStore) {
+        m_snapshotStore->recordAfter(m_currentToolCallId, path, content);
+    }
+
     QJsonObject result;
     result[QStringLiteral("result")] = QJsonValue::Null;
     m_service->sendResponse(requestId, result);
@@ -3,6 +3,8 @@
 #include "ACPModels.h"
 #include <QJsonArray>
 #include <QObject>
+#include <QPointer>
+#include <QSet>
 #include <QString>
 #include <functional>
 
@@ -12,6 +14,7 @@ class Document;
 
 class ACPService;
 class EditTracker;
+class SnapshotStore;
 class TerminalManager;
 class TranscriptWriter;
 
@@ -39,6 +42,8 @@ public:
     bool isPromptRunning() const { return m_promptRequestId >= 0; }
     ConnectionStatus status() const { return m_status; }
     QString sessionId() const { return m_sessionId; }
+    // Whether the agent announced this tool call in the current session
+    bool hasToolCall(const QString &toolCallId) const { return m_toolCallInputs.contains(toolCallId); }
 
     void cancelPrompt();
     QJsonArray availableModes() const { return m_availableModes; }
@@ -55,6 +60,9 @@ public:
     // Edit tracker for tracking file modifications
     EditTracker *editTracker() const { return m_editTracker; }
 
+    // Snapshot store for pre/post-edit file versions (shared, owned by the plugin)
+    void setSnapshotStore(SnapshotStore *store);
+
 Q_SIGNALS:
     void statusChanged(ConnectionStatus status);
     void messageAdded(const Message &message);
@@ -62,6 +70,8 @@ Q_SIGNALS:
     void messageFinished(const QString &messageId);
     void toolCallAdded(const QString &messageId, const ToolCall &toolCall);
     void toolCallUpdated(const QString &messageId, const QString &toolCallId, const QString &status, const QString &result, const QString &filePath = QString(), const QString &toolName = QString());
+    // Edits written through an open document, with their post-edit line positions
+    void toolCallEditsApplied(const QString &toolCallId, const QList<EditDiff> &edits);
     void todosUpdated(const QList<TodoItem> &todos);
     void permissionRequested(const PermissionRequest &request);
     void modesAvailable(const QJsonArray &modes);
@@ -108,6 +118,9 @@ private:
     void handleFsReadTextFile(const QJsonObject &params, int requestId);
     void handleFsWriteTextFile(const QJsonObject &params, int requestId);
 
+    // Drop this session's tool calls from the shared snapshot store
+    void releaseSnapshots();
+
     ACPService *m_service;
     TerminalManager *m_terminalManager;
     TranscriptWriter *m_transcript;
@@ -137,6 +150,10 @@ private:
     // Edit tracker
     EditTracker *m_editTracker;
 
+    // Snapshot store (not owned, shared with other views)
+    QPointer<SnapshotStore> m_snapshotStore;
+    QSet<QString> m_snapshotToolCallIds;  // Tool calls of this session it may hold versions for
+
     // Current tool call ID for edit tracking
     QString m_currentToolCallId;
 };
\ No newline at end of file
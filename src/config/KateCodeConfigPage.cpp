@@ -16,6 +16,7 @@
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QSpinBox>
 #include <QTabWidget>
 #include <QTableWidget>
 #include <QVBoxLayout>
@@ -161,6 +162,47 @@ void KateCodeConfigPage::setupGeneralTab(QWidget *tab)
 
     tabLayout->addWidget(diffGroup);
 
+    // Edit Snapshots Group
+    auto *snapshotGroup = new QGroupBox(i18n("Edit Snapshots"), tab);
+    auto *snapshotLayout = new QFormLayout(snapshotGroup);
+
+    m_snapshotMemorySpin = new QSpinBox(tab);
+    m_snapshotMemorySpin->setRange(0, 4096);
+    m_snapshotMemorySpin->setSuffix(i18n(" MB"));
+    connect(m_snapshotMemorySpin, &QSpinBox::valueChanged,
+            this, &KateCodeConfigPage::onSettingChanged);
+    snapshotLayout->addRow(i18n("Memory budget:"), m_snapshotMemorySpin);
+
+    m_snapshotDiskSpin = new QSpinBox(tab);
+    m_snapshotDiskSpin->setRange(0, 65536);
+    m_snapshotDiskSpin->setSuffix(i18n(" MB"));
+    connect(m_snapshotDiskSpin, &QSpinBox::valueChanged,
+            this, &KateCodeConfigPage::onSettingChanged);
+    snapshotLayout->addRow(i18n("Disk budget:"), m_snapshotDiskSpin);
+
+    auto *snapshotNote = new QLabel(i18n("File contents before and after each agent edit are kept compressed for reverting and diffing. Snapshots over the memory budget are moved to ~/.kate-code/snapshots/; the oldest are dropped once the disk budget is exceeded."), tab);
+    snapshotNote->setWordWrap(true);
+    snapshotNote->setStyleSheet(QStringLiteral("color: gray; font-size: small;"));
+    snapshotLayout->addRow(snapshotNote);
+
+    tabLayout->addWidget(snapshotGroup);
+
+    // Agent Edits Group
+    auto *agentEditsGroup = new QGroupBox(i18n("Agent Edits"), tab);
+    auto *agentEditsLayout = new QVBoxLayout(agentEditsGroup);
+
+    m_openEditedFilesCheck = new QCheckBox(i18n("Open files in Kate when the agent edits them"), tab);
+    connect(m_openEditedFilesCheck, &QCheckBox::toggled,
+            this, &KateCodeConfigPage::onSettingChanged);
+    agentEditsLayout->addWidget(m_openEditedFilesCheck);
+
+    auto *agentEditsNote = new QLabel(i18n("When disabled, files that are not already open are edited directly on disk without creating a tab. Files that are open are always edited in their buffer."), tab);
+    agentEditsNote->setWordWrap(true);
+    agentEditsNote->setStyleSheet(QStringLiteral("color: gray; font-size: small;"));
+    agentEditsLayout->addWidget(agentEditsNote);
+
+    tabLayout->addWidget(agentEditsGroup);
+
     // Debugging Group
     auto *debugGroup = new QGroupBox(i18n("Debugging"), tab);
     auto *debugLayout = new QVBoxLayout(debugGroup);
@@ -297,6 +339,9 @@ void KateCodeConfigPage::apply()
     m_settings->setSummaryModel(m_summaryModelCombo->currentData().toString());
     m_settings->setAutoResumeSessions(m_autoResumeCheck->isChecked());
     m_settings->setDiffColorScheme(static_cast<DiffColorScheme>(m_diffColorSchemeCombo->currentData().toInt()));
+    m_settings->setSnapshotMemoryBudgetMB(m_snapshotMemorySpin->value());
+    m_settings->setSnapshotDiskBudgetMB(m_snapshotDiskSpin->value());
+    m_settings->setOpenEditedFiles(m_openEditedFilesCheck->isChecked());
     m_settings->setDebugLogging(m_debugLoggingCheck->isChecked());
 
     m_hasChanges = false;
@@ -309,6 +354,9 @@ void KateCodeConfigPage::defaults()
     m_summaryModelCombo->setCurrentIndex(0);
     m_autoResumeCheck->setChecked(true);
     m_diffColorSchemeCombo->setCurrentIndex(0); // RedGreen (default)
+    m_snapshotMemorySpin->setValue(64);
+    m_snapshotDiskSpin->setValue(512);
+    m_openEditedFilesCheck->setChecked(false);
     m_debugLoggingCheck->setChecked(false);
     m_hasChanges = true;
     Q_EMIT changed();
@@ -333,6 +381,11 @@ void KateCodeConfigPage::reset()
         m_diffColorSchemeCombo->setCurrentIndex(schemeIndex);
     }
 
+    // Load snapshot budgets
+    m_snapshotMemorySpin->setValue(m_settings->snapshotMemoryBudgetMB());
+    m_snapshotDiskSpin->setValue(m_settings->snapshotDiskBudgetMB());
+    m_openEditedFilesCheck->setChecked(m_settings->openEditedFiles());
+
     // Load debug setting
     m_debugLoggingCheck->setChecked(m_settings->debugLogging());
 
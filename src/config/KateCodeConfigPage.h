@@ -8,6 +8,7 @@ class QCheckBox;
 class QComboBox;
 class QPushButton;
 class QLabel;
+class QSpinBox;
 class QTabWidget;
 class QTableWidget;
 
@@ -73,6 +74,13 @@ private:
     // Summaries tab - Session resume
     QCheckBox *m_autoResumeCheck;
 
+    // General tab - Edit snapshots section
+    QSpinBox *m_snapshotMemorySpin;
+    QSpinBox *m_snapshotDiskSpin;
+
+    // General tab - Agent edits section
+    QCheckBox *m_openEditedFilesCheck;
+
     // General tab - Debug section
     QCheckBox *m_debugLoggingCheck;
 
@@ -416,6 +416,42 @@ void SettingsStore::setDebugLogging(bool enable)
     Q_EMIT settingsChanged();
 }
 
+int SettingsStore::snapshotMemoryBudgetMB() const
+{
+    return m_settings.value(QStringLiteral("Snapshots/memoryBudgetMB"), 64).toInt();
+}
+
+void SettingsStore::setSnapshotMemoryBudgetMB(int megabytes)
+{
+    m_settings.setValue(QStringLiteral("Snapshots/memoryBudgetMB"), megabytes);
+    m_settings.sync();
+    Q_EMIT settingsChanged();
+}
+
+int SettingsStore::snapshotDiskBudgetMB() const
+{
+    return m_settings.value(QStringLiteral("Snapshots/diskBudgetMB"), 512).toInt();
+}
+
+void SettingsStore::setSnapshotDiskBudgetMB(int megabytes)
+{
+    m_settings.setValue(QStringLiteral("Snapshots/diskBudgetMB"), megabytes);
+    m_settings.sync();
+    Q_EMIT settingsChanged();
+}
+
+bool SettingsStore::openEditedFiles() const
+{
+    return m_settings.value(QStringLiteral("Editing/openEditedFiles"), false).toBool();
+}
+
+void SettingsStore::setOpenEditedFiles(bool enable)
+{
+    m_settings.setValue(QStringLiteral("Editing/openEditedFiles"), enable);
+    m_settings.sync();
+    Q_EMIT settingsChanged();
+}
+
 DiffColorScheme SettingsStore::diffColorScheme() const
 {
     int scheme = m_settings.value(QStringLiteral("Diffs/colorScheme"), 0).toInt();
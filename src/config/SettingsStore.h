@@ -78,6 +78,16 @@ public:
     bool debugLogging() const;
     void setDebugLogging(bool enable);
 
+    // Edit snapshot budgets (in MB of compressed data)
+    int snapshotMemoryBudgetMB() const;
+    void setSnapshotMemoryBudgetMB(int megabytes);
+    int snapshotDiskBudgetMB() const;
+    void setSnapshotDiskBudgetMB(int megabytes);
+
+    // Open files in Kate when the agent edits them via MCP (default: edit on disk)
+    bool openEditedFiles() const;
+    void setOpenEditedFiles(bool enable);
+
     // Diff color scheme settings
     DiffColorScheme diffColorScheme() const;
     void setDiffColorScheme(DiffColorScheme scheme);
@@ -4,6 +4,12 @@
 */
 
 #include "EditorDBusService.h"
+#include "EditorSocketServer.h"
+#include "../util/DocumentIndex.h"
+#include "../util/DocumentPatcher.h"
+#include "../util/DocumentRevisionTracker.h"
+#include "../util/SnapshotStore.h"
+#include "katecode_editor_adaptor.h"
 
 #include <KTextEditor/Application>
 #include <KTextEditor/Document>
@@ -14,13 +20,24 @@
 #include <QDBusConnection>
 #include <QDBusError>
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStringDecoder>
+#include <QStringEncoder>
 #include <QTimer>
 #include <QUrl>
 
 EditorDBusService::EditorDBusService(QObject *parent)
     : QObject(parent)
+    , m_revisionTracker(new DocumentRevisionTracker(this))
+    , m_socketServer(new EditorSocketServer(this, this))
 {
+    new EditorAdaptor(this);
 }
 
 bool EditorDBusService::registerOnBus()
@@ -32,15 +49,23 @@ bool EditorDBusService::registerOnBus()
         return false;
     }
 
-    if (!bus.registerObject(QStringLiteral("/KateCode/Editor"), this, QDBusConnection::ExportAllSlots)) {
+    if (!bus.registerObject(QStringLiteral("/KateCode/Editor"), this, QDBusConnection::ExportAdaptors)) {
         qWarning() << "[KateCode] Failed to register DBus object:" << bus.lastError().message();
         return false;
     }
 
     qDebug() << "[KateCode] DBus service registered: org.kde.katecode.editor";
+
+    // Bulk transfers are optional - clients fall back to DBus without the socket
+    m_socketServer->listen();
     return true;
 }
 
+QString EditorDBusService::socketPath()
+{
+    return m_socketServer->socketPath();
+}
+
 QStringList EditorDBusService::listDocuments()
 {
     QStringList result;
@@ -64,6 +89,15 @@ QStringList EditorDBusService::listDocuments()
     return result;
 }
 
+KTextEditor::Document *EditorDBusService::findDocument(const QString &filePath) const
+{
+    if (m_documentIndex) {
+        return m_documentIndex->find(filePath);
+    }
+    KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
+    return app ? app->findUrl(QUrl::fromLocalFile(filePath)) : nullptr;
+}
+
 QString EditorDBusService::readDocument(const QString &filePath)
 {
     KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
@@ -71,9 +105,7 @@ QString EditorDBusService::readDocument(const QString &filePath)
         return QStringLiteral("ERROR: KTextEditor application not available");
     }
 
-    // Find existing document by URL
-    QUrl url = QUrl::fromLocalFile(filePath);
-    KTextEditor::Document *doc = app->findUrl(url);
+    KTextEditor::Document *doc = findDocument(filePath);
 
     if (doc) {
         // Document is open — return its content
@@ -91,17 +123,222 @@ QString EditorDBusService::readDocument(const QString &filePath)
     return QString::fromUtf8(file.readAll());
 }
 
-QString EditorDBusService::editDocument(const QString &filePath, const QString &oldText, const QString &newText)
+QString EditorDBusService::readDocumentRange(const QString &filePath, int offset, int limit)
 {
     KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
     if (!app) {
         return QStringLiteral("ERROR: KTextEditor application not available");
     }
 
-    QUrl url = QUrl::fromLocalFile(filePath);
-    KTextEditor::Document *doc = app->findUrl(url);
+    int start = qMax(0, offset - 1);
+    limit = qMax(0, limit);
+
+    QJsonObject result;
+    QJsonArray linesArray;
+    KTextEditor::Document *doc = findDocument(filePath);
+
+    if (doc) {
+        m_revisionTracker->track(doc);
+
+        const int totalLines = doc->lines();
+        if (start >= totalLines) {
+            start = qMax(0, totalLines - 1);
+        }
+        const int end = qMin(start + limit, totalLines);
+        for (int line = start; line < end; ++line) {
+            linesArray.append(doc->line(line));
+        }
+
+        result[QStringLiteral("revision")] = doc->revision();
+        result[QStringLiteral("totalLines")] = totalLines;
+    } else {
+        QString errorMessage;
+        const int totalLines = m_lineIndex.lineCount(filePath, &errorMessage);
+        if (totalLines < 0) {
+            return QStringLiteral("ERROR: %1").arg(errorMessage);
+        }
+        if (start >= totalLines) {
+            start = qMax(0, totalLines - 1);
+        }
+
+        QStringList lines;
+        int indexedLines = 0;
+        if (!m_lineIndex.readLines(filePath, start, limit, &lines, &indexedLines, &errorMessage)) {
+            return QStringLiteral("ERROR: %1").arg(errorMessage);
+        }
+        for (const QString &line : std::as_const(lines)) {
+            linesArray.append(line);
+        }
+
+        result[QStringLiteral("revision")] = -1;
+        result[QStringLiteral("totalLines")] = indexedLines;
+    }
+
+    result[QStringLiteral("start")] = start + 1;
+    result[QStringLiteral("lines")] = linesArray;
+
+    return QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact));
+}
+
+QString EditorDBusService::readDocumentDelta(const QString &filePath, qlonglong sinceRevision)
+{
+    KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
+    if (!app) {
+        return QStringLiteral("ERROR: KTextEditor application not available");
+    }
+
+    QJsonObject result;
+    KTextEditor::Document *doc = findDocument(filePath);
 
     if (!doc) {
+        // Not open — no revision to diff against
+        QString errorMessage;
+        const int totalLines = m_lineIndex.lineCount(filePath, &errorMessage);
+        if (totalLines < 0) {
+            return QStringLiteral("ERROR: %1").arg(errorMessage);
+        }
+        result[QStringLiteral("status")] = QStringLiteral("full");
+        result[QStringLiteral("revision")] = -1;
+        result[QStringLiteral("totalLines")] = totalLines;
+        return QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact));
+    }
+
+    // A revision can only be diffed if tracking started before the caller saw it
+    const bool wasTracked = m_revisionTracker->isTracked(doc);
+    m_revisionTracker->track(doc);
+
+    const qint64 revision = doc->revision();
+    result[QStringLiteral("revision")] = revision;
+    result[QStringLiteral("totalLines")] = doc->lines();
+
+    QList<DocumentRevisionTracker::Hunk> hunks;
+    if (sinceRevision >= 0 && wasTracked && m_revisionTracker->changedHunksSince(doc, sinceRevision, &hunks)) {
+        if (hunks.isEmpty()) {
+            result[QStringLiteral("status")] = QStringLiteral("unchanged");
+        } else {
+            // Old spans let the caller splice new lines into its earlier copy
+            QJsonArray hunksArray;
+            for (const DocumentRevisionTracker::Hunk &hunk : std::as_const(hunks)) {
+                QJsonArray lines;
+                for (int line = hunk.newStart; line < hunk.newStart + hunk.newCount; ++line) {
+                    lines.append(doc->line(line));
+                }
+                QJsonObject hunkObj;
+                hunkObj[QStringLiteral("oldStart")] = hunk.oldStart;
+                hunkObj[QStringLiteral("oldCount")] = hunk.oldCount;
+                hunkObj[QStringLiteral("newStart")] = hunk.newStart;
+                hunkObj[QStringLiteral("lines")] = lines;
+                hunksArray.append(hunkObj);
+            }
+            result[QStringLiteral("status")] = QStringLiteral("delta");
+            result[QStringLiteral("hunks")] = hunksArray;
+        }
+    } else {
+        result[QStringLiteral("status")] = QStringLiteral("full");
+    }
+
+    return QString::fromUtf8(QJsonDocument(result).toJson(QJsonDocument::Compact));
+}
+
+QString EditorDBusService::editDocument(const QString &filePath, const QString &oldText, const QString &newText,
+                                        const QString &toolCallId)
+{
+    return applyEdits(filePath, {oldText}, {newText}, toolCallId);
+}
+
+QString EditorDBusService::multiEditDocument(const QString &filePath, const QStringList &oldTexts, const QStringList &newTexts,
+                                             const QString &toolCallId)
+{
+    if (oldTexts.isEmpty()) {
+        return QStringLiteral("ERROR: No edits given");
+    }
+    if (oldTexts.size() != newTexts.size()) {
+        return QStringLiteral("ERROR: old_text and new_text lists differ in length");
+    }
+    return applyEdits(filePath, oldTexts, newTexts, toolCallId);
+}
+
+// Encoding and line endings of a file edited on disk, kept when writing it back
+struct FileFormat {
+    QStringConverter::Encoding encoding = QStringConverter::Utf8;
+    bool bom = false;
+    bool crlf = false;
+};
+
+// Headless I/O for files that are not open in Kate. Content is handed out
+// with "\n" line endings, like KTextEditor::Document::text().
+static bool readFileText(const QString &filePath, QString *content, FileFormat *format, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QStringLiteral("ERROR: Cannot open file: %1").arg(file.errorString());
+        return false;
+    }
+    const QByteArray data = file.readAll();
+
+    // A BOM names the encoding; anything else has to be valid UTF-8, since
+    // guessing a legacy encoding wrong would garble the file on write
+    *format = FileFormat();
+    if (const auto encoding = QStringConverter::encodingForData(data)) {
+        format->encoding = *encoding;
+    }
+    // Keep a leading BOM in the decoded text so the write can put it back
+    QStringDecoder decoder(format->encoding, QStringConverter::Flag::ConvertInitialBom);
+    *content = decoder.decode(data);
+    if (decoder.hasError()) {
+        *error = QStringLiteral("ERROR: %1 is not UTF-8 encoded; open it in Kate to edit it").arg(filePath);
+        return false;
+    }
+    if (content->startsWith(QChar(0xFEFF))) {
+        content->remove(0, 1);
+        format->bom = true;
+    }
+
+    format->crlf = content->contains(QStringLiteral("\r\n"));
+    if (format->crlf) {
+        content->replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+    }
+    return true;
+}
+
+static bool writeFileText(const QString &filePath, const QString &content, const FileFormat &format, QString *error)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QString text = content;
+    if (format.crlf) {
+        text.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+        text.replace(QStringLiteral("\n"), QStringLiteral("\r\n"));
+    }
+    QStringEncoder encoder(format.encoding, format.bom ? QStringConverter::Flag::WriteBom : QStringConverter::Flag::Default);
+    const QByteArray data = encoder.encode(text);
+
+    // QSaveFile replaces the file atomically, so a failed write leaves it intact
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = QStringLiteral("ERROR: Cannot write file: %1").arg(file.errorString());
+        return false;
+    }
+    file.write(data);
+    if (!file.commit()) {
+        *error = QStringLiteral("ERROR: Cannot write file: %1").arg(file.errorString());
+        return false;
+    }
+    return true;
+}
+
+QString EditorDBusService::applyEdits(const QString &filePath, const QStringList &oldTexts, const QStringList &newTexts,
+                                      const QString &toolCallId)
+{
+    KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
+    if (!app) {
+        return QStringLiteral("ERROR: KTextEditor application not available");
+    }
+
+    QUrl url = QUrl::fromLocalFile(filePath);
+    KTextEditor::Document *doc = findDocument(filePath);
+
+    if (!doc && m_openEditedFiles) {
         // Try to open the document
         KTextEditor::MainWindow *mainWindow = app->activeMainWindow();
         if (!mainWindow) {
@@ -114,39 +351,97 @@ QString EditorDBusService::editDocument(const QString &filePath, const QString &
         doc = view->document();
     }
 
-    // Find and replace the text
-    QString content = doc->text();
-    int pos = content.indexOf(oldText);
-    if (pos < 0) {
-        return QStringLiteral("ERROR: old_text not found in document");
+    // Not open in Kate - edit on disk without creating a view or tab
+    QString original;
+    FileFormat format;
+    if (doc) {
+        original = doc->text();
+    } else {
+        QString error;
+        if (!readFileText(filePath, &original, &format, &error)) {
+            return error;
+        }
     }
 
-    // Check for uniqueness
-    int secondPos = content.indexOf(oldText, pos + 1);
-    if (secondPos >= 0) {
-        return QStringLiteral("ERROR: old_text is not unique in document (found at multiple positions)");
+    // Validate every edit against one snapshot before touching the document.
+    // Edits apply in order, so each is matched against the result of the previous ones.
+    struct Replacement {
+        KTextEditor::Range range;
+        QString newText;
+    };
+    QList<Replacement> replacements;
+
+    QString content = original;
+    const bool multiple = oldTexts.size() > 1;
+
+    for (int i = 0; i < oldTexts.size(); ++i) {
+        const QString &oldText = oldTexts[i];
+        const QString prefix = multiple ? QStringLiteral("ERROR: edit %1: ").arg(i + 1) : QStringLiteral("ERROR: ");
+
+        if (oldText.isEmpty()) {
+            return prefix + QStringLiteral("old_text is empty");
+        }
+
+        // Find and replace the text
+        int pos = content.indexOf(oldText);
+        if (pos < 0) {
+            return prefix + QStringLiteral("old_text not found in document");
+        }
+
+        // Check for uniqueness
+        int secondPos = content.indexOf(oldText, pos + 1);
+        if (secondPos >= 0) {
+            return prefix + QStringLiteral("old_text is not unique in document (found at multiple positions)");
+        }
+
+        // Calculate line/column for the replacement
+        int startLine = content.left(pos).count(QLatin1Char('\n'));
+        int startCol = pos - content.lastIndexOf(QLatin1Char('\n'), pos) - 1;
+        if (startCol < 0) {
+            startCol = pos;
+        }
+
+        int endPos = pos + oldText.length();
+        int endLine = content.left(endPos).count(QLatin1Char('\n'));
+        int endCol = endPos - content.lastIndexOf(QLatin1Char('\n'), endPos - 1) - 1;
+        if (endCol < 0) {
+            endCol = endPos;
+        }
+
+        replacements.append({KTextEditor::Range(startLine, startCol, endLine, endCol), newTexts[i]});
+        content.replace(pos, oldText.length(), newTexts[i]);
     }
 
-    // Calculate line/column for the replacement
-    int startLine = content.left(pos).count(QLatin1Char('\n'));
-    int startCol = pos - content.lastIndexOf(QLatin1Char('\n'), pos) - 1;
-    if (startCol < 0) {
-        startCol = pos;
+    if (m_snapshotStore) {
+        m_snapshotStore->recordBefore(toolCallId, filePath, original);
     }
 
-    int endPos = pos + oldText.length();
-    int endLine = content.left(endPos).count(QLatin1Char('\n'));
-    int endCol = endPos - content.lastIndexOf(QLatin1Char('\n'), endPos - 1) - 1;
-    if (endCol < 0) {
-        endCol = endPos;
+    if (!doc) {
+        QString error;
+        if (!writeFileText(filePath, content, format, &error)) {
+            return error;
+        }
+        if (m_snapshotStore) {
+            m_snapshotStore->recordAfter(toolCallId, filePath, content);
+        }
+        return QStringLiteral("OK");
     }
 
-    // Perform the replacement
-    KTextEditor::Range range(startLine, startCol, endLine, endCol);
-    bool success = doc->replaceText(range, newText);
+    // Perform all replacements as one undo step
+    {
+        KTextEditor::Document::EditingTransaction transaction(doc);
+        for (const Replacement &replacement : std::as_const(replacements)) {
+            if (!doc->replaceText(replacement.range, replacement.newText)) {
+                // Roll back what was applied so the edit stays all-or-nothing
+                doc->setText(original);
+                return QStringLiteral("ERROR: Failed to replace text");
+            }
+        }
+    }
 
-    if (!success) {
-        return QStringLiteral("ERROR: Failed to replace text");
+    const QString edited = doc->text();
+    if (m_snapshotStore) {
+        m_snapshotStore->recordAfter(toolCallId, filePath, edited);
     }
 
     // Auto-save the document
@@ -154,10 +449,16 @@ QString EditorDBusService::editDocument(const QString &filePath, const QString &
         return QStringLiteral("ERROR: Edit succeeded but failed to save document");
     }
 
+    // Replacements are ranges within earlier edits' results; a line diff of
+    // the whole edit gives positions in the saved document directly
+    const QList<DocumentPatcher::LineChange> changes =
+        DocumentPatcher::computeLineChanges(original.split(QLatin1Char('\n')), edited.split(QLatin1Char('\n')));
+    Q_EMIT editsApplied(toolCallId, DocumentPatcher::toEditDiffs(changes, filePath));
+
     return QStringLiteral("OK");
 }
 
-QString EditorDBusService::writeDocument(const QString &filePath, const QString &content)
+QString EditorDBusService::writeDocument(const QString &filePath, const QString &content, const QString &toolCallId)
 {
     KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
     if (!app) {
@@ -165,14 +466,44 @@ QString EditorDBusService::writeDocument(const QString &filePath, const QString
     }
 
     QUrl url = QUrl::fromLocalFile(filePath);
-    KTextEditor::Document *doc = app->findUrl(url);
+    KTextEditor::Document *doc = findDocument(filePath);
 
     if (doc) {
-        // Document is open — replace its content and save
-        doc->setText(content);
+        // Document is open — patch only the changed lines and save
+        if (m_snapshotStore) {
+            m_snapshotStore->recordBefore(toolCallId, filePath, doc->text());
+            m_snapshotStore->recordAfter(toolCallId, filePath, content);
+        }
+        const QList<DocumentPatcher::LineChange> changes = DocumentPatcher::apply(doc, content);
         if (!doc->save()) {
             return QStringLiteral("ERROR: Write succeeded but failed to save document");
         }
+        Q_EMIT editsApplied(toolCallId, DocumentPatcher::toEditDiffs(changes, filePath));
+        return QStringLiteral("OK");
+    }
+
+    // Check if file exists
+    QFile file(filePath);
+    bool fileExists = file.exists();
+
+    if (!m_openEditedFiles) {
+        // Document not open — write on disk without creating a view or tab
+        // An existing file keeps its encoding and line endings
+        QString before;
+        FileFormat format;
+        QString error;
+        if (fileExists && !readFileText(filePath, &before, &format, &error)) {
+            return error;
+        }
+        if (m_snapshotStore) {
+            m_snapshotStore->recordBefore(toolCallId, filePath, before, !fileExists);
+        }
+        if (!writeFileText(filePath, content, format, &error)) {
+            return error;
+        }
+        if (m_snapshotStore) {
+            m_snapshotStore->recordAfter(toolCallId, filePath, content);
+        }
         return QStringLiteral("OK");
     }
 
@@ -182,22 +513,27 @@ QString EditorDBusService::writeDocument(const QString &filePath, const QString
         return QStringLiteral("ERROR: No active main window");
     }
 
-    // Check if file exists
-    QFile file(filePath);
-    bool fileExists = file.exists();
-
     if (fileExists) {
         // Open existing file
         KTextEditor::View *view = mainWindow->openUrl(url);
         if (!view) {
             return QStringLiteral("ERROR: Could not open document: %1").arg(filePath);
         }
-        view->document()->setText(content);
+        if (m_snapshotStore) {
+            m_snapshotStore->recordBefore(toolCallId, filePath, view->document()->text());
+            m_snapshotStore->recordAfter(toolCallId, filePath, content);
+        }
+        const QList<DocumentPatcher::LineChange> changes = DocumentPatcher::apply(view->document(), content);
         if (!view->document()->save()) {
             return QStringLiteral("ERROR: Write succeeded but failed to save document");
         }
+        Q_EMIT editsApplied(toolCallId, DocumentPatcher::toEditDiffs(changes, filePath));
     } else {
         // Create new document with content, then save to path
+        if (m_snapshotStore) {
+            m_snapshotStore->recordBefore(toolCallId, filePath, QString(), true);
+            m_snapshotStore->recordAfter(toolCallId, filePath, content);
+        }
         KTextEditor::View *view = mainWindow->openUrl(QUrl());
         if (!view) {
             return QStringLiteral("ERROR: Could not create new document");
@@ -206,13 +542,69 @@ QString EditorDBusService::writeDocument(const QString &filePath, const QString
         if (!view->document()->saveAs(url)) {
             return QStringLiteral("ERROR: Could not save document to: %1").arg(filePath);
         }
+        const QStringList lines = content.split(QLatin1Char('\n'));
+        const QList<DocumentPatcher::LineChange> changes = {{0, 0, int(lines.size()), lines}};
+        Q_EMIT editsApplied(toolCallId, DocumentPatcher::toEditDiffs(changes, filePath));
+    }
+
+    return QStringLiteral("OK");
+}
+
+QString EditorDBusService::revertToOriginal(const QString &filePath)
+{
+    bool ok = false;
+    bool isNewFile = false;
+    const QString original = m_snapshotStore ? m_snapshotStore->originalContent(filePath, &ok, &isNewFile) : QString();
+    if (!ok) {
+        return QStringLiteral("ERROR: No original version of %1 is kept").arg(filePath);
+    }
+
+    KTextEditor::Document *doc = findDocument(filePath);
+
+    if (isNewFile) {
+        // The agent created the file, so its original state is not existing
+        if (doc) {
+            KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
+            if (!app || !app->closeDocument(doc)) {
+                return QStringLiteral("ERROR: Could not close %1").arg(filePath);
+            }
+        }
+        if (QFile::exists(filePath) && !QFile::remove(filePath)) {
+            return QStringLiteral("ERROR: Could not delete %1").arg(filePath);
+        }
+        qDebug() << "[EditorDBusService] Reverted new file by deleting it:" << filePath;
+        return QStringLiteral("OK");
     }
 
+    if (doc) {
+        // One undo step the user can take back
+        DocumentPatcher::apply(doc, original);
+        if (!doc->save()) {
+            return QStringLiteral("ERROR: Reverted %1 but failed to save it").arg(filePath);
+        }
+    } else {
+        // Keep whatever encoding and line endings the file has now
+        QString current;
+        FileFormat format;
+        QString error;
+        if (QFile::exists(filePath) && !readFileText(filePath, &current, &format, &error)) {
+            return error;
+        }
+        if (!writeFileText(filePath, original, format, &error)) {
+            return error;
+        }
+    }
+
+    qDebug() << "[EditorDBusService] Reverted to original:" << filePath;
     return QStringLiteral("OK");
 }
 
-QString EditorDBusService::askUserQuestion(const QString &questionsJson)
+QString EditorDBusService::askUserQuestion(const QString &questionsJson, const QString &cancelKey)
 {
+    if (!calledFromDBus()) {
+        return QStringLiteral("ERROR: askUserQuestion is only available over DBus");
+    }
+
     // Generate unique request ID
     QString requestId = QStringLiteral("q_%1_%2")
         .arg(QCoreApplication::applicationPid())
@@ -220,64 +612,71 @@ QString EditorDBusService::askUserQuestion(const QString &questionsJson)
 
     qDebug() << "[EditorDBusService] askUserQuestion called, requestId:" << requestId;
 
-    // Create event loop for blocking
-    QEventLoop eventLoop;
+    // Answer later from provideQuestionResponse or the timeout, without blocking
+    setDelayedReply(true);
 
-    m_pendingQuestions[requestId] = PendingQuestion{
-        &eventLoop,
-        QString(),
-        false
-    };
+    // Set up timeout (5 minutes)
+    auto *timeoutTimer = new QTimer(this);
+    timeoutTimer->setSingleShot(true);
+    connect(timeoutTimer, &QTimer::timeout, this, [this, requestId]() {
+        qDebug() << "[EditorDBusService] Question timed out:" << requestId;
+        finishQuestion(requestId, QStringLiteral("ERROR: Question timeout or cancelled"));
+        // Notify UI to remove the question prompt
+        Q_EMIT questionCancelled(requestId);
+    });
+    timeoutTimer->start(300000);
+
+    m_pendingQuestions.insert(requestId, PendingQuestion{message(), cancelKey, timeoutTimer});
 
     // Emit signal to Kate plugin UI
     Q_EMIT questionRequested(requestId, questionsJson);
 
-    // Set up timeout (5 minutes)
-    QTimer timeoutTimer;
-    timeoutTimer.setSingleShot(true);
-    connect(&timeoutTimer, &QTimer::timeout, &eventLoop, &QEventLoop::quit);
-    timeoutTimer.start(300000);
+    // Ignored - the reply is sent by finishQuestion()
+    return QString();
+}
 
-    qDebug() << "[EditorDBusService] Blocking on event loop for user response...";
+void EditorDBusService::provideQuestionResponse(const QString &requestId, const QString &responseJson)
+{
+    qDebug() << "[EditorDBusService] provideQuestionResponse called, requestId:" << requestId;
 
-    // Block until response or timeout
-    eventLoop.exec();
+    if (m_pendingQuestions.contains(requestId)) {
+        qDebug() << "[EditorDBusService] Got user response:" << responseJson;
+        finishQuestion(requestId, responseJson);
+    } else {
+        qWarning() << "[EditorDBusService] No pending question found for requestId:" << requestId;
+    }
+}
 
-    timeoutTimer.stop();
+void EditorDBusService::cancelQuestion(const QString &cancelKey)
+{
+    if (!calledFromDBus()) {
+        return;
+    }
 
-    // Retrieve response
-    QString response;
-    if (m_pendingQuestions.contains(requestId)) {
-        PendingQuestion pending = m_pendingQuestions.take(requestId);
-        if (pending.completed) {
-            response = pending.response;
-            qDebug() << "[EditorDBusService] Got user response:" << response;
-        } else {
-            response = QStringLiteral("ERROR: Question timeout or cancelled");
-            qDebug() << "[EditorDBusService] Question timed out or was cancelled";
-            // Notify UI to remove the question prompt
+    // Keys are only unique per client, so match the caller's bus name too
+    const QString caller = message().service();
+    for (auto it = m_pendingQuestions.cbegin(); it != m_pendingQuestions.cend(); ++it) {
+        if (it->cancelKey == cancelKey && it->message.service() == caller) {
+            const QString requestId = it.key();
+            qDebug() << "[EditorDBusService] Question cancelled by client:" << requestId;
+            finishQuestion(requestId, QStringLiteral("ERROR: Question cancelled"));
             Q_EMIT questionCancelled(requestId);
+            return;
         }
-    } else {
-        response = QStringLiteral("ERROR: Request not found");
     }
-
-    return response;
 }
 
-void EditorDBusService::provideQuestionResponse(const QString &requestId, const QString &responseJson)
+void EditorDBusService::finishQuestion(const QString &requestId, const QString &response)
 {
-    qDebug() << "[EditorDBusService] provideQuestionResponse called, requestId:" << requestId;
+    auto it = m_pendingQuestions.find(requestId);
+    if (it == m_pendingQuestions.end()) {
+        return;
+    }
+    const PendingQuestion pending = it.value();
+    m_pendingQuestions.erase(it);
 
-    if (m_pendingQuestions.contains(requestId)) {
-        m_pendingQuestions[requestId].response = responseJson;
-        m_pendingQuestions[requestId].completed = true;
+    pending.timeoutTimer->stop();
+    pending.timeoutTimer->deleteLater();
 
-        // Wake up the waiting event loop
-        if (m_pendingQuestions[requestId].eventLoop) {
-            m_pendingQuestions[requestId].eventLoop->quit();
-        }
-    } else {
-        qWarning() << "[EditorDBusService] No pending question found for requestId:" << requestId;
-    }
+    QDBusConnection::sessionBus().send(pending.message.createReply(response));
 }
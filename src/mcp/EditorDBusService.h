@@ -5,15 +5,28 @@
 
 #pragma once
 
-#include <QEventLoop>
+#include <QDBusContext>
+#include <QDBusMessage>
 #include <QHash>
 #include <QObject>
 #include <QStringList>
 
-class EditorDBusService : public QObject
+#include "../acp/ACPModels.h"
+#include "../util/FileLineIndex.h"
+
+class DocumentIndex;
+class DocumentRevisionTracker;
+class EditorSocketServer;
+class QTimer;
+class SnapshotStore;
+
+namespace KTextEditor {
+class Document;
+}
+
+class EditorDBusService : public QObject, protected QDBusContext
 {
     Q_OBJECT
-    Q_CLASSINFO("D-Bus Interface", "org.kde.katecode.Editor")
 
 public:
     explicit EditorDBusService(QObject *parent = nullptr);
@@ -25,25 +38,77 @@ public:
     // Called by UI when user responds to a question
     void provideQuestionResponse(const QString &requestId, const QString &responseJson);
 
+    // Snapshot store for pre/post-edit versions (not owned)
+    void setSnapshotStore(SnapshotStore *store) { m_snapshotStore = store; }
+
+    // Shared path to open document lookup (not owned)
+    void setDocumentIndex(DocumentIndex *index) { m_documentIndex = index; }
+
+    // Whether edits/writes to files that aren't open should open them in Kate.
+    // When false (default) such files are edited directly on disk.
+    void setOpenEditedFiles(bool open) { m_openEditedFiles = open; }
+
+    // Restore a file to its content before the agent's first recorded write,
+    // deleting it if the agent created it. Not exported over DBus.
+    // Returns "OK" on success or "ERROR: ..." on failure.
+    QString revertToOriginal(const QString &filePath);
+
 public Q_SLOTS:
+    // Exported through the generated EditorAdaptor - keep org.kde.katecode.Editor.xml in sync
     QStringList listDocuments();
 
+    // Path of the Unix socket for bulk reads/writes (see SocketFrame.h),
+    // or empty if it is unavailable and callers should stay on DBus.
+    QString socketPath();
+
     // Read a document's content. Returns the text content.
     // If the document is not open, returns an error string starting with "ERROR:".
     QString readDocument(const QString &filePath);
 
+    // Read limit lines starting at 1-based line offset (clamped to the last line).
+    // Returns a JSON object with "revision" (-1 if the file is not open in Kate),
+    // "totalLines", "start" (1-based line of the first returned line) and "lines".
+    // Files not open in Kate are read via a cached line index. Errors start with "ERROR:".
+    QString readDocumentRange(const QString &filePath, int offset, int limit);
+
+    // Read a document relative to a revision previously returned by this service.
+    // Returns a JSON object with "revision" (-1 if the file is not open in Kate),
+    // "totalLines" and "status": "unchanged", "delta" or "full", in which case the
+    // caller should fall back to readDocumentRange. A delta carries "hunks" of
+    // {"oldStart", "oldCount", "newStart", "lines"}, sorted and non-overlapping:
+    // 0-based lines [oldStart, oldStart + oldCount) of the caller's copy became
+    // "lines", which start at newStart in the current document.
+    // Errors start with "ERROR:".
+    QString readDocumentDelta(const QString &filePath, qlonglong sinceRevision);
+
+    // Edits and writes take the agent's ID of the tool call making them, under
+    // which the pre/post-edit snapshots are recorded; empty if unknown.
+
     // Edit a document by replacing old_text with new_text.
     // Returns "OK" on success or "ERROR: ..." on failure.
-    QString editDocument(const QString &filePath, const QString &oldText, const QString &newText);
+    QString editDocument(const QString &filePath, const QString &oldText, const QString &newText, const QString &toolCallId);
+
+    // Apply an ordered list of replacements (oldTexts[i] -> newTexts[i]) in one
+    // undo transaction with a single save. Each old text must be unique after the
+    // preceding edits; if any edit fails, none are applied.
+    // Returns "OK" on success or "ERROR: edit N: ..." on failure.
+    QString multiEditDocument(const QString &filePath, const QStringList &oldTexts, const QStringList &newTexts,
+                              const QString &toolCallId);
 
     // Write content to a document (creates or overwrites).
     // Returns "OK" on success or "ERROR: ..." on failure.
-    QString writeDocument(const QString &filePath, const QString &content);
+    QString writeDocument(const QString &filePath, const QString &content, const QString &toolCallId);
 
-    // Ask the user questions - blocks until user responds or timeout.
+    // Ask the user questions. The DBus reply is delayed until the user responds
+    // or the question times out; any number of questions can be outstanding.
     // questionsJson is a JSON array of question objects.
-    // Returns JSON object with answers keyed by question header, or "ERROR: ..." on failure.
-    QString askUserQuestion(const QString &questionsJson);
+    // Replies with a JSON object of answers keyed by question header, or "ERROR: ..." on failure.
+    // cancelKey is the caller's handle for cancelQuestion, unique among its own questions.
+    QString askUserQuestion(const QString &questionsJson, const QString &cancelKey);
+
+    // Withdraw a question the calling client asked: its delayed reply is
+    // answered with an error and the prompt is removed from the UI.
+    void cancelQuestion(const QString &cancelKey);
 
 Q_SIGNALS:
     // Emitted when a question needs to be shown to the user
@@ -52,13 +117,34 @@ Q_SIGNALS:
     // Emitted when a question times out or is cancelled (UI should remove the prompt)
     void questionCancelled(const QString &requestId);
 
+    // Emitted after edits or writes land in an open document, with their
+    // line positions in the saved document (disk-only writes are not reported)
+    void editsApplied(const QString &toolCallId, const QList<EditDiff> &edits);
+
 private:
+    // Open document for a path, via the shared index when set
+    KTextEditor::Document *findDocument(const QString &filePath) const;
+
+    // Shared implementation of editDocument and multiEditDocument
+    QString applyEdits(const QString &filePath, const QStringList &oldTexts, const QStringList &newTexts,
+                       const QString &toolCallId);
+
+    // Send the delayed reply for a pending question
+    void finishQuestion(const QString &requestId, const QString &response);
+
     // Track pending question requests
     struct PendingQuestion {
-        QEventLoop *eventLoop;
-        QString response;
-        bool completed;
+        QDBusMessage message;  // Call to answer with a delayed reply
+        QString cancelKey;     // Caller's handle, scoped to message.service()
+        QTimer *timeoutTimer;
     };
     QHash<QString, PendingQuestion> m_pendingQuestions;
     int m_nextQuestionId = 0;
+
+    SnapshotStore *m_snapshotStore = nullptr;
+    DocumentIndex *m_documentIndex = nullptr;
+    bool m_openEditedFiles = false;
+    DocumentRevisionTracker *m_revisionTracker;
+    FileLineIndex m_lineIndex;
+    EditorSocketServer *m_socketServer;
 };
@@ -0,0 +1,121 @@
+/*
+    SPDX-License-Identifier: MIT
+    SPDX-FileCopyrightText: 2025 Kate Code contributors
+*/
+
+#include "EditorSocketClient.h"
+#include "SocketFrame.h"
+
+#include <QLocalSocket>
+#include <QTimer>
+
+EditorSocketClient::EditorSocketClient(QObject *parent)
+    : QObject(parent)
+{
+}
+
+EditorSocketClient::~EditorSocketClient()
+{
+    // Callbacks may reference the owner being destroyed - drop them unrun
+    for (const PendingCall &pending : std::as_const(m_pending)) {
+        delete pending.timer;
+    }
+    m_pending.clear();
+    delete m_socket;
+}
+
+bool EditorSocketClient::connectTo(const QString &path)
+{
+    dropConnection();
+
+    m_socket = new QLocalSocket(this);
+    m_socket->connectToServer(path);
+    if (!m_socket->waitForConnected(1000)) {
+        dropConnection();
+        return false;
+    }
+
+    connect(m_socket, &QLocalSocket::readyRead, this, &EditorSocketClient::onReadyRead);
+    connect(m_socket, &QLocalSocket::disconnected, this, &EditorSocketClient::dropConnection);
+    return true;
+}
+
+bool EditorSocketClient::isConnected() const
+{
+    return m_socket && m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+void EditorSocketClient::call(QJsonObject header, const QByteArray &payload, const Callback &callback, int timeoutMs)
+{
+    if (!isConnected()) {
+        callback(Status::NotSent, QString());
+        return;
+    }
+
+    const qint64 id = ++m_nextId;
+    header[QStringLiteral("id")] = id;
+
+    auto *timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, &QTimer::timeout, this, [this, id]() {
+        finish(id, Status::Failed, QString());
+    });
+    timer->start(timeoutMs);
+
+    m_pending.insert(id, {callback, timer});
+    m_socket->write(SocketFrame::encode(header, payload));
+}
+
+void EditorSocketClient::onReadyRead()
+{
+    m_buffer.append(m_socket->readAll());
+
+    QJsonObject header;
+    QByteArray payload;
+    while (true) {
+        const SocketFrame::DecodeResult decoded = SocketFrame::decode(m_buffer, &header, &payload);
+        if (decoded == SocketFrame::DecodeResult::Incomplete) {
+            return;
+        }
+        if (decoded == SocketFrame::DecodeResult::Malformed) {
+            dropConnection();
+            return;
+        }
+        // Replies to timed-out requests are no longer pending and are ignored
+        finish(header[QStringLiteral("id")].toInteger(), Status::Ok, QString::fromUtf8(payload));
+        if (!m_socket) {
+            // A callback tore the connection down
+            return;
+        }
+    }
+}
+
+void EditorSocketClient::finish(qint64 id, Status status, const QString &result)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) {
+        return;
+    }
+    const PendingCall pending = it.value();
+    m_pending.erase(it);
+
+    pending.timer->deleteLater();
+    pending.callback(status, result);
+}
+
+void EditorSocketClient::dropConnection()
+{
+    if (m_socket) {
+        m_socket->disconnect(this);
+        m_socket->abort();
+        m_socket->deleteLater();
+        m_socket = nullptr;
+    }
+    m_buffer.clear();
+
+    // Fail everything in flight; the editor may or may not have handled it
+    const QList<qint64> ids = m_pending.keys();
+    for (qint64 id : ids) {
+        finish(id, Status::Failed, QString());
+    }
+}
@@ -0,0 +1,63 @@
+/*
+    SPDX-License-Identifier: MIT
+    SPDX-FileCopyrightText: 2025 Kate Code contributors
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+
+#include <functional>
+
+class QLocalSocket;
+class QTimer;
+
+// kate-mcp-server side of the editor socket (see EditorSocketServer).
+// Bulk document calls go through here when the plugin advertises a socket;
+// callers fall back to DBus if a request could not be sent. A request that
+// was sent but not answered may have been applied, so writes must not retry.
+//
+// Requests are pipelined: replies are matched to callbacks by frame id, so
+// several calls can be in flight at once.
+class EditorSocketClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Status {
+        Ok,       // result holds the reply
+        NotSent,  // not connected; the editor never saw the request
+        Failed,   // timed out or the connection dropped after sending
+    };
+    using Callback = std::function<void(Status status, const QString &result)>;
+
+    explicit EditorSocketClient(QObject *parent = nullptr);
+    ~EditorSocketClient() override;
+
+    bool connectTo(const QString &path);
+    bool isConnected() const;
+
+    // Send one request; callback runs once with the reply. header must contain "method".
+    void call(QJsonObject header, const QByteArray &payload, const Callback &callback, int timeoutMs = 30000);
+
+private Q_SLOTS:
+    void onReadyRead();
+
+private:
+    struct PendingCall {
+        Callback callback;
+        QTimer *timer;
+    };
+
+    void finish(qint64 id, Status status, const QString &result);
+    void dropConnection();
+
+    QLocalSocket *m_socket = nullptr;
+    QByteArray m_buffer;
+    QHash<qint64, PendingCall> m_pending;
+    qint64 m_nextId = 0;
+};
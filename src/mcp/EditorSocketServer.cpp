@@ -0,0 +1,145 @@
+/*
+    SPDX-License-Identifier: MIT
+    SPDX-FileCopyrightText: 2025 Kate Code contributors
+*/
+
+#include "EditorSocketServer.h"
+#include "EditorDBusService.h"
+#include "SocketFrame.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+EditorSocketServer::EditorSocketServer(EditorDBusService *service, QObject *parent)
+    : QObject(parent)
+    , m_service(service)
+    , m_server(new QLocalServer(this))
+{
+    // Only the owning user may connect
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &EditorSocketServer::onNewConnection);
+}
+
+EditorSocketServer::~EditorSocketServer()
+{
+    m_server->close();
+}
+
+bool EditorSocketServer::listen()
+{
+    // XDG_RUNTIME_DIR is private to the user; fall back to QLocalServer's default location
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (dir.isEmpty()) {
+        dir = QDir::tempPath();
+    }
+    const QString path = QStringLiteral("%1/katecode-editor-%2.sock").arg(dir).arg(QCoreApplication::applicationPid());
+
+    // A stale socket from a crashed process with the same pid would block listen()
+    QLocalServer::removeServer(path);
+
+    if (!m_server->listen(path)) {
+        qWarning() << "[EditorSocketServer] Failed to listen on" << path << ":" << m_server->errorString();
+        return false;
+    }
+
+    qDebug() << "[EditorSocketServer] Listening on" << m_server->fullServerName();
+    return true;
+}
+
+QString EditorSocketServer::socketPath() const
+{
+    return m_server->isListening() ? m_server->fullServerName() : QString();
+}
+
+void EditorSocketServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        m_buffers.insert(socket, QByteArray());
+        connect(socket, &QLocalSocket::readyRead, this, &EditorSocketServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &EditorSocketServer::onDisconnected);
+    }
+}
+
+void EditorSocketServer::onReadyRead()
+{
+    auto *socket = qobject_cast<QLocalSocket *>(sender());
+    if (!socket || !m_buffers.contains(socket)) {
+        return;
+    }
+
+    m_buffers[socket].append(socket->readAll());
+
+    // Dispatching may save documents or open dialogs and so process events.
+    // A nested readyRead only appends; the outer loop picks up its frames.
+    if (m_dispatching.contains(socket)) {
+        return;
+    }
+
+    QJsonObject header;
+    QByteArray payload;
+    while (true) {
+        // Re-fetch each time: the hash may have changed while dispatching
+        auto it = m_buffers.find(socket);
+        if (it == m_buffers.end()) {
+            return;
+        }
+        const SocketFrame::DecodeResult result = SocketFrame::decode(it.value(), &header, &payload);
+        if (result == SocketFrame::DecodeResult::Incomplete) {
+            return;
+        }
+        if (result == SocketFrame::DecodeResult::Malformed) {
+            qWarning() << "[EditorSocketServer] Malformed frame, dropping connection";
+            m_buffers.remove(socket);
+            socket->abort();
+            socket->deleteLater();
+            return;
+        }
+
+        // The frame is already off the buffer, so it can't be run twice
+        m_dispatching.insert(socket);
+        const QString response = dispatch(header, payload);
+        m_dispatching.remove(socket);
+        if (!m_buffers.contains(socket)) {
+            // Disconnected while dispatching
+            return;
+        }
+
+        QJsonObject replyHeader;
+        replyHeader[QStringLiteral("id")] = header[QStringLiteral("id")];
+        socket->write(SocketFrame::encode(replyHeader, response.toUtf8()));
+    }
+}
+
+void EditorSocketServer::onDisconnected()
+{
+    auto *socket = qobject_cast<QLocalSocket *>(sender());
+    if (!socket) {
+        return;
+    }
+    m_buffers.remove(socket);
+    m_dispatching.remove(socket);
+    socket->deleteLater();
+}
+
+QString EditorSocketServer::dispatch(const QJsonObject &header, const QByteArray &payload)
+{
+    const QString method = header[QStringLiteral("method")].toString();
+    const QString filePath = header[QStringLiteral("filePath")].toString();
+
+    if (method == QStringLiteral("readDocument")) {
+        return m_service->readDocument(filePath);
+    } else if (method == QStringLiteral("readDocumentRange")) {
+        return m_service->readDocumentRange(filePath,
+                                            header[QStringLiteral("offset")].toInt(1),
+                                            header[QStringLiteral("limit")].toInt());
+    } else if (method == QStringLiteral("writeDocument")) {
+        return m_service->writeDocument(filePath, QString::fromUtf8(payload),
+                                         header[QStringLiteral("toolCallId")].toString());
+    }
+
+    return QStringLiteral("ERROR: Unknown socket method: %1").arg(method);
+}
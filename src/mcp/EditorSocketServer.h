@@ -0,0 +1,49 @@
+/*
+    SPDX-License-Identifier: MIT
+    SPDX-FileCopyrightText: 2025 Kate Code contributors
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QSet>
+
+class EditorDBusService;
+class QLocalServer;
+class QLocalSocket;
+
+// Per-user Unix socket carrying bulk editor calls (document reads/writes)
+// for kate-mcp-server, bypassing the D-Bus daemon. The socket path is
+// advertised through EditorDBusService::socketPath(); D-Bus remains the
+// fallback and the transport for control calls.
+class EditorSocketServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EditorSocketServer(EditorDBusService *service, QObject *parent = nullptr);
+    ~EditorSocketServer() override;
+
+    // Start listening. Returns false if the socket could not be created.
+    bool listen();
+
+    // Full path of the listening socket, or empty if not listening
+    QString socketPath() const;
+
+private Q_SLOTS:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    // Run one request and return the result string sent back as payload
+    QString dispatch(const QJsonObject &header, const QByteArray &payload);
+
+    EditorDBusService *m_service;
+    QLocalServer *m_server;
+    QHash<QLocalSocket *, QByteArray> m_buffers;
+    QSet<QLocalSocket *> m_dispatching;  // Sockets with a dispatch() on the stack
+};
@@ -4,15 +4,28 @@
 */
 
 #include "MCPServer.h"
+#include "katecode_editor_interface.h"
 
 #include <QDBusConnection>
-#include <QDBusInterface>
-#include <QDBusReply>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QJsonDocument>
 
-MCPServer::MCPServer() = default;
+// One proxy for the whole session: no owner lookup or introspection per
+// call, and it tracks the service owner, so a restarted Kate is picked up.
+MCPServer::MCPServer(QObject *parent)
+    : QObject(parent)
+    , m_editor(new KateCodeEditorInterface(QStringLiteral("org.kde.katecode.editor"),
+                                           QStringLiteral("/KateCode/Editor"),
+                                           QDBusConnection::sessionBus(),
+                                           this))
+    , m_socket(new EditorSocketClient(this))
+{
+}
+
+MCPServer::~MCPServer() = default;
 
-QJsonObject MCPServer::handleMessage(const QJsonObject &msg)
+void MCPServer::handleMessage(const QJsonObject &msg)
 {
     const QString method = msg[QStringLiteral("method")].toString();
     const int id = msg[QStringLiteral("id")].toInt(-1);
@@ -20,18 +33,21 @@ QJsonObject MCPServer::handleMessage(const QJsonObject &msg)
 
     // Notifications have no id — no response needed
     if (id < 0) {
-        return {};
+        if (method == QStringLiteral("notifications/cancelled")) {
+            handleCancelled(params);
+        }
+        return;
     }
 
     if (method == QStringLiteral("initialize")) {
-        return handleInitialize(id, params);
+        Q_EMIT responseReady(handleInitialize(id, params));
     } else if (method == QStringLiteral("tools/list")) {
-        return handleToolsList(id, params);
+        Q_EMIT responseReady(handleToolsList(id, params));
     } else if (method == QStringLiteral("tools/call")) {
-        return handleToolsCall(id, params);
+        handleToolsCall(id, params);
+    } else {
+        Q_EMIT responseReady(makeErrorResponse(id, -32601, QStringLiteral("Method not found: %1").arg(method)));
     }
-
-    return makeErrorResponse(id, -32601, QStringLiteral("Method not found: %1").arg(method));
 }
 
 QJsonObject MCPServer::handleInitialize(int id, const QJsonObject &params)
@@ -79,7 +95,7 @@ QJsonObject MCPServer::handleToolsList(int id, const QJsonObject &params)
     QJsonObject readTool;
     readTool[QStringLiteral("name")] = QStringLiteral("katecode_read");
     readTool[QStringLiteral("description")] =
-        QStringLiteral("Reads the content of a file. If the file is open in Kate, returns the current buffer content (which may have unsaved changes). Otherwise reads from disk. By default returns up to 2000 lines; use offset and limit for larger files.\n\nIn sessions with mcp__kate__katecode_read always use it instead of Read or mcp__acp__Read, as it contains the most up-to-date contents provided by the editor.");
+        QStringLiteral("Reads the content of a file. If the file is open in Kate, returns the current buffer content (which may have unsaved changes). Otherwise reads from disk. By default returns up to 2000 lines; use offset and limit for larger files. Reads of open documents report a revision; pass it back as since_revision to receive only the changed hunks since then, each headed \"@@ -old,count +new,count @@\" like a unified diff.\n\nIn sessions with mcp__kate__katecode_read always use it instead of Read or mcp__acp__Read, as it contains the most up-to-date contents provided by the editor.");
 
     QJsonObject readPathProp;
     readPathProp[QStringLiteral("type")] = QStringLiteral("string");
@@ -93,10 +109,15 @@ QJsonObject MCPServer::handleToolsList(int id, const QJsonObject &params)
     readLimitProp[QStringLiteral("type")] = QStringLiteral("integer");
     readLimitProp[QStringLiteral("description")] = QStringLiteral("Maximum number of lines to return. Default: 2000");
 
+    QJsonObject readSinceProp;
+    readSinceProp[QStringLiteral("type")] = QStringLiteral("integer");
+    readSinceProp[QStringLiteral("description")] = QStringLiteral("Revision from a previous read of this file. If given, returns \"unchanged\" or only the changed line ranges since that revision");
+
     QJsonObject readProps;
     readProps[QStringLiteral("file_path")] = readPathProp;
     readProps[QStringLiteral("offset")] = readOffsetProp;
     readProps[QStringLiteral("limit")] = readLimitProp;
+    readProps[QStringLiteral("since_revision")] = readSinceProp;
 
     QJsonObject readSchema;
     readSchema[QStringLiteral("type")] = QStringLiteral("object");
@@ -114,7 +135,7 @@ QJsonObject MCPServer::handleToolsList(int id, const QJsonObject &params)
     QJsonObject editTool;
     editTool[QStringLiteral("name")] = QStringLiteral("katecode_edit");
     editTool[QStringLiteral("description")] =
-        QStringLiteral("Edits a file by replacing old_string with new_string. The old_string must be unique in the file. Opens the file in Kate if not already open.\n\nIn sessions with mcp__kate__katecode_edit always use it instead of Edit or mcp__acp__Edit, as it will update the editor buffer directly.");
+        QStringLiteral("Edits a file by replacing old_string with new_string. The old_string must be unique in the file. Files not open in Kate are edited on disk without opening a tab, unless the user has enabled opening edited files.\n\nIn sessions with mcp__kate__katecode_edit always use it instead of Edit or mcp__acp__Edit, as it will update the editor buffer directly.");
 
     QJsonObject editPathProp;
     editPathProp[QStringLiteral("type")] = QStringLiteral("string");
@@ -146,6 +167,38 @@ QJsonObject MCPServer::handleToolsList(int id, const QJsonObject &params)
     editAnnotations[QStringLiteral("idempotentHint")] = false;
     editTool[QStringLiteral("annotations")] = editAnnotations;
 
+    // katecode_multi_edit tool definition
+    QJsonObject multiEditTool;
+    multiEditTool[QStringLiteral("name")] = QStringLiteral("katecode_multi_edit");
+    multiEditTool[QStringLiteral("description")] =
+        QStringLiteral("Makes several edits to one file in a single operation. Edits are applied in order, each to the result of the previous one, and every old_string must be unique at that point. Either all edits are applied (as one undo step, saved once) or none are. Prefer this over repeated katecode_edit calls on the same file.");
+
+    QJsonObject multiEditEditProps;
+    multiEditEditProps[QStringLiteral("old_string")] = editOldProp;
+    multiEditEditProps[QStringLiteral("new_string")] = editNewProp;
+
+    QJsonObject multiEditEditSchema;
+    multiEditEditSchema[QStringLiteral("type")] = QStringLiteral("object");
+    multiEditEditSchema[QStringLiteral("properties")] = multiEditEditProps;
+    multiEditEditSchema[QStringLiteral("required")] = QJsonArray{QStringLiteral("old_string"), QStringLiteral("new_string")};
+
+    QJsonObject multiEditEditsProp;
+    multiEditEditsProp[QStringLiteral("type")] = QStringLiteral("array");
+    multiEditEditsProp[QStringLiteral("items")] = multiEditEditSchema;
+    multiEditEditsProp[QStringLiteral("minItems")] = 1;
+    multiEditEditsProp[QStringLiteral("description")] = QStringLiteral("Edits to apply in order");
+
+    QJsonObject multiEditProps;
+    multiEditProps[QStringLiteral("file_path")] = editPathProp;
+    multiEditProps[QStringLiteral("edits")] = multiEditEditsProp;
+
+    QJsonObject multiEditSchema;
+    multiEditSchema[QStringLiteral("type")] = QStringLiteral("object");
+    multiEditSchema[QStringLiteral("properties")] = multiEditProps;
+    multiEditSchema[QStringLiteral("required")] = QJsonArray{QStringLiteral("file_path"), QStringLiteral("edits")};
+    multiEditTool[QStringLiteral("inputSchema")] = multiEditSchema;
+    multiEditTool[QStringLiteral("annotations")] = editAnnotations;
+
     // katecode_write tool definition
     QJsonObject writeTool;
     writeTool[QStringLiteral("name")] = QStringLiteral("katecode_write");
@@ -269,79 +322,103 @@ QJsonObject MCPServer::handleToolsList(int id, const QJsonObject &params)
     askUserTool[QStringLiteral("annotations")] = askUserAnnotations;
 
     QJsonObject result;
-    result[QStringLiteral("tools")] = QJsonArray{docsTool, readTool, editTool, writeTool, askUserTool};
+    result[QStringLiteral("tools")] = QJsonArray{docsTool, readTool, editTool, multiEditTool, writeTool, askUserTool};
 
     return makeResponse(id, result);
 }
 
-QJsonObject MCPServer::handleToolsCall(int id, const QJsonObject &params)
+void MCPServer::handleToolsCall(int id, const QJsonObject &params)
 {
     const QString toolName = params[QStringLiteral("name")].toString();
     const QJsonObject arguments = params[QStringLiteral("arguments")].toObject();
+    // The agent's ID for this tool call, which Kate records edit snapshots under.
+    // Claude Code passes it in _meta; other clients may not, leaving it empty.
+    const QString toolCallId = params[QStringLiteral("_meta")].toObject()
+                                   [QStringLiteral("claudecode/toolUseId")].toString();
+
+    // Tool calls complete asynchronously and may answer out of order
+    m_activeRequests.insert(id);
+    const ToolCallback done = [this, id](const QJsonObject &result) {
+        finishRequest(id, result);
+    };
 
     if (toolName == QStringLiteral("katecode_documents")) {
-        return makeResponse(id, executeDocuments(arguments));
+        executeDocuments(arguments, done);
     } else if (toolName == QStringLiteral("katecode_read")) {
-        return makeResponse(id, executeRead(arguments));
+        executeRead(arguments, done);
     } else if (toolName == QStringLiteral("katecode_edit")) {
-        return makeResponse(id, executeEdit(arguments));
+        executeEdit(arguments, toolCallId, done);
+    } else if (toolName == QStringLiteral("katecode_multi_edit")) {
+        executeMultiEdit(arguments, toolCallId, done);
     } else if (toolName == QStringLiteral("katecode_write")) {
-        return makeResponse(id, executeWrite(arguments));
+        executeWrite(arguments, toolCallId, done);
     } else if (toolName == QStringLiteral("katecode_ask_user")) {
-        return makeResponse(id, executeAskUserQuestion(arguments));
+        executeAskUserQuestion(id, arguments, done);
+    } else {
+        m_activeRequests.remove(id);
+        Q_EMIT responseReady(makeErrorResponse(id, -32602, QStringLiteral("Unknown tool: %1").arg(toolName)));
     }
-
-    return makeErrorResponse(id, -32602, QStringLiteral("Unknown tool: %1").arg(toolName));
 }
 
-QJsonObject MCPServer::executeDocuments(const QJsonObject &arguments)
+void MCPServer::handleCancelled(const QJsonObject &params)
 {
-    Q_UNUSED(arguments);
+    // The client no longer wants a response; drop it when the call completes
+    const int requestId = params[QStringLiteral("requestId")].toInt(-1);
+    m_activeRequests.remove(requestId);
 
-    QDBusInterface iface(QStringLiteral("org.kde.katecode.editor"),
-                         QStringLiteral("/KateCode/Editor"),
-                         QStringLiteral("org.kde.katecode.Editor"),
-                         QDBusConnection::sessionBus());
+    // A question would otherwise stay on screen until answered or timed out
+    if (m_pendingQuestions.remove(requestId)) {
+        m_editor->cancelQuestion(QString::number(requestId));
+    }
+}
 
-    if (!iface.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: Could not connect to Kate editor DBus service.");
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+void MCPServer::finishRequest(int id, const QJsonObject &result)
+{
+    if (!m_activeRequests.remove(id)) {
+        // Cancelled
+        return;
     }
+    Q_EMIT responseReady(makeResponse(id, result));
+}
 
-    QDBusReply<QStringList> reply = iface.call(QStringLiteral("listDocuments"));
-    if (!reply.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: DBus call failed: %1").arg(reply.error().message());
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+void MCPServer::executeDocuments(const QJsonObject &arguments, const ToolCallback &done)
+{
+    Q_UNUSED(arguments);
+
+    if (!m_editor->isValid()) {
+        done(makeErrorResult(QStringLiteral("Error: Could not connect to Kate editor DBus service.")));
+        return;
     }
 
-    const QStringList docs = reply.value();
-    QString text;
-    if (docs.isEmpty()) {
-        text = QStringLiteral("No documents currently open in Kate.");
-    } else {
-        text = QStringLiteral("Open documents (%1):\n").arg(docs.size());
-        for (const QString &doc : docs) {
-            text += QStringLiteral("  %1\n").arg(doc);
+    auto *watcher = new QDBusPendingCallWatcher(m_editor->listDocuments(), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, done](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+
+        QDBusPendingReply<QStringList> reply = *call;
+        if (reply.isError()) {
+            done(makeErrorResult(QStringLiteral("Error: DBus call failed: %1").arg(reply.error().message())));
+            return;
         }
-    }
 
-    QJsonObject textContent;
-    textContent[QStringLiteral("type")] = QStringLiteral("text");
-    textContent[QStringLiteral("text")] = text;
+        const QStringList docs = reply.value();
+        QString text;
+        if (docs.isEmpty()) {
+            text = QStringLiteral("No documents currently open in Kate.");
+        } else {
+            text = QStringLiteral("Open documents (%1):\n").arg(docs.size());
+            for (const QString &doc : docs) {
+                text += QStringLiteral("  %1\n").arg(doc);
+            }
+        }
 
-    QJsonObject result;
-    result[QStringLiteral("content")] = QJsonArray{textContent};
-    return result;
+        QJsonObject textContent;
+        textContent[QStringLiteral("type")] = QStringLiteral("text");
+        textContent[QStringLiteral("text")] = text;
+
+        QJsonObject result;
+        result[QStringLiteral("content")] = QJsonArray{textContent};
+        done(result);
+    });
 }
 
 QJsonObject MCPServer::makeResponse(int id, const QJsonObject &result)
@@ -366,7 +443,7 @@ QJsonObject MCPServer::makeErrorResponse(int id, int code, const QString &messag
     return response;
 }
 
-QJsonObject MCPServer::executeRead(const QJsonObject &arguments)
+void MCPServer::executeRead(const QJsonObject &arguments, const ToolCallback &done)
 {
     const QString filePath = arguments[QStringLiteral("file_path")].toString();
 
@@ -382,77 +459,89 @@ QJsonObject MCPServer::executeRead(const QJsonObject &arguments)
         limit = qMax(1, arguments[QStringLiteral("limit")].toInt(defaultLimit));
     }
 
-    if (filePath.isEmpty()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: file_path is required");
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+    // Optional revision for delta reads (-1 = full read)
+    qlonglong sinceRevision = -1;
+    if (arguments.contains(QStringLiteral("since_revision"))) {
+        sinceRevision = arguments[QStringLiteral("since_revision")].toVariant().toLongLong();
     }
 
-    QDBusInterface iface(QStringLiteral("org.kde.katecode.editor"),
-                         QStringLiteral("/KateCode/Editor"),
-                         QStringLiteral("org.kde.katecode.Editor"),
-                         QDBusConnection::sessionBus());
-
-    if (!iface.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: Could not connect to Kate editor DBus service.");
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+    if (filePath.isEmpty()) {
+        done(makeErrorResult(QStringLiteral("Error: file_path is required")));
+        return;
     }
 
-    QDBusReply<QString> reply = iface.call(QStringLiteral("readDocument"), filePath);
-    if (!reply.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: DBus call failed: %1").arg(reply.error().message());
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+    if (!m_editor->isValid()) {
+        done(makeErrorResult(QStringLiteral("Error: Could not connect to Kate editor DBus service.")));
+        return;
     }
 
-    const QString content = reply.value();
-    if (content.startsWith(QStringLiteral("ERROR:"))) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = content;
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+    // Only the requested lines are transferred, over the socket when available
+    auto readRange = [this, filePath, offset, limit, done]() {
+        QJsonObject rangeRequest;
+        rangeRequest[QStringLiteral("filePath")] = filePath;
+        rangeRequest[QStringLiteral("offset")] = offset;
+        rangeRequest[QStringLiteral("limit")] = limit;
+
+        callEditorSocket(QStringLiteral("readDocumentRange"), rangeRequest, QByteArray(),
+                         [this, filePath, offset, limit, done](EditorSocketClient::Status status, const QString &response) {
+            if (status == EditorSocketClient::Status::Ok) {
+                done(formatReadRange(response));
+                return;
+            }
+            watchStringReply(m_editor->readDocumentRange(filePath, offset, limit), [this, done](bool dbusOk, const QString &reply) {
+                done(dbusOk ? formatReadRange(reply) : makeErrorResult(reply));
+            });
+        });
+    };
+
+    if (sinceRevision < 0) {
+        readRange();
+        return;
     }
 
-    // Split content into lines and apply offset/limit
-    QStringList allLines = content.split(QLatin1Char('\n'));
-    const int totalLines = allLines.size();
+    // Delta read first; only fall back to a ranged read if the revision can't be diffed
+    watchStringReply(m_editor->readDocumentDelta(filePath, sinceRevision),
+                     [this, sinceRevision, limit, readRange, done](bool ok, const QString &reply) {
+        if (!ok || reply.startsWith(QStringLiteral("ERROR:"))) {
+            done(makeErrorResult(reply));
+            return;
+        }
+
+        const QJsonObject delta = QJsonDocument::fromJson(reply.toUtf8()).object();
+        const QString status = delta[QStringLiteral("status")].toString();
+        if (status == QStringLiteral("unchanged") || status == QStringLiteral("delta")) {
+            done(formatReadDelta(delta, sinceRevision, limit));
+            return;
+        }
+        readRange();
+    });
+}
 
-    // Convert 1-based offset to 0-based index
-    int startIdx = offset - 1;
-    if (startIdx >= totalLines) {
-        startIdx = qMax(0, totalLines - 1);
+QJsonObject MCPServer::formatReadRange(const QString &response)
+{
+    if (response.startsWith(QStringLiteral("ERROR:"))) {
+        return makeErrorResult(response);
     }
 
-    int endIdx = qMin(startIdx + limit, totalLines);
-    int linesOmittedBefore = startIdx;
-    int linesOmittedAfter = totalLines - endIdx;
+    const QJsonObject range = QJsonDocument::fromJson(response.toUtf8()).object();
+    const qint64 revision = range[QStringLiteral("revision")].toVariant().toLongLong();
+    const int totalLines = range[QStringLiteral("totalLines")].toInt();
+    const int startLine = range[QStringLiteral("start")].toInt(1);
+    const QJsonArray lines = range[QStringLiteral("lines")].toArray();
+
+    const int endLine = startLine + lines.size() - 1;
+    int linesOmittedBefore = startLine - 1;
+    int linesOmittedAfter = qMax(0, totalLines - endLine);
 
     // Build output with line numbers (like Claude Code's Read tool)
     // Format: "   42→content" with arrow separator
     QString outputText;
-    int lineNumWidth = QString::number(endIdx).length();
+    int lineNumWidth = QString::number(qMax(startLine, endLine)).length();
 
-    for (int i = startIdx; i < endIdx; ++i) {
-        int lineNum = i + 1;  // 1-based line number
+    for (int i = 0; i < lines.size(); ++i) {
         outputText += QStringLiteral("%1→%2\n")
-            .arg(lineNum, lineNumWidth)
-            .arg(allLines[i]);
+            .arg(startLine + i, lineNumWidth)
+            .arg(lines[i].toString());
     }
 
     // Remove trailing newline if present
@@ -460,9 +549,9 @@ QJsonObject MCPServer::executeRead(const QJsonObject &arguments)
         outputText.chop(1);
     }
 
-    // Add truncation warnings
+    // Add truncation warnings and the revision for later delta reads
     QString header;
-    if (linesOmittedBefore > 0 || linesOmittedAfter > 0) {
+    if (linesOmittedBefore > 0 || linesOmittedAfter > 0 || revision >= 0) {
         header = QStringLiteral("(%1 total lines").arg(totalLines);
         if (linesOmittedBefore > 0) {
             header += QStringLiteral(", %1 omitted before").arg(linesOmittedBefore);
@@ -470,6 +559,9 @@ QJsonObject MCPServer::executeRead(const QJsonObject &arguments)
         if (linesOmittedAfter > 0) {
             header += QStringLiteral(", %1 omitted after").arg(linesOmittedAfter);
         }
+        if (revision >= 0) {
+            header += QStringLiteral(", revision %1").arg(revision);
+        }
         header += QStringLiteral(")\n\n");
     }
 
@@ -482,114 +574,205 @@ QJsonObject MCPServer::executeRead(const QJsonObject &arguments)
     return result;
 }
 
-QJsonObject MCPServer::executeEdit(const QJsonObject &arguments)
+QJsonObject MCPServer::formatReadDelta(const QJsonObject &delta, qint64 sinceRevision, int limit)
+{
+    const qint64 revision = delta[QStringLiteral("revision")].toVariant().toLongLong();
+    const int totalLines = delta[QStringLiteral("totalLines")].toInt();
+
+    QString text;
+    if (delta[QStringLiteral("status")].toString() == QStringLiteral("unchanged")) {
+        text = QStringLiteral("(unchanged since revision %1, %2 total lines, revision %3)")
+            .arg(sinceRevision).arg(totalLines).arg(revision);
+    } else {
+        text = QStringLiteral("(changed lines since revision %1, %2 total lines, revision %3)\n")
+            .arg(sinceRevision).arg(totalLines).arg(revision);
+
+        // Each hunk says which lines of the earlier revision it replaces,
+        // followed by its new lines in the same "   42→content" format as full reads
+        const QJsonArray hunks = delta[QStringLiteral("hunks")].toArray();
+        const int lineNumWidth = QString::number(totalLines).length();
+        int emitted = 0;
+        for (const QJsonValue &hunkValue : hunks) {
+            const QJsonObject hunk = hunkValue.toObject();
+            const int oldStart = hunk[QStringLiteral("oldStart")].toInt();
+            const int oldCount = hunk[QStringLiteral("oldCount")].toInt();
+            const int newStart = hunk[QStringLiteral("newStart")].toInt();
+            const QJsonArray lines = hunk[QStringLiteral("lines")].toArray();
+
+            // 1-based like unified diffs; an empty side starts after the line before it
+            text += QStringLiteral("@@ -%1,%2 +%3,%4 @@\n")
+                .arg(oldCount > 0 ? oldStart + 1 : oldStart).arg(oldCount)
+                .arg(lines.isEmpty() ? newStart : newStart + 1).arg(lines.size());
+            for (int i = 0; i < lines.size(); ++i) {
+                if (emitted >= limit) {
+                    text += QStringLiteral("(delta truncated at %1 lines; use offset to read the rest)").arg(limit);
+                    break;
+                }
+                text += QStringLiteral("%1→%2\n")
+                    .arg(newStart + i + 1, lineNumWidth)
+                    .arg(lines[i].toString());
+                ++emitted;
+            }
+            if (emitted >= limit) {
+                break;
+            }
+        }
+
+        if (text.endsWith(QLatin1Char('\n'))) {
+            text.chop(1);
+        }
+    }
+
+    QJsonObject textContent;
+    textContent[QStringLiteral("type")] = QStringLiteral("text");
+    textContent[QStringLiteral("text")] = text;
+
+    QJsonObject result;
+    result[QStringLiteral("content")] = QJsonArray{textContent};
+    return result;
+}
+
+void MCPServer::executeEdit(const QJsonObject &arguments, const QString &toolCallId, const ToolCallback &done)
 {
     const QString filePath = arguments[QStringLiteral("file_path")].toString();
     const QString oldString = arguments[QStringLiteral("old_string")].toString();
     const QString newString = arguments[QStringLiteral("new_string")].toString();
 
     if (filePath.isEmpty() || oldString.isEmpty()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: file_path and old_string are required");
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+        done(makeErrorResult(QStringLiteral("Error: file_path and old_string are required")));
+        return;
     }
 
-    QDBusInterface iface(QStringLiteral("org.kde.katecode.editor"),
-                         QStringLiteral("/KateCode/Editor"),
-                         QStringLiteral("org.kde.katecode.Editor"),
-                         QDBusConnection::sessionBus());
-
-    if (!iface.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: Could not connect to Kate editor DBus service.");
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+    if (!m_editor->isValid()) {
+        done(makeErrorResult(QStringLiteral("Error: Could not connect to Kate editor DBus service.")));
+        return;
     }
 
-    QDBusReply<QString> reply = iface.call(QStringLiteral("editDocument"), filePath, oldString, newString);
-    if (!reply.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: DBus call failed: %1").arg(reply.error().message());
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
-    }
+    watchStringReply(m_editor->editDocument(filePath, oldString, newString, toolCallId), [this, done](bool ok, const QString &reply) {
+        done(ok ? makeEditorResult(reply) : makeErrorResult(reply));
+    });
+}
 
-    const QString response = reply.value();
-    bool isError = response.startsWith(QStringLiteral("ERROR:"));
+void MCPServer::executeMultiEdit(const QJsonObject &arguments, const QString &toolCallId, const ToolCallback &done)
+{
+    const QString filePath = arguments[QStringLiteral("file_path")].toString();
+    const QJsonArray edits = arguments[QStringLiteral("edits")].toArray();
 
-    QJsonObject textContent;
-    textContent[QStringLiteral("type")] = QStringLiteral("text");
-    textContent[QStringLiteral("text")] = response;
+    if (filePath.isEmpty() || edits.isEmpty()) {
+        done(makeErrorResult(QStringLiteral("Error: file_path and a non-empty edits array are required")));
+        return;
+    }
 
-    QJsonObject result;
-    result[QStringLiteral("content")] = QJsonArray{textContent};
-    if (isError) {
-        result[QStringLiteral("isError")] = true;
+    QStringList oldStrings;
+    QStringList newStrings;
+    for (int i = 0; i < edits.size(); ++i) {
+        const QJsonObject edit = edits[i].toObject();
+        const QString oldString = edit[QStringLiteral("old_string")].toString();
+        if (oldString.isEmpty()) {
+            done(makeErrorResult(QStringLiteral("Error: edit %1 is missing old_string").arg(i + 1)));
+            return;
+        }
+        oldStrings.append(oldString);
+        newStrings.append(edit[QStringLiteral("new_string")].toString());
     }
-    return result;
+
+    if (!m_editor->isValid()) {
+        done(makeErrorResult(QStringLiteral("Error: Could not connect to Kate editor DBus service.")));
+        return;
+    }
+
+    watchStringReply(m_editor->multiEditDocument(filePath, oldStrings, newStrings, toolCallId), [this, done](bool ok, const QString &reply) {
+        done(ok ? makeEditorResult(reply) : makeErrorResult(reply));
+    });
 }
 
-QJsonObject MCPServer::executeWrite(const QJsonObject &arguments)
+void MCPServer::executeWrite(const QJsonObject &arguments, const QString &toolCallId, const ToolCallback &done)
 {
     const QString filePath = arguments[QStringLiteral("file_path")].toString();
     const QString content = arguments[QStringLiteral("content")].toString();
 
     if (filePath.isEmpty()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: file_path is required");
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+        done(makeErrorResult(QStringLiteral("Error: file_path is required")));
+        return;
     }
 
-    QDBusInterface iface(QStringLiteral("org.kde.katecode.editor"),
-                         QStringLiteral("/KateCode/Editor"),
-                         QStringLiteral("org.kde.katecode.Editor"),
-                         QDBusConnection::sessionBus());
-
-    if (!iface.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: Could not connect to Kate editor DBus service.");
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+    if (!m_editor->isValid()) {
+        done(makeErrorResult(QStringLiteral("Error: Could not connect to Kate editor DBus service.")));
+        return;
     }
 
-    QDBusReply<QString> reply = iface.call(QStringLiteral("writeDocument"), filePath, content);
-    if (!reply.isValid()) {
-        QJsonObject textContent;
-        textContent[QStringLiteral("type")] = QStringLiteral("text");
-        textContent[QStringLiteral("text")] = QStringLiteral("Error: DBus call failed: %1").arg(reply.error().message());
-        QJsonObject result;
-        result[QStringLiteral("content")] = QJsonArray{textContent};
-        result[QStringLiteral("isError")] = true;
-        return result;
+    // Content goes over the socket as a raw payload when available
+    QJsonObject writeRequest;
+    writeRequest[QStringLiteral("filePath")] = filePath;
+    writeRequest[QStringLiteral("toolCallId")] = toolCallId;
+
+    callEditorSocket(QStringLiteral("writeDocument"), writeRequest, content.toUtf8(),
+                     [this, filePath, content, toolCallId, done](EditorSocketClient::Status status, const QString &response) {
+        if (status == EditorSocketClient::Status::Ok) {
+            done(makeEditorResult(response));
+            return;
+        }
+        if (status == EditorSocketClient::Status::Failed) {
+            // The write may have been applied; sending it again over DBus could apply it twice
+            done(makeErrorResult(QStringLiteral("Error: No reply from Kate to the write of %1; "
+                                                "check the file before retrying").arg(filePath)));
+            return;
+        }
+        watchStringReply(m_editor->writeDocument(filePath, content, toolCallId), [this, done](bool dbusOk, const QString &reply) {
+            done(dbusOk ? makeEditorResult(reply) : makeErrorResult(reply));
+        });
+    });
+}
+
+void MCPServer::watchStringReply(const QDBusPendingCall &call, const ReplyCallback &callback)
+{
+    auto *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [callback](QDBusPendingCallWatcher *finished) {
+        finished->deleteLater();
+
+        QDBusPendingReply<QString> reply = *finished;
+        if (reply.isError()) {
+            callback(false, QStringLiteral("Error: DBus call failed: %1").arg(reply.error().message()));
+            return;
+        }
+        callback(true, reply.value());
+    });
+}
+
+void MCPServer::callEditorSocket(const QString &method, QJsonObject request, const QByteArray &payload,
+                                 const EditorSocketClient::Callback &callback)
+{
+    request[QStringLiteral("method")] = method;
+
+    if (m_socket->isConnected()) {
+        m_socket->call(request, payload, callback);
+        return;
     }
 
-    const QString response = reply.value();
-    bool isError = response.startsWith(QStringLiteral("ERROR:"));
+    // Ask the plugin where its socket is; older plugins or failures mean DBus only
+    auto *watcher = new QDBusPendingCallWatcher(m_editor->socketPath(), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, request, payload, callback](QDBusPendingCallWatcher *finished) {
+        finished->deleteLater();
+
+        QDBusPendingReply<QString> path = *finished;
+        if (path.isError() || path.value().isEmpty()
+            || (!m_socket->isConnected() && !m_socket->connectTo(path.value()))) {
+            callback(EditorSocketClient::Status::NotSent, QString());
+            return;
+        }
+        m_socket->call(request, payload, callback);
+    });
+}
 
+QJsonObject MCPServer::makeEditorResult(const QString &response)
+{
     QJsonObject textContent;
     textContent[QStringLiteral("type")] = QStringLiteral("text");
     textContent[QStringLiteral("text")] = response;
 
     QJsonObject result;
     result[QStringLiteral("content")] = QJsonArray{textContent};
-    if (isError) {
+    if (response.startsWith(QStringLiteral("ERROR:"))) {
         result[QStringLiteral("isError")] = true;
     }
     return result;
@@ -607,16 +790,18 @@ QJsonObject MCPServer::makeErrorResult(const QString &message)
     return result;
 }
 
-QJsonObject MCPServer::executeAskUserQuestion(const QJsonObject &arguments)
+void MCPServer::executeAskUserQuestion(int id, const QJsonObject &arguments, const ToolCallback &done)
 {
     const QJsonArray questions = arguments[QStringLiteral("questions")].toArray();
 
     // Validate: 1-4 questions
     if (questions.isEmpty()) {
-        return makeErrorResult(QStringLiteral("Error: questions array is required and cannot be empty"));
+        done(makeErrorResult(QStringLiteral("Error: questions array is required and cannot be empty")));
+        return;
     }
     if (questions.size() > 4) {
-        return makeErrorResult(QStringLiteral("Error: questions array must have at most 4 items"));
+        done(makeErrorResult(QStringLiteral("Error: questions array must have at most 4 items")));
+        return;
     }
 
     // Validate each question
@@ -627,19 +812,24 @@ QJsonObject MCPServer::executeAskUserQuestion(const QJsonObject &arguments)
         const QJsonArray options = q[QStringLiteral("options")].toArray();
 
         if (header.isEmpty()) {
-            return makeErrorResult(QStringLiteral("Error: question %1 is missing 'header'").arg(i + 1));
+            done(makeErrorResult(QStringLiteral("Error: question %1 is missing 'header'").arg(i + 1)));
+            return;
         }
         if (header.length() > 12) {
-            return makeErrorResult(QStringLiteral("Error: question %1 header exceeds 12 characters").arg(i + 1));
+            done(makeErrorResult(QStringLiteral("Error: question %1 header exceeds 12 characters").arg(i + 1)));
+            return;
         }
         if (questionText.isEmpty()) {
-            return makeErrorResult(QStringLiteral("Error: question %1 is missing 'question' text").arg(i + 1));
+            done(makeErrorResult(QStringLiteral("Error: question %1 is missing 'question' text").arg(i + 1)));
+            return;
         }
         if (options.size() < 2) {
-            return makeErrorResult(QStringLiteral("Error: question %1 must have at least 2 options").arg(i + 1));
+            done(makeErrorResult(QStringLiteral("Error: question %1 must have at least 2 options").arg(i + 1)));
+            return;
         }
         if (options.size() > 4) {
-            return makeErrorResult(QStringLiteral("Error: question %1 must have at most 4 options").arg(i + 1));
+            done(makeErrorResult(QStringLiteral("Error: question %1 must have at most 4 options").arg(i + 1)));
+            return;
         }
     }
 
@@ -647,28 +837,28 @@ QJsonObject MCPServer::executeAskUserQuestion(const QJsonObject &arguments)
     const QString questionsJson = QString::fromUtf8(
         QJsonDocument(questions).toJson(QJsonDocument::Compact));
 
-    // Call DBus method - this will block until user responds
-    QDBusInterface iface(QStringLiteral("org.kde.katecode.editor"),
-                         QStringLiteral("/KateCode/Editor"),
-                         QStringLiteral("org.kde.katecode.Editor"),
-                         QDBusConnection::sessionBus());
-
-    if (!iface.isValid()) {
-        return makeErrorResult(QStringLiteral("Error: Could not connect to Kate editor DBus service. "
-                                              "Is Kate running with the Kate Code plugin enabled?"));
+    if (!m_editor->isValid()) {
+        done(makeErrorResult(QStringLiteral("Error: Could not connect to Kate editor DBus service. "
+                                            "Is Kate running with the Kate Code plugin enabled?")));
+        return;
     }
 
-    // Set timeout to 5 minutes (user interaction can take time)
-    iface.setTimeout(300000);
+    // Set timeout to 5 minutes (user interaction can take time); other tool
+    // calls keep being answered while this one waits
+    const int previousTimeout = m_editor->timeout();
+    m_editor->setTimeout(300000);
+    const QDBusPendingCall call = m_editor->askUserQuestion(questionsJson, QString::number(id));
+    m_editor->setTimeout(previousTimeout);
+    m_pendingQuestions.insert(id);
 
-    QDBusReply<QString> reply = iface.call(QStringLiteral("askUserQuestion"), questionsJson);
-
-    if (!reply.isValid()) {
-        return makeErrorResult(QStringLiteral("Error: DBus call failed: %1").arg(reply.error().message()));
-    }
-
-    const QString responseJson = reply.value();
+    watchStringReply(call, [this, id, done](bool ok, const QString &reply) {
+        m_pendingQuestions.remove(id);
+        done(ok ? formatAskUserAnswer(reply) : makeErrorResult(reply));
+    });
+}
 
+QJsonObject MCPServer::formatAskUserAnswer(const QString &responseJson)
+{
     // Check for error response
     if (responseJson.startsWith(QStringLiteral("ERROR:"))) {
         return makeErrorResult(responseJson);
@@ -5,33 +5,75 @@
 
 #pragma once
 
+#include "EditorSocketClient.h"
+
+#include <QByteArray>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QObject>
+#include <QSet>
 #include <QString>
 
-class MCPServer
+#include <functional>
+
+class KateCodeEditorInterface;
+class QDBusPendingCall;
+
+class MCPServer : public QObject
 {
+    Q_OBJECT
+
 public:
-    MCPServer();
+    explicit MCPServer(QObject *parent = nullptr);
+    ~MCPServer() override;
 
-    // Process a single JSON-RPC message and return the response.
-    // Returns a null QJsonObject for notifications (no response needed).
-    QJsonObject handleMessage(const QJsonObject &msg);
+    // Process a single JSON-RPC message. Responses are delivered through
+    // responseReady, possibly out of order; notifications get none.
+    void handleMessage(const QJsonObject &msg);
+
+Q_SIGNALS:
+    void responseReady(const QJsonObject &response);
 
 private:
+    // Receives a tool's MCP result once its editor calls complete
+    using ToolCallback = std::function<void(const QJsonObject &result)>;
+    // Receives an editor call's reply, or an error message if ok is false
+    using ReplyCallback = std::function<void(bool ok, const QString &reply)>;
+
     QJsonObject handleInitialize(int id, const QJsonObject &params);
     QJsonObject handleToolsList(int id, const QJsonObject &params);
-    QJsonObject handleToolsCall(int id, const QJsonObject &params);
+    void handleToolsCall(int id, const QJsonObject &params);
+    void handleCancelled(const QJsonObject &params);
+    void finishRequest(int id, const QJsonObject &result);
+
+    void executeDocuments(const QJsonObject &arguments, const ToolCallback &done);
+    void executeRead(const QJsonObject &arguments, const ToolCallback &done);
+    QJsonObject formatReadRange(const QString &response);
+    QJsonObject formatReadDelta(const QJsonObject &delta, qint64 sinceRevision, int limit);
+    void executeEdit(const QJsonObject &arguments, const QString &toolCallId, const ToolCallback &done);
+    void executeMultiEdit(const QJsonObject &arguments, const QString &toolCallId, const ToolCallback &done);
+    void executeWrite(const QJsonObject &arguments, const QString &toolCallId, const ToolCallback &done);
+    void executeAskUserQuestion(int id, const QJsonObject &arguments, const ToolCallback &done);
+    QJsonObject formatAskUserAnswer(const QString &responseJson);
+
+    // Deliver a pending DBus call's string reply to callback
+    void watchStringReply(const QDBusPendingCall &call, const ReplyCallback &callback);
 
-    QJsonObject executeDocuments(const QJsonObject &arguments);
-    QJsonObject executeRead(const QJsonObject &arguments);
-    QJsonObject executeEdit(const QJsonObject &arguments);
-    QJsonObject executeWrite(const QJsonObject &arguments);
-    QJsonObject executeAskUserQuestion(const QJsonObject &arguments);
+    // Run a bulk call over the editor socket. NotSent means the socket is
+    // unavailable and the caller should use DBus; after Failed only reads may
+    // be retried, since the editor may already have applied the request.
+    void callEditorSocket(const QString &method, QJsonObject request, const QByteArray &payload,
+                          const EditorSocketClient::Callback &callback);
 
     QJsonObject makeResponse(int id, const QJsonObject &result);
     QJsonObject makeErrorResponse(int id, int code, const QString &message);
     QJsonObject makeErrorResult(const QString &message);
+    // Text result for "OK"/"ERROR: ..." editor replies
+    QJsonObject makeEditorResult(const QString &response);
 
+    KateCodeEditorInterface *m_editor;
+    EditorSocketClient *m_socket;
+    QSet<int> m_activeRequests;  // Tool calls still owed a response
+    QSet<int> m_pendingQuestions;  // Ask-user calls waiting in Kate, keyed by request id
     bool m_initialized = false;
 };
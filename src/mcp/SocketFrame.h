@@ -0,0 +1,74 @@
+/*
+    SPDX-License-Identifier: MIT
+    SPDX-FileCopyrightText: 2025 Kate Code contributors
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+
+// Wire format of the editor socket shared by the plugin and kate-mcp-server.
+//
+// Each frame is: [u32 header length][u32 payload length][header][payload],
+// lengths big-endian. The header is a compact JSON object (method, id and
+// small arguments); the payload carries bulk content as raw UTF-8 so it is
+// never JSON-escaped or marshalled through the bus daemon.
+namespace SocketFrame
+{
+
+// Frames larger than this are treated as a protocol error
+constexpr quint32 MAX_FRAME_SIZE = 512u * 1024u * 1024u;
+constexpr int PREFIX_SIZE = 8;
+
+inline QByteArray encode(const QJsonObject &header, const QByteArray &payload = QByteArray())
+{
+    const QByteArray headerBytes = QJsonDocument(header).toJson(QJsonDocument::Compact);
+
+    QByteArray frame(PREFIX_SIZE, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(headerBytes.size()), frame.data());
+    qToBigEndian<quint32>(quint32(payload.size()), frame.data() + 4);
+    frame.reserve(PREFIX_SIZE + headerBytes.size() + payload.size());
+    frame.append(headerBytes);
+    frame.append(payload);
+    return frame;
+}
+
+enum class DecodeResult {
+    Incomplete,  // Need more bytes
+    Frame,       // One frame taken off the front of the buffer
+    Malformed,   // Oversized or unparsable - drop the connection
+};
+
+inline DecodeResult decode(QByteArray &buffer, QJsonObject *header, QByteArray *payload)
+{
+    if (buffer.size() < PREFIX_SIZE) {
+        return DecodeResult::Incomplete;
+    }
+
+    const quint32 headerSize = qFromBigEndian<quint32>(buffer.constData());
+    const quint32 payloadSize = qFromBigEndian<quint32>(buffer.constData() + 4);
+    if (headerSize > MAX_FRAME_SIZE || payloadSize > MAX_FRAME_SIZE - headerSize) {
+        return DecodeResult::Malformed;
+    }
+
+    const qsizetype frameSize = PREFIX_SIZE + qsizetype(headerSize) + qsizetype(payloadSize);
+    if (buffer.size() < frameSize) {
+        return DecodeResult::Incomplete;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(buffer.mid(PREFIX_SIZE, headerSize), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        return DecodeResult::Malformed;
+    }
+
+    *header = doc.object();
+    *payload = buffer.mid(PREFIX_SIZE + headerSize, payloadSize);
+    buffer.remove(0, frameSize);
+    return DecodeResult::Frame;
+}
+
+} // namespace SocketFrame
@@ -4,7 +4,8 @@
 
     Kate MCP Server - standalone MCP server for Kate editor integration.
     Speaks JSON-RPC 2.0 over stdin/stdout (newline-delimited).
-    Uses QSocketNotifier + event loop so that DBus calls work.
+    Uses QSocketNotifier + event loop so that DBus calls work; requests are
+    handled concurrently and answered out of order, keyed by JSON-RPC id.
 */
 
 #include "MCPServer.h"
@@ -16,6 +17,12 @@
 
 #include <unistd.h>
 
+static void writeResponse(const QJsonObject &response)
+{
+    const QByteArray data = QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n';
+    write(STDOUT_FILENO, data.constData(), data.size());
+}
+
 static void processLine(const QByteArray &line, MCPServer &server)
 {
     const QByteArray trimmed = line.trimmed();
@@ -29,13 +36,7 @@ static void processLine(const QByteArray &line, MCPServer &server)
         return;
     }
 
-    const QJsonObject response = server.handleMessage(doc.object());
-    if (response.isEmpty()) {
-        return;
-    }
-
-    const QByteArray data = QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n';
-    write(STDOUT_FILENO, data.constData(), data.size());
+    server.handleMessage(doc.object());
 }
 
 int main(int argc, char *argv[])
@@ -45,6 +46,9 @@ int main(int argc, char *argv[])
     MCPServer server;
     QByteArray buffer;
 
+    // Tool calls run concurrently; each response is written as soon as it is ready
+    QObject::connect(&server, &MCPServer::responseReady, &writeResponse);
+
     auto *notifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, &app);
     QObject::connect(notifier, &QSocketNotifier::activated, [&]() {
         char buf[4096];
@@ -3,18 +3,34 @@
 #include "../config/KateCodeConfigPage.h"
 #include "../config/SettingsStore.h"
 #include "../mcp/EditorDBusService.h"
+#include "../ui/BlobSchemeHandler.h"
+#include "../util/DocumentIndex.h"
+#include "../util/ProjectFileIndex.h"
+#include "../util/SnapshotStore.h"
 
 #include <KPluginFactory>
 #include <KTextEditor/MainWindow>
 #include <QApplication>
+#include <QDir>
 
 K_PLUGIN_FACTORY_WITH_JSON(KateCodePluginFactory, "katecode.json", registerPlugin<KateCodePlugin>();)
 
 KateCodePlugin::KateCodePlugin(QObject *parent, const QVariantList &)
     : KTextEditor::Plugin(parent)
     , m_settings(new SettingsStore(this))
+    , m_snapshotStore(new SnapshotStore(this))
+    , m_documentIndex(new DocumentIndex(this))
     , m_dbusService(new EditorDBusService(this))
 {
+    // Custom schemes only take effect if registered before QtWebEngine starts.
+    // Normally done at library load already; views check whether it worked.
+    BlobSchemeHandler::registerScheme();
+
+    applySettings();
+    connect(m_settings, &SettingsStore::settingsChanged, this, &KateCodePlugin::applySettings);
+
+    m_dbusService->setSnapshotStore(m_snapshotStore);
+    m_dbusService->setDocumentIndex(m_documentIndex);
     m_dbusService->registerOnBus();
 
     // Connect to application shutdown to trigger summary generation
@@ -35,6 +51,13 @@ void KateCodePlugin::onAboutToQuit()
     qDebug() << "[KateCodePlugin] Shutdown preparation complete";
 }
 
+void KateCodePlugin::applySettings()
+{
+    m_snapshotStore->setBudgets(qint64(m_settings->snapshotMemoryBudgetMB()) * 1024 * 1024,
+                                qint64(m_settings->snapshotDiskBudgetMB()) * 1024 * 1024);
+    m_dbusService->setOpenEditedFiles(m_settings->openEditedFiles());
+}
+
 QObject *KateCodePlugin::createView(KTextEditor::MainWindow *mainWindow)
 {
     auto *view = new KateCodeView(this, mainWindow);
@@ -42,6 +65,34 @@ QObject *KateCodePlugin::createView(KTextEditor::MainWindow *mainWindow)
     return view;
 }
 
+ProjectFileIndex *KateCodePlugin::acquireFileIndex(const QString &root)
+{
+    const QString cleanRoot = QDir::cleanPath(root);
+    auto it = m_fileIndexes.find(cleanRoot);
+    if (it == m_fileIndexes.end()) {
+        auto *index = new ProjectFileIndex(this);
+        index->setRoot(cleanRoot);
+        it = m_fileIndexes.insert(cleanRoot, {index, 0});
+    }
+    ++it->users;
+    return it->index;
+}
+
+void KateCodePlugin::releaseFileIndex(ProjectFileIndex *index)
+{
+    if (!index) {
+        return;
+    }
+    auto it = m_fileIndexes.find(index->root());
+    if (it == m_fileIndexes.end() || it->index != index) {
+        return;
+    }
+    if (--it->users == 0) {
+        m_fileIndexes.erase(it);
+        delete index;
+    }
+}
+
 int KateCodePlugin::configPages() const
 {
     return 1;
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <KTextEditor/Plugin>
+#include <QHash>
 #include <QObject>
 #include <QVariant>
 
+class DocumentIndex;
 class EditorDBusService;
 class KateCodeView;
+class ProjectFileIndex;
 class SettingsStore;
+class SnapshotStore;
 
 class KateCodePlugin : public KTextEditor::Plugin
 {
@@ -28,11 +32,31 @@ public:
     // DBus service access for views (used for question routing)
     EditorDBusService *dbusService() const { return m_dbusService; }
 
+    // Pre/post-edit snapshots shared by all views and the DBus service
+    SnapshotStore *snapshotStore() const { return m_snapshotStore; }
+
+    // Path to open document lookup shared by all views and the DBus service
+    DocumentIndex *documentIndex() const { return m_documentIndex; }
+
+    // Project file index for root, shared by all views on that root. Each
+    // acquire must be paired with a release; the last release deletes it.
+    ProjectFileIndex *acquireFileIndex(const QString &root);
+    void releaseFileIndex(ProjectFileIndex *index);
+
 private Q_SLOTS:
     void onAboutToQuit();
+    void applySettings();
 
 private:
     QList<KateCodeView *> m_views;
     SettingsStore *m_settings;
+    SnapshotStore *m_snapshotStore;
+    DocumentIndex *m_documentIndex;
     EditorDBusService *m_dbusService;
+
+    struct SharedFileIndex {
+        ProjectFileIndex *index;
+        int users;
+    };
+    QHash<QString, SharedFileIndex> m_fileIndexes;  // Clean root path -> index
 };
@@ -5,12 +5,11 @@
 #include "../mcp/EditorDBusService.h"
 #include "../ui/ChatWidget.h"
 #include "../util/DiffHighlightManager.h"
+#include "../util/ProjectFileIndex.h"
 
 #include <KActionCollection>
 #include <KLocalizedString>
-#include <KTextEditor/Application>
 #include <KTextEditor/Document>
-#include <KTextEditor/Editor>
 #include <KTextEditor/View>
 #include <KXMLGUIFactory>
 #include <QAction>
@@ -18,7 +17,6 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QVBoxLayout>
-#include <functional>
 
 KateCodeView::KateCodeView(KateCodePlugin *plugin, KTextEditor::MainWindow *mainWindow)
     : QObject(mainWindow)
@@ -28,16 +26,21 @@ KateCodeView::KateCodeView(KateCodePlugin *plugin, KTextEditor::MainWindow *main
     , m_toolView(nullptr)
     , m_chatWidget(nullptr)
     , m_diffHighlightManager(nullptr)
+    , m_fileIndex(nullptr)
 {
     createToolView();
 
     // Create diff highlight manager for showing pending edits in editor
-    m_diffHighlightManager = new DiffHighlightManager(m_mainWindow, m_plugin->settings(), this);
+    m_diffHighlightManager = new DiffHighlightManager(m_mainWindow, m_plugin->documentIndex(), m_plugin->settings(), this);
 
-    // Editor diff highlighting disabled - diffs are shown inline in tool call UI instead
-    // If re-enabling, connect ChatWidget::toolCallHighlightRequested/toolCallClearRequested
-    // to m_diffHighlightManager->highlightToolCall() and clearToolCallHighlights()
-    Q_UNUSED(m_diffHighlightManager);
+    // Highlight applied edits in the editor until the next prompt. Positions come
+    // from ACP writes (via the session) and MCP edits (via the editor service).
+    connect(m_chatWidget, &ChatWidget::toolCallHighlightRequested,
+            m_diffHighlightManager, &DiffHighlightManager::highlightToolCall);
+    connect(m_chatWidget, &ChatWidget::toolCallClearRequested,
+            m_diffHighlightManager, &DiffHighlightManager::clearToolCallHighlights);
+    connect(m_plugin->dbusService(), &EditorDBusService::editsApplied,
+            m_chatWidget, &ChatWidget::showAppliedEdits);
 
     // Load UI definition file from Qt resources
     setXMLFile(QStringLiteral(":/katecode/katecodeui.rc"));
@@ -99,6 +102,8 @@ KateCodeView::~KateCodeView()
     }
 
     // ToolView is owned by MainWindow and cleaned up automatically
+
+    m_plugin->releaseFileIndex(m_fileIndex);
 }
 
 void KateCodeView::createToolView()
@@ -144,9 +149,17 @@ void KateCodeView::createToolView()
     // Inject settings store for summary generation
     m_chatWidget->setSettingsStore(m_plugin->settings());
 
+    // Inject shared snapshot store for pre-edit snapshots
+    m_chatWidget->setSnapshotStore(m_plugin->snapshotStore());
+
     // Connect edit navigation
     connect(m_chatWidget, &ChatWidget::jumpToEditRequested, this, &KateCodeView::jumpToEdit);
 
+    // Revert files to their snapshot from before the agent's first edit
+    connect(m_chatWidget, &ChatWidget::revertFileRequested, this, [this](const QString &filePath) {
+        m_chatWidget->showRevertResult(filePath, m_plugin->dbusService()->revertToOriginal(filePath));
+    });
+
     // Connect user question signals (MCP AskUserQuestion tool)
     // EditorDBusService -> ChatWidget: show question UI
     connect(m_plugin->dbusService(), &EditorDBusService::questionRequested,
@@ -255,86 +268,34 @@ QString KateCodeView::getProjectRoot() const
     return QFileInfo(filePath).absolutePath();
 }
 
-QStringList KateCodeView::getProjectFiles() const
+QStringList KateCodeView::getProjectFiles()
 {
-    QString projectRoot = getProjectRoot();
-    if (projectRoot.isEmpty()) {
-        return QStringList();
+    const QString root = getProjectRoot();
+    if (root.isEmpty()) {
+        return m_fileIndex ? m_fileIndex->files() : QStringList();
     }
 
-    QStringList files;
-    QDir rootDir(projectRoot);
-
-    // Directories to ignore
-    static const QStringList ignoredDirs = {
-        QStringLiteral(".git"),
-        QStringLiteral(".hg"),
-        QStringLiteral(".svn"),
-        QStringLiteral("node_modules"),
-        QStringLiteral("build"),
-        QStringLiteral("dist"),
-        QStringLiteral("target"),
-        QStringLiteral(".idea"),
-        QStringLiteral(".vscode"),
-        QStringLiteral("__pycache__"),
-        QStringLiteral(".pytest_cache"),
-        QStringLiteral(".tox"),
-        QStringLiteral("venv"),
-        QStringLiteral(".venv"),
-        QStringLiteral("env")
-    };
-
-    // Recursive function to scan directories
-    std::function<void(const QDir &, const QString &)> scanDir = [&](const QDir &dir, const QString &relativePath) {
-        // Get all entries
-        QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-
-        for (const QFileInfo &entry : entries) {
-            QString name = entry.fileName();
-            QString relPath = relativePath.isEmpty() ? name : relativePath + QStringLiteral("/") + name;
-
-            if (entry.isDir()) {
-                // Skip ignored directories
-                if (!ignoredDirs.contains(name)) {
-                    scanDir(QDir(entry.filePath()), relPath);
-                }
-            } else if (entry.isFile()) {
-                files.append(relPath);
-            }
+    // Indexed in the background; the list fills in (and stays current) via the index's signals
+    if (!m_fileIndex || m_fileIndex->root() != QDir::cleanPath(root)) {
+        if (m_fileIndex) {
+            m_fileIndex->disconnect(this);
+            m_plugin->releaseFileIndex(m_fileIndex);
         }
-    };
-
-    scanDir(rootDir, QString());
-
-    qDebug() << "[KateCode] Found" << files.size() << "files in project";
-    return files;
+        m_fileIndex = m_plugin->acquireFileIndex(root);
+
+        connect(m_fileIndex, &ProjectFileIndex::filesChanged, this, [this]() {
+            m_chatWidget->setAvailableFiles(m_fileIndex->files());
+        });
+        connect(m_fileIndex, &ProjectFileIndex::filesUpdated, this, [this](const QStringList &added, const QStringList &removed) {
+            m_chatWidget->updateAvailableFiles(added, removed);
+        });
+    }
+    return m_fileIndex->files();
 }
 
 KTextEditor::Document *KateCodeView::findDocumentByPath(const QString &path) const
 {
-    if (path.isEmpty()) {
-        return nullptr;
-    }
-
-    // Normalize the file path
-    QString normalizedPath = QDir::cleanPath(path);
-    QUrl fileUrl = QUrl::fromLocalFile(normalizedPath);
-
-    // Get all documents from the application
-    KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
-    if (!app) {
-        qWarning() << "[KateCodeView] No KTextEditor application available";
-        return nullptr;
-    }
-
-    const QList<KTextEditor::Document *> docs = app->documents();
-    for (KTextEditor::Document *doc : docs) {
-        if (doc->url() == fileUrl || doc->url().toLocalFile() == normalizedPath) {
-            return doc;
-        }
-    }
-
-    return nullptr;
+    return m_plugin->documentIndex()->find(path);
 }
 
 void KateCodeView::addSelectionToContext()
@@ -451,13 +412,8 @@ void KateCodeView::jumpToEdit(const QString &filePath, int startLine, int endLin
     // Verify we have the right document
     if (view->document()->url().toLocalFile() != filePath) {
         // Try to find the right view
-        KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
-        const QList<KTextEditor::Document *> docs = app->documents();
-        for (KTextEditor::Document *doc : docs) {
-            if (doc->url().toLocalFile() == filePath) {
-                view = m_mainWindow->activateView(doc);
-                break;
-            }
+        if (KTextEditor::Document *doc = findDocumentByPath(filePath)) {
+            view = m_mainWindow->activateView(doc);
         }
     }
 
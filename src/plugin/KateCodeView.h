@@ -8,6 +8,7 @@
 class KateCodePlugin;
 class ChatWidget;
 class DiffHighlightManager;
+class ProjectFileIndex;
 class QWidget;
 
 class KateCodeView : public QObject, public KXMLGUIClient
@@ -22,7 +23,7 @@ public:
     QString getCurrentFilePath() const;
     QString getCurrentSelection() const;
     QString getProjectRoot() const;
-    QStringList getProjectFiles() const;
+    QStringList getProjectFiles();
     KTextEditor::Document *findDocumentByPath(const QString &path) const;
 
     // Shutdown hook for summary generation
@@ -49,4 +50,5 @@ private:
     QWidget *m_toolView;
     ChatWidget *m_chatWidget;
     DiffHighlightManager *m_diffHighlightManager;
+    ProjectFileIndex *m_fileIndex;  // Shared through the plugin, for the current root
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "BlobSchemeHandler.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QUrl>
+#include <QWebEngineProfile>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+namespace {
+
+const QByteArray SCHEME = QByteArrayLiteral("katecode");
+const QLatin1String BLOB_HOST("blob");
+
+// Blob id from katecode://blob/<id>, or 0
+quint64 blobId(const QUrl &url)
+{
+    if (url.scheme() != QLatin1String(SCHEME) || url.host() != BLOB_HOST) {
+        return 0;
+    }
+    bool ok = false;
+    const quint64 id = url.path().mid(1).toULongLong(&ok);
+    return ok ? id : 0;
+}
+
+} // namespace
+
+BlobSchemeHandler::BlobSchemeHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+{
+}
+
+void BlobSchemeHandler::registerScheme()
+{
+    if (isSchemeRegistered()) {
+        return;
+    }
+
+    QWebEngineUrlScheme scheme(SCHEME);
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    QWebEngineUrlScheme::Flags flags = QWebEngineUrlScheme::SecureScheme
+                                     | QWebEngineUrlScheme::LocalAccessAllowed
+                                     | QWebEngineUrlScheme::CorsEnabled;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    flags |= QWebEngineUrlScheme::FetchApiAllowed;
+#endif
+    scheme.setFlags(flags);
+    // Ignored (with a warning from Qt) once QtWebEngine is running
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+// Runs as soon as the plugin library is loaded, ahead of the plugin constructor
+static void registerBlobScheme()
+{
+    BlobSchemeHandler::registerScheme();
+}
+Q_COREAPP_STARTUP_FUNCTION(registerBlobScheme)
+
+bool BlobSchemeHandler::isSchemeRegistered()
+{
+    return QWebEngineUrlScheme::schemeByName(SCHEME).name() == SCHEME;
+}
+
+bool BlobSchemeHandler::canFetch()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    return isSchemeRegistered();
+#else
+    return false;
+#endif
+}
+
+BlobSchemeHandler *BlobSchemeHandler::forProfile(QWebEngineProfile *profile)
+{
+    // Several main windows share the default profile, which allows one handler per scheme
+    const auto *installed = qobject_cast<const BlobSchemeHandler *>(profile->urlSchemeHandler(SCHEME));
+    if (installed) {
+        return const_cast<BlobSchemeHandler *>(installed);
+    }
+
+    auto *handler = new BlobSchemeHandler(profile);
+    profile->installUrlSchemeHandler(SCHEME, handler);
+    return handler;
+}
+
+QString BlobSchemeHandler::store(const QByteArray &data, const QByteArray &mimeType)
+{
+    const quint64 id = m_nextId++;
+    m_blobs.insert(id, {data, mimeType});
+    return QStringLiteral("katecode://blob/%1").arg(id);
+}
+
+void BlobSchemeHandler::release(const QString &url)
+{
+    m_blobs.remove(blobId(QUrl(url)));
+}
+
+void BlobSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    auto it = m_blobs.constFind(blobId(job->requestUrl()));
+    if (it == m_blobs.constEnd()) {
+        qDebug() << "[BlobSchemeHandler] Unknown blob:" << job->requestUrl();
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    // The page is served from qrc:, so fetch() needs CORS consent
+    QMultiMap<QByteArray, QByteArray> headers;
+    headers.insert(QByteArrayLiteral("Access-Control-Allow-Origin"), QByteArrayLiteral("*"));
+    job->setAdditionalResponseHeaders(headers);
+#endif
+
+    auto *buffer = new QBuffer(job);
+    buffer->setData(it->data);
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(it->mimeType, buffer);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QWebEngineUrlSchemeHandler>
+
+class QWebEngineProfile;
+
+/**
+ * BlobSchemeHandler - Serves large chat payloads to the page on demand.
+ *
+ * Attached images, long tool output and terminal logs are kept here, and the
+ * page gets katecode://blob/<id> URLs instead of the bytes, so items that
+ * are never expanded never load them. One handler is shared by all chat
+ * views on a profile; each view releases the blobs it stored.
+ */
+class BlobSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+    // Must run before QtWebEngine initializes, i.e. before the first web view.
+    // Also runs when the plugin library is loaded, the earliest point we get.
+    static void registerScheme();
+
+    // Whether the scheme is registered, i.e. registerScheme() was early enough.
+    // Without it the page can't load blob URLs at all.
+    static bool isSchemeRegistered();
+
+    // Whether the page can fetch() blob URLs, which needs a registered scheme
+    // and CORS headers on the reply (Qt 6.6). Otherwise blobs only work as
+    // <img> sources and text has to go inline.
+    static bool canFetch();
+
+    // The handler installed on profile, installing one if needed
+    static BlobSchemeHandler *forProfile(QWebEngineProfile *profile);
+
+    // Keep data and return the URL the page can load it from
+    QString store(const QByteArray &data, const QByteArray &mimeType);
+    void release(const QString &url);
+
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+    explicit BlobSchemeHandler(QObject *parent = nullptr);
+
+    struct Blob {
+        QByteArray data;
+        QByteArray mimeType;
+    };
+
+    QHash<quint64, Blob> m_blobs;
+    quint64 m_nextId = 1;
+};
@@ -1,4 +1,5 @@
 #include "ChatInputWidget.h"
+#include "../util/AsyncFileMatcher.h"
 
 #include <QAbstractItemView>
 #include <QBuffer>
@@ -25,7 +26,10 @@
 
 CommandTextEdit::CommandTextEdit(QWidget *parent)
     : QTextEdit(parent)
+    , m_fileModel(new QStringListModel(this))
+    , m_fileMatcher(new AsyncFileMatcher(this))
 {
+    connect(m_fileMatcher, &AsyncFileMatcher::matched, this, &CommandTextEdit::onFilesMatched);
 }
 
 void CommandTextEdit::setCompleter(QCompleter *completer)
@@ -48,10 +52,19 @@ void CommandTextEdit::setCompleter(QCompleter *completer)
             this, &CommandTextEdit::insertCompletion);
 }
 
-void CommandTextEdit::setModels(QAbstractItemModel *commandModel, QAbstractItemModel *fileModel)
+void CommandTextEdit::setCommandModel(QAbstractItemModel *commandModel)
 {
     m_commandModel = commandModel;
-    m_fileModel = fileModel;
+}
+
+void CommandTextEdit::setFiles(const QStringList &files)
+{
+    m_fileMatcher->setFiles(files);
+}
+
+void CommandTextEdit::updateFiles(const QStringList &added, const QStringList &removed)
+{
+    m_fileMatcher->updateFiles(added, removed);
 }
 
 void CommandTextEdit::keyPressEvent(QKeyEvent *e)
@@ -111,30 +124,58 @@ void CommandTextEdit::keyPressEvent(QKeyEvent *e)
         // Switch completer model based on context type
         if (ctx.type == Command && m_commandModel) {
             m_completer->setModel(m_commandModel);
+            m_completer->setCompletionMode(QCompleter::PopupCompletion);
+            m_completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
             m_completer->setFilterMode(Qt::MatchStartsWith);  // Commands match at start
-        } else if (ctx.type == File && m_fileModel) {
-            m_completer->setModel(m_fileModel);
-            m_completer->setFilterMode(Qt::MatchContains);  // Files match anywhere (contains)
+        } else if (ctx.type == File && m_fileMatcher->fileCount() > 0) {
+            // Files are matched on a worker thread; the popup reopens in onFilesMatched().
+            // Until then its entries answer the previous query and must not be picked.
+            m_completer->popup()->hide();
+            m_fileMatcher->match(ctx.filterText, MAX_FILE_MATCHES);
+            return;
         } else {
             // No model available for this context
             m_completer->popup()->hide();
             return;
         }
 
-        m_completer->setCompletionPrefix(ctx.filterText);
+        showCompletionPopup(ctx);
+    } else {
+        m_completer->popup()->hide();
+    }
+}
 
-        if (m_completer->completionCount() > 0 || ctx.filterText.isEmpty()) {
-            // Position popup at cursor
-            QRect cr = cursorRect();
-            cr.setWidth(m_completer->popup()->sizeHintForColumn(0) +
-                       m_completer->popup()->verticalScrollBar()->sizeHint().width());
-            m_completer->complete(cr);
+void CommandTextEdit::onFilesMatched(quint64 generation, const QString &query, const QStringList &paths)
+{
+    Q_UNUSED(generation);
 
-            // Autoselect the first entry
-            m_completer->popup()->setCurrentIndex(m_completer->completionModel()->index(0, 0));
-        } else {
-            m_completer->popup()->hide();
-        }
+    // The cursor may have left the '@' reference while matching ran
+    const CompletionContext ctx = completionUnderCursor();
+    if (!m_completer || ctx.type != File || ctx.filterText != query) {
+        return;
+    }
+
+    // Files are fuzzy-matched and ranked already; the completer shows them as-is
+    m_fileModel->setStringList(paths);
+    m_completer->setModel(m_fileModel);
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_completer->setModelSorting(QCompleter::UnsortedModel);
+    showCompletionPopup(ctx);
+}
+
+void CommandTextEdit::showCompletionPopup(const CompletionContext &ctx)
+{
+    m_completer->setCompletionPrefix(ctx.filterText);
+
+    if (m_completer->completionCount() > 0 || ctx.filterText.isEmpty()) {
+        // Position popup at cursor
+        QRect cr = cursorRect();
+        cr.setWidth(m_completer->popup()->sizeHintForColumn(0) +
+                   m_completer->popup()->verticalScrollBar()->sizeHint().width());
+        m_completer->complete(cr);
+
+        // Autoselect the first entry
+        m_completer->popup()->setCurrentIndex(m_completer->completionModel()->index(0, 0));
     } else {
         m_completer->popup()->hide();
     }
@@ -192,6 +233,7 @@ void CommandTextEdit::insertCompletion(const QString &completion)
     } else if (ctx.type == File) {
         // Insert the file reference with '@' prefix
         tc.insertText(QStringLiteral("@") + completion);
+        m_fileMatcher->recordUse(completion);
     }
 
     setTextCursor(tc);
@@ -487,27 +529,23 @@ void ChatInputWidget::setAvailableCommands(const QList<SlashCommand> &commands)
     m_commandModel = new QStringListModel(displayList, this);
 
     // Update models in text edit
-    m_textEdit->setModels(m_commandModel, m_fileModel);
+    m_textEdit->setCommandModel(m_commandModel);
 
     qDebug() << "[ChatInputWidget] Loaded" << commands.size() << "slash commands for QCompleter";
 }
 
 void ChatInputWidget::setAvailableFiles(const QStringList &files)
 {
-    m_availableFiles = files;
-
-    // Create/update file model
-    if (m_fileModel) {
-        delete m_fileModel;
-    }
-    m_fileModel = new QStringListModel(files, this);
-
-    // Update models in text edit
-    m_textEdit->setModels(m_commandModel, m_fileModel);
+    m_textEdit->setFiles(files);
 
     qDebug() << "[ChatInputWidget] Loaded" << files.size() << "files for @-completion";
 }
 
+void ChatInputWidget::updateAvailableFiles(const QStringList &added, const QStringList &removed)
+{
+    m_textEdit->updateFiles(added, removed);
+}
+
 void ChatInputWidget::setPromptRunning(bool running)
 {
     m_promptRunning = running;
@@ -4,10 +4,12 @@
 #include <QWidget>
 #include <QTextEdit>
 
+class AsyncFileMatcher;
 class QJsonArray;
 class QPushButton;
 class QComboBox;
 class QCompleter;
+class QStringListModel;
 
 // Custom QTextEdit that handles QCompleter for slash commands and file references
 class QAbstractItemModel;
@@ -18,7 +20,9 @@ class CommandTextEdit : public QTextEdit
 public:
     explicit CommandTextEdit(QWidget *parent = nullptr);
     void setCompleter(QCompleter *completer);
-    void setModels(QAbstractItemModel *commandModel, QAbstractItemModel *fileModel);
+    void setCommandModel(QAbstractItemModel *commandModel);
+    void setFiles(const QStringList &files);
+    void updateFiles(const QStringList &added, const QStringList &removed);
     QCompleter *completer() const { return m_completer; }
 
 Q_SIGNALS:
@@ -31,6 +35,7 @@ protected:
 
 private Q_SLOTS:
     void insertCompletion(const QString &completion);
+    void onFilesMatched(quint64 generation, const QString &query, const QStringList &paths);
 
 private:
     enum CompletionType {
@@ -47,9 +52,13 @@ private:
     };
 
     CompletionContext completionUnderCursor() const;
+    void showCompletionPopup(const CompletionContext &ctx);
     QCompleter *m_completer = nullptr;
     QAbstractItemModel *m_commandModel = nullptr;
-    QAbstractItemModel *m_fileModel = nullptr;
+    QStringListModel *m_fileModel;  // Ranked matches for the current '@' query
+    AsyncFileMatcher *m_fileMatcher;  // Ranks project files for '@' queries off the UI thread
+
+    static const int MAX_FILE_MATCHES = 50;
 };
 
 class ChatInputWidget : public QWidget
@@ -69,6 +78,7 @@ public:
     void setCurrentMode(const QString &modeId);
     void setAvailableCommands(const QList<SlashCommand> &commands);
     void setAvailableFiles(const QStringList &files);
+    void updateAvailableFiles(const QStringList &added, const QStringList &removed);
     void setPromptRunning(bool running);
 
 Q_SIGNALS:
@@ -94,9 +104,7 @@ private:
     bool m_promptRunning = false;
     QCompleter *m_completer;
     QList<SlashCommand> m_availableCommands;
-    QStringList m_availableFiles;
 
-    // Models for completer (switched based on context)
+    // Slash command model for the completer (files are matched by the text edit)
     QAbstractItemModel *m_commandModel = nullptr;
-    QAbstractItemModel *m_fileModel = nullptr;
 };
@@ -1,19 +1,29 @@
 #include "ChatWebView.h"
+#include "BlobSchemeHandler.h"
+#include "../util/CodeHighlighter.h"
 #include "../util/KDEColorScheme.h"
 #include "../util/KateThemeConverter.h"
 
 #include <QDebug>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QTimer>
 #include <QWebChannel>
 #include <QWebEnginePage>
+#include <QWebEngineProfile>
 #include <QWebEngineSettings>
 
 ChatWebView::ChatWebView(QWidget *parent)
     : QWebEngineView(parent)
     , m_isLoaded(false)
     , m_bridge(new WebBridge(this))
+    , m_flushTimer(new QTimer(this))
+    , m_highlighter(new CodeHighlighter(this))
 {
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &ChatWebView::flushUpdates);
+
     // Configure settings
     settings()->setAttribute(QWebEngineSettings::JavascriptEnabled, true);
     settings()->setAttribute(QWebEngineSettings::LocalStorageEnabled, true);
@@ -23,6 +33,14 @@ ChatWebView::ChatWebView(QWidget *parent)
 
     // Setup web channel for JavaScript <-> C++ communication
     setupBridge();
+    // Registration fails if QtWebEngine was already running when the plugin
+    // loaded; images then go as data: URLs and text inline
+    if (BlobSchemeHandler::isSchemeRegistered()) {
+        m_blobs = BlobSchemeHandler::forProfile(page()->profile());
+        m_blobText = BlobSchemeHandler::canFetch();
+    } else {
+        qWarning() << "[ChatWebView] katecode:// scheme not registered, sending chat payloads inline";
+    }
 
     // Load the chat HTML
     setUrl(QUrl(QStringLiteral("qrc:/katecode/web/chat.html")));
@@ -30,6 +48,21 @@ ChatWebView::ChatWebView(QWidget *parent)
     connect(this, &QWebEngineView::loadFinished, this, &ChatWebView::onLoadFinished);
     connect(m_bridge, &WebBridge::permissionResponse, this, &ChatWebView::permissionResponseReady);
     connect(m_bridge, &WebBridge::jumpToEditRequested, this, &ChatWebView::jumpToEditRequested);
+    connect(m_bridge, &WebBridge::revertFileRequested, this, &ChatWebView::revertFileRequested);
+    connect(m_bridge, &WebBridge::pageReady, this, [this]() {
+        // Updates queued since page load can go out now
+        qDebug() << "[ChatWebView] Page connected to web channel";
+        m_channelReady = true;
+        flushUpdates();
+    });
+    connect(m_bridge, &WebBridge::highlightRequested, m_highlighter, &CodeHighlighter::highlight);
+    connect(m_highlighter, &CodeHighlighter::highlighted, this, [this](int requestId, const QString &html) {
+        QJsonObject data;
+        data[QStringLiteral("requestId")] = requestId;
+        // null tells the page to fall back to highlight.js
+        data[QStringLiteral("html")] = html.isNull() ? QJsonValue() : QJsonValue(html);
+        push(QStringLiteral("highlightResult"), data);
+    });
     connect(m_bridge, &WebBridge::questionAnswersSubmitted, this, [this](const QString &requestId, const QString &answersJson) {
         QJsonDocument doc = QJsonDocument::fromJson(answersJson.toUtf8());
         Q_EMIT userQuestionAnswered(requestId, doc.object());
@@ -38,6 +71,7 @@ ChatWebView::ChatWebView(QWidget *parent)
 
 ChatWebView::~ChatWebView()
 {
+    releaseAllBlobs();
 }
 
 void ChatWebView::onLoadFinished(bool ok)
@@ -69,6 +103,7 @@ void ChatWebView::injectColorScheme()
 
     // Try to load Kate's current theme for syntax highlighting
     QString kateThemeCSS = KateThemeConverter::getCurrentThemeCSS();
+    m_highlighter->setTheme(KateThemeConverter::getCurrentKateTheme(), isLight);
 
     QString hljsTheme;
     QString codeBg;
@@ -109,13 +144,6 @@ void ChatWebView::injectColorScheme()
         // Terminal text color: dark text on light backgrounds, light text on dark backgrounds
         QString terminalFg = isLight ? QStringLiteral("#1e1e1e") : QStringLiteral("#e0e0e0");
 
-        // Escape the CSS for JavaScript string literal
-        QString escapedCSS = kateThemeCSS;
-        escapedCSS.replace(QLatin1Char('\\'), QStringLiteral("\\\\"));
-        escapedCSS.replace(QLatin1Char('\''), QStringLiteral("\\'"));
-        escapedCSS.replace(QLatin1Char('\n'), QStringLiteral("\\n"));
-        escapedCSS.replace(QLatin1Char('\r'), QStringLiteral("\\r"));
-
         // Add code background and font variables to CSS vars
         // Don't quote font family here - quotes will be added in CSS usage
         QString fullCssVars = cssVars + QStringLiteral("; --code-bg: %1; --inline-code-bg: %2; --code-font-family: %3; --code-font-size: %4px; --task-purple: %5; --task-purple-bg: %6; --terminal-fg: %7")
@@ -123,12 +151,10 @@ void ChatWebView::injectColorScheme()
                                             .arg(fontSize)
                                             .arg(taskPurple, taskPurpleBg, terminalFg);
 
-        QString script = QStringLiteral(
-            "applyColorScheme('%1'); "
-            "applyCustomHighlightCSS('%2');"
-        ).arg(fullCssVars, escapedCSS);
-
-        runJavaScript(script);
+        QJsonObject data;
+        data[QStringLiteral("cssVars")] = fullCssVars;
+        data[QStringLiteral("highlightCss")] = kateThemeCSS;
+        push(QStringLiteral("colorScheme"), data);
     } else {
         // Fallback to bundled highlight.js themes
         qDebug() << "[ChatWebView] Kate theme not available, using fallback";
@@ -152,12 +178,10 @@ void ChatWebView::injectColorScheme()
                                             .arg(fontSize)
                                             .arg(taskPurple, taskPurpleBg, terminalFg);
 
-        QString script = QStringLiteral(
-            "applyColorScheme('%1'); "
-            "applyHighlightTheme('%2');"
-        ).arg(fullCssVars, hljsTheme);
-
-        runJavaScript(script);
+        QJsonObject data;
+        data[QStringLiteral("cssVars")] = fullCssVars;
+        data[QStringLiteral("highlightTheme")] = hljsTheme;
+        push(QStringLiteral("colorScheme"), data);
     }
 
     qDebug() << "[ChatWebView] Injected KDE color scheme and syntax highlighting";
@@ -170,36 +194,32 @@ void ChatWebView::addMessage(const Message &message)
         return;
     }
 
-    QString timestamp = message.timestamp.toString(Qt::ISODate);
-
-    // Build images JSON array for user messages with attachments
-    QString imagesJson = QStringLiteral("[]");
-    if (!message.images.isEmpty()) {
-        QJsonArray imagesArray;
-        for (const ImageAttachment &img : message.images) {
-            QJsonObject imgObj;
-            imgObj[QStringLiteral("data")] = QString::fromLatin1(img.data.toBase64());
-            imgObj[QStringLiteral("mimeType")] = img.mimeType;
-            imgObj[QStringLiteral("width")] = img.dimensions.width();
-            imgObj[QStringLiteral("height")] = img.dimensions.height();
-            imagesArray.append(imgObj);
+    // Images are served from the blob store; the page only gets their URLs
+    QJsonArray imagesArray;
+    for (const ImageAttachment &img : message.images) {
+        QJsonObject imgObj;
+        if (m_blobs) {
+            const QString url = m_blobs->store(img.data, img.mimeType.toUtf8());
+            m_blobUrls.insert(url);
+            imgObj[QStringLiteral("url")] = url;
+        } else {
+            imgObj[QStringLiteral("url")] = QStringLiteral("data:%1;base64,%2")
+                                                .arg(img.mimeType, QString::fromLatin1(img.data.toBase64()));
         }
-        imagesJson = QString::fromUtf8(QJsonDocument(imagesArray).toJson(QJsonDocument::Compact));
+        imgObj[QStringLiteral("mimeType")] = img.mimeType;
+        imgObj[QStringLiteral("width")] = img.dimensions.width();
+        imgObj[QStringLiteral("height")] = img.dimensions.height();
+        imagesArray.append(imgObj);
     }
 
-    // Use Base64 encoding to safely pass images JSON through JavaScript
-    QString imagesBase64 = QString::fromLatin1(imagesJson.toUtf8().toBase64());
-
-    QString script = QStringLiteral(
-        "addMessage('%1', '%2', '%3', '%4', %5, JSON.parse(atob('%6')));"
-    ).arg(escapeJsString(message.id),
-          escapeJsString(message.role),
-          escapeJsString(message.content),
-          timestamp,
-          message.isStreaming ? QStringLiteral("true") : QStringLiteral("false"),
-          imagesBase64);
-
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("id")] = message.id;
+    data[QStringLiteral("role")] = message.role;
+    data[QStringLiteral("content")] = message.content;
+    data[QStringLiteral("timestamp")] = message.timestamp.toString(Qt::ISODate);
+    data[QStringLiteral("isStreaming")] = message.isStreaming;
+    data[QStringLiteral("images")] = imagesArray;
+    push(QStringLiteral("addMessage"), data);
 }
 
 void ChatWebView::updateMessage(const QString &messageId, const QString &content)
@@ -209,32 +229,36 @@ void ChatWebView::updateMessage(const QString &messageId, const QString &content
         return;
     }
 
-    qDebug() << "[ChatWebView] Updating message:" << messageId << "with" << content.length() << "chars";
-
-    QString script = QStringLiteral("updateMessage('%1', '%2');")
-                         .arg(escapeJsString(messageId),
-                              escapeJsString(content));
+    // Consecutive chunks for the same message go out as one update
+    if (!m_pendingUpdates.isEmpty()) {
+        PendingUpdate &last = m_pendingUpdates.last();
+        if (last.kind == PendingUpdate::MessageChunk && last.messageId == messageId) {
+            last.text += content;
+            return;
+        }
+    }
 
-    runJavaScript(script);
+    PendingUpdate update;
+    update.kind = PendingUpdate::MessageChunk;
+    update.messageId = messageId;
+    update.text = content;
+    enqueue(update);
 }
 
 void ChatWebView::finishMessage(const QString &messageId)
 {
     if (!m_isLoaded) return;
 
-    QString script = QStringLiteral("finishMessage('%1');")
-                         .arg(escapeJsString(messageId));
-
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("messageId")] = messageId;
+    push(QStringLiteral("finishMessage"), data);
+    flushUpdates();
 }
 
 void ChatWebView::addToolCall(const QString &messageId, const ToolCall &toolCall)
 {
     if (!m_isLoaded) return;
 
-    QString inputJson = QString::fromUtf8(QJsonDocument(toolCall.input).toJson(QJsonDocument::Compact));
-
-    // Serialize edits array to JSON
     QJsonArray editsArray;
     for (const EditDiff &edit : toolCall.edits) {
         QJsonObject editObj;
@@ -243,41 +267,64 @@ void ChatWebView::addToolCall(const QString &messageId, const ToolCall &toolCall
         editObj[QStringLiteral("filePath")] = edit.filePath;
         editsArray.append(editObj);
     }
-    QString editsJson = QString::fromUtf8(QJsonDocument(editsArray).toJson(QJsonDocument::Compact));
 
-    // Build script with all 10 arguments including terminalId
-    QString script = QStringLiteral("addToolCall('%1', '%2', '%3', '%4', '%5', '%6', '%7', '%8', '%9', '%10');")
-                         .arg(escapeJsString(messageId),
-                              escapeJsString(toolCall.id),
-                              escapeJsString(toolCall.name),
-                              escapeJsString(toolCall.status),
-                              escapeJsString(toolCall.filePath),
-                              escapeJsString(inputJson),
-                              escapeJsString(toolCall.oldText),
-                              escapeJsString(toolCall.newText),
-                              escapeJsString(editsJson),
-                              escapeJsString(toolCall.terminalId));
-
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("messageId")] = messageId;
+    data[QStringLiteral("toolCallId")] = toolCall.id;
+    data[QStringLiteral("name")] = toolCall.name;
+    data[QStringLiteral("status")] = toolCall.status;
+    data[QStringLiteral("filePath")] = toolCall.filePath;
+    data[QStringLiteral("input")] = toolCall.input;
+    data[QStringLiteral("oldText")] = toolCall.oldText;
+    data[QStringLiteral("newText")] = textOrBlob(toolCall.newText);
+    data[QStringLiteral("edits")] = editsArray;
+    data[QStringLiteral("terminalId")] = toolCall.terminalId;
+    push(QStringLiteral("addToolCall"), data, toolCall.id);
 }
 
 void ChatWebView::updateToolCall(const QString &messageId, const QString &toolCallId, const QString &status, const QString &result, const QString &filePath, const QString &toolName)
 {
     if (!m_isLoaded) return;
 
-    // Base64 encode result to safely pass ANSI escape codes and other special characters
-    QByteArray resultBytes = result.toUtf8();
-    QString base64Result = QString::fromLatin1(resultBytes.toBase64());
-
-    QString script = QStringLiteral("updateToolCall('%1', '%2', '%3', '%4', '%5', '%6');")
-                         .arg(escapeJsString(messageId),
-                              escapeJsString(toolCallId),
-                              escapeJsString(status),
-                              base64Result,
-                              escapeJsString(filePath),
-                              escapeJsString(toolName));
+    // Merge into a queued update for the same tool call, unless the tool call
+    // was (re)added after it. Empty fields don't overwrite, as in the page.
+    for (int i = m_pendingUpdates.size() - 1; i >= 0; --i) {
+        PendingUpdate &pending = m_pendingUpdates[i];
+        if (pending.kind == PendingUpdate::MessageChunk && pending.messageId == messageId) {
+            // Merging would move this update ahead of text queued since; for a
+            // tool call the page hasn't seen, that records its position too early
+            break;
+        }
+        if (pending.toolCallId != toolCallId) {
+            continue;
+        }
+        if (pending.kind == PendingUpdate::ToolCallUpdate) {
+            if (!status.isEmpty()) {
+                pending.status = status;
+            }
+            if (!result.isEmpty()) {
+                pending.text = result;
+            }
+            if (!filePath.isEmpty()) {
+                pending.filePath = filePath;
+            }
+            if (!toolName.isEmpty()) {
+                pending.toolName = toolName;
+            }
+            return;
+        }
+        break;
+    }
 
-    runJavaScript(script);
+    PendingUpdate update;
+    update.kind = PendingUpdate::ToolCallUpdate;
+    update.messageId = messageId;
+    update.toolCallId = toolCallId;
+    update.status = status;
+    update.text = result;
+    update.filePath = filePath;
+    update.toolName = toolName;
+    enqueue(update);
 }
 
 void ChatWebView::showPermissionRequest(const PermissionRequest &request)
@@ -296,30 +343,12 @@ void ChatWebView::showPermissionRequest(const PermissionRequest &request)
         optionsJson.append(option);
     }
 
-    QByteArray inputJsonBytes = QJsonDocument(request.input).toJson(QJsonDocument::Compact);
-    QByteArray optionsJsonBytes = QJsonDocument(optionsJson).toJson(QJsonDocument::Compact);
-
-    // Use Base64 encoding to safely pass JSON through JavaScript string literals
-    // This avoids all escaping issues with special characters, newlines, etc.
-    QString inputBase64 = QString::fromLatin1(inputJsonBytes.toBase64());
-    QString optionsBase64 = QString::fromLatin1(optionsJsonBytes.toBase64());
-
-    qDebug() << "[ChatWebView] Input JSON length:" << inputJsonBytes.length() << "Base64:" << inputBase64.length();
-
-    QString script = QStringLiteral(
-        "try { "
-        "  window._permInput = JSON.parse(atob('%1')); "
-        "  window._permOptions = JSON.parse(atob('%2')); "
-        "  showPermissionRequest(%3, '%4', window._permInput, window._permOptions); "
-        "} catch(e) { "
-        "  console.error('Permission request error:', e); "
-        "}"
-    ).arg(inputBase64)
-     .arg(optionsBase64)
-     .arg(request.requestId)
-     .arg(escapeJsString(request.toolName));
-
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("requestId")] = request.requestId;
+    data[QStringLiteral("toolName")] = request.toolName;
+    data[QStringLiteral("input")] = request.input;
+    data[QStringLiteral("options")] = optionsJson;
+    push(QStringLiteral("permissionRequest"), data);
 }
 
 void ChatWebView::showUserQuestion(const QString &requestId, const QString &questionsJson)
@@ -331,19 +360,17 @@ void ChatWebView::showUserQuestion(const QString &requestId, const QString &ques
         return;
     }
 
-    // Use Base64 encoding to safely pass JSON through JavaScript
-    QString base64Questions = QString::fromLatin1(questionsJson.toUtf8().toBase64());
-
-    QString script = QStringLiteral(
-        "try { "
-        "  var questions = JSON.parse(atob('%1')); "
-        "  showUserQuestion('%2', questions); "
-        "} catch(e) { "
-        "  console.error('User question error:', e); "
-        "}"
-    ).arg(base64Questions, escapeJsString(requestId));
+    QJsonParseError parseError;
+    const QJsonDocument questions = QJsonDocument::fromJson(questionsJson.toUtf8(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        qWarning() << "[ChatWebView] Invalid questions JSON:" << parseError.errorString();
+        return;
+    }
 
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("requestId")] = requestId;
+    data[QStringLiteral("questions")] = questions.isArray() ? QJsonValue(questions.array()) : QJsonValue(questions.object());
+    push(QStringLiteral("userQuestion"), data);
 }
 
 void ChatWebView::removeUserQuestion(const QString &requestId)
@@ -354,8 +381,9 @@ void ChatWebView::removeUserQuestion(const QString &requestId)
         return;
     }
 
-    QString script = QStringLiteral("removeUserQuestion('%1');").arg(escapeJsString(requestId));
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("requestId")] = requestId;
+    push(QStringLiteral("removeUserQuestion"), data);
 }
 
 void ChatWebView::updateTodos(const QList<TodoItem> &todos)
@@ -371,46 +399,50 @@ void ChatWebView::updateTodos(const QList<TodoItem> &todos)
         todosArray.append(todoObj);
     }
 
-    QString todosJson = QString::fromUtf8(QJsonDocument(todosArray).toJson(QJsonDocument::Compact));
-
-    QString script = QStringLiteral("updateTodos('%1');")
-                         .arg(escapeJsString(todosJson));
-
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("todos")] = todosArray;
+    push(QStringLiteral("updateTodos"), data);
 }
 
 void ChatWebView::clearMessages()
 {
     if (!m_isLoaded) return;
-    runJavaScript(QStringLiteral("clearMessages();"));
+    push(QStringLiteral("clearMessages"), QJsonObject());
+    flushUpdates();
+    releaseAllBlobs();
 }
 
 void ChatWebView::updateTerminalOutput(const QString &terminalId, const QString &output, bool finished)
 {
     if (!m_isLoaded) return;
 
-    // Base64 encode to safely pass terminal output with ANSI codes
-    QByteArray outputBytes = output.toUtf8();
-    QString base64Output = QString::fromLatin1(outputBytes.toBase64());
-
-    QString script = QStringLiteral("updateTerminal('%1', '%2', %3);")
-        .arg(escapeJsString(terminalId),
-             base64Output,
-             finished ? QStringLiteral("true") : QStringLiteral("false"));
+    // Output is the whole terminal so far, so a newer snapshot replaces a queued one
+    for (int i = m_pendingUpdates.size() - 1; i >= 0; --i) {
+        PendingUpdate &pending = m_pendingUpdates[i];
+        if (pending.kind == PendingUpdate::TerminalOutput && pending.terminalId == terminalId) {
+            pending.text = output;
+            pending.finished = finished;
+            return;
+        }
+    }
 
-    runJavaScript(script);
+    PendingUpdate update;
+    update.kind = PendingUpdate::TerminalOutput;
+    update.terminalId = terminalId;
+    update.text = output;
+    update.finished = finished;
+    enqueue(update);
 }
 
 void ChatWebView::setToolCallTerminalId(const QString &messageId, const QString &toolCallId, const QString &terminalId)
 {
     if (!m_isLoaded) return;
 
-    QString script = QStringLiteral("setToolCallTerminalId('%1', '%2', '%3');")
-        .arg(escapeJsString(messageId),
-             escapeJsString(toolCallId),
-             escapeJsString(terminalId));
-
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("messageId")] = messageId;
+    data[QStringLiteral("toolCallId")] = toolCallId;
+    data[QStringLiteral("terminalId")] = terminalId;
+    push(QStringLiteral("setToolCallTerminalId"), data, toolCallId);
 }
 
 void ChatWebView::setupBridge()
@@ -420,30 +452,117 @@ void ChatWebView::setupBridge()
     page()->setWebChannel(channel);
 }
 
-void ChatWebView::runJavaScript(const QString &script)
+void ChatWebView::push(const QString &type, const QJsonObject &data, const QString &toolCallId)
 {
-    page()->runJavaScript(script, [script](const QVariant &result) {
-        Q_UNUSED(result);
-        qDebug() << "[ChatWebView] JS executed:" << script.left(100);
-    });
+    PendingUpdate update;
+    update.data = data;
+    update.data[QStringLiteral("type")] = type;
+    update.toolCallId = toolCallId;  // Keeps later tool call updates from merging across it
+    enqueue(update);
 }
 
-QString ChatWebView::escapeJsString(const QString &str)
+void ChatWebView::enqueue(const PendingUpdate &update)
 {
-    QString escaped = str;
-    // Order matters: backslash must be first
-    escaped.replace(QLatin1Char('\\'), QStringLiteral("\\\\"));
-    escaped.replace(QLatin1Char('\''), QStringLiteral("\\'"));
-    escaped.replace(QLatin1Char('"'), QStringLiteral("\\\""));
-    escaped.replace(QLatin1Char('`'), QStringLiteral("\\`"));
-    escaped.replace(QLatin1Char('\n'), QStringLiteral("\\n"));
-    escaped.replace(QLatin1Char('\r'), QStringLiteral("\\r"));
-    escaped.replace(QLatin1Char('\t'), QStringLiteral("\\t"));
-    escaped.replace(QLatin1Char('\b'), QStringLiteral("\\b"));
-    escaped.replace(QLatin1Char('\f'), QStringLiteral("\\f"));
-    // Escape HTML script tags to prevent injection
-    escaped.replace(QStringLiteral("</"), QStringLiteral("<\\/"));
-    return escaped;
+    m_pendingUpdates.append(update);
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void ChatWebView::flushUpdates()
+{
+    m_flushTimer->stop();
+    // Signals emitted before the page connects to the channel would be lost
+    if (!m_channelReady || m_pendingUpdates.isEmpty()) {
+        return;
+    }
+
+    QJsonArray batch;
+    for (const PendingUpdate &update : std::as_const(m_pendingUpdates)) {
+        batch.append(toJson(update));
+    }
+    m_pendingUpdates.clear();
+
+    Q_EMIT m_bridge->updatesPushed(batch);
+}
+
+QJsonObject ChatWebView::toJson(const PendingUpdate &update)
+{
+    QJsonObject data;
+    switch (update.kind) {
+    case PendingUpdate::MessageChunk:
+        data[QStringLiteral("type")] = QStringLiteral("updateMessage");
+        data[QStringLiteral("messageId")] = update.messageId;
+        data[QStringLiteral("content")] = update.text;
+        return data;
+
+    case PendingUpdate::ToolCallUpdate:
+        data[QStringLiteral("type")] = QStringLiteral("updateToolCall");
+        data[QStringLiteral("messageId")] = update.messageId;
+        data[QStringLiteral("toolCallId")] = update.toolCallId;
+        data[QStringLiteral("status")] = update.status;
+        data[QStringLiteral("result")] = textOrBlob(update.text);
+        data[QStringLiteral("filePath")] = update.filePath;
+        data[QStringLiteral("toolName")] = update.toolName;
+        return data;
+
+    case PendingUpdate::TerminalOutput: {
+        // Each snapshot replaces the terminal's previous one. A running terminal
+        // is flushed repeatedly, so only its final snapshot is worth a blob.
+        releaseBlob(m_terminalBlobs.take(update.terminalId));
+        const QJsonValue output = update.finished ? textOrBlob(update.text) : QJsonValue(update.text);
+        if (output.isObject()) {
+            m_terminalBlobs.insert(update.terminalId, output[QStringLiteral("blob")].toString());
+        }
+        data[QStringLiteral("type")] = QStringLiteral("updateTerminal");
+        data[QStringLiteral("terminalId")] = update.terminalId;
+        data[QStringLiteral("output")] = output;
+        data[QStringLiteral("finished")] = update.finished;
+        return data;
+    }
+
+    case PendingUpdate::Generic:
+        break;
+    }
+    return update.data;
+}
+
+// Text below the threshold goes inline; longer text becomes {blob, size}
+// if the page can fetch() it
+QJsonValue ChatWebView::textOrBlob(const QString &text)
+{
+    if (text.size() < BLOB_THRESHOLD || !m_blobs || !m_blobText) {
+        return text;
+    }
+
+    const QString url = m_blobs->store(text.toUtf8(), QByteArrayLiteral("text/plain; charset=utf-8"));
+    m_blobUrls.insert(url);
+
+    QJsonObject ref;
+    ref[QStringLiteral("blob")] = url;
+    ref[QStringLiteral("size")] = text.size();
+    return ref;
+}
+
+void ChatWebView::releaseBlob(const QString &url)
+{
+    if (url.isEmpty() || !m_blobUrls.remove(url)) {
+        return;
+    }
+    if (m_blobs) {
+        m_blobs->release(url);
+    }
+}
+
+void ChatWebView::releaseAllBlobs()
+{
+    if (m_blobs) {
+        for (const QString &url : std::as_const(m_blobUrls)) {
+            m_blobs->release(url);
+        }
+    }
+    m_blobUrls.clear();
+    m_terminalBlobs.clear();
 }
 
 void ChatWebView::addTrackedEdit(const TrackedEdit &edit)
@@ -454,6 +573,7 @@ void ChatWebView::addTrackedEdit(const TrackedEdit &edit)
 
     // Serialize the edit to JSON
     QJsonObject editObj;
+    editObj[QStringLiteral("id")] = edit.id;
     editObj[QStringLiteral("toolCallId")] = edit.toolCallId;
     editObj[QStringLiteral("filePath")] = edit.filePath;
     editObj[QStringLiteral("startLine")] = edit.startLine;
@@ -461,9 +581,9 @@ void ChatWebView::addTrackedEdit(const TrackedEdit &edit)
     editObj[QStringLiteral("newLineCount")] = edit.newLineCount;
     editObj[QStringLiteral("isNewFile")] = edit.isNewFile;
 
-    QString editJson = QString::fromUtf8(QJsonDocument(editObj).toJson(QJsonDocument::Compact));
-    QString script = QStringLiteral("addTrackedEdit('%1');").arg(escapeJsString(editJson));
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("edit")] = editObj;
+    push(QStringLiteral("addTrackedEdit"), data);
 }
 
 void ChatWebView::clearEditSummary()
@@ -472,7 +592,7 @@ void ChatWebView::clearEditSummary()
         return;
     }
 
-    runJavaScript(QStringLiteral("clearEditSummary();"));
+    push(QStringLiteral("clearEditSummary"), QJsonObject());
 }
 
 void ChatWebView::updateDiffColors(const QString &removeBackground, const QString &addBackground)
@@ -481,12 +601,10 @@ void ChatWebView::updateDiffColors(const QString &removeBackground, const QStrin
         return;
     }
 
-    QString script = QStringLiteral(
-        "document.documentElement.style.setProperty('--diff-remove-bg', '%1');"
-        "document.documentElement.style.setProperty('--diff-add-bg', '%2');"
-    ).arg(removeBackground, addBackground);
-
-    runJavaScript(script);
+    QJsonObject data;
+    data[QStringLiteral("removeBackground")] = removeBackground;
+    data[QStringLiteral("addBackground")] = addBackground;
+    push(QStringLiteral("diffColors"), data);
     qDebug() << "[ChatWebView] Updated diff colors: remove=" << removeBackground << "add=" << addBackground;
 }
 
@@ -496,15 +614,26 @@ void WebBridge::respondToPermission(int requestId, const QString &optionId)
     Q_EMIT permissionResponse(requestId, optionId);
 }
 
+void WebBridge::notifyReady()
+{
+    Q_EMIT pageReady();
+}
+
 void WebBridge::logFromJS(const QString &message)
 {
     qDebug() << "[JS]" << message;
 }
 
-void WebBridge::jumpToEdit(const QString &filePath, int startLine, int endLine)
+void WebBridge::jumpToEdit(const QString &filePath, int startLine, int endLine, int editId)
+{
+    qDebug() << "[WebBridge] jumpToEdit requested:" << filePath << "edit" << editId << "lines" << startLine << "-" << endLine;
+    Q_EMIT jumpToEditRequested(filePath, startLine, endLine, editId);
+}
+
+void WebBridge::revertFile(const QString &filePath)
 {
-    qDebug() << "[WebBridge] jumpToEdit requested:" << filePath << "lines" << startLine << "-" << endLine;
-    Q_EMIT jumpToEditRequested(filePath, startLine, endLine);
+    qDebug() << "[WebBridge] revertFile requested:" << filePath;
+    Q_EMIT revertFileRequested(filePath);
 }
 
 void WebBridge::submitQuestionAnswers(const QString &requestId, const QString &answersJson)
@@ -512,3 +641,8 @@ void WebBridge::submitQuestionAnswers(const QString &requestId, const QString &a
     qDebug() << "[WebBridge] submitQuestionAnswers:" << requestId;
     Q_EMIT questionAnswersSubmitted(requestId, answersJson);
 }
+
+void WebBridge::highlightCode(int requestId, const QString &code, const QString &filePath, const QString &language)
+{
+    Q_EMIT highlightRequested(requestId, code, filePath, language);
+}
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "../acp/ACPModels.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSet>
 #include <QWebEngineView>
 
+class BlobSchemeHandler;
+class CodeHighlighter;
+class QTimer;
 class WebBridge;
 
 class ChatWebView : public QWebEngineView
@@ -39,7 +46,8 @@ public:
 
 Q_SIGNALS:
     void permissionResponseReady(int requestId, const QString &optionId);
-    void jumpToEditRequested(const QString &filePath, int startLine, int endLine);
+    void jumpToEditRequested(const QString &filePath, int startLine, int endLine, int editId);
+    void revertFileRequested(const QString &filePath);
     void webViewReady();
     void userQuestionAnswered(const QString &requestId, const QJsonObject &answers);
 
@@ -47,13 +55,53 @@ private Q_SLOTS:
     void onLoadFinished(bool ok);
 
 private:
-    void runJavaScript(const QString &script);
-    QString escapeJsString(const QString &str);
+    // Page update waiting for the next flush. Message chunks, tool call
+    // updates and terminal output are coalesced; everything else is sent
+    // as its JSON object.
+    struct PendingUpdate {
+        enum Kind { Generic, MessageChunk, ToolCallUpdate, TerminalOutput };
+
+        Kind kind = Generic;
+        QJsonObject data;
+        QString messageId;
+        QString toolCallId;
+        QString terminalId;
+        QString text;           // Chunk, tool result or terminal output
+        QString status;
+        QString filePath;
+        QString toolName;
+        bool finished = false;
+    };
+
+    void push(const QString &type, const QJsonObject &data, const QString &toolCallId = QString());
+    void enqueue(const PendingUpdate &update);
+    void flushUpdates();
+    QJsonObject toJson(const PendingUpdate &update);
+    QJsonValue textOrBlob(const QString &text);
+    void releaseBlob(const QString &url);
+    void releaseAllBlobs();
     void injectColorScheme();
     void setupBridge();
 
     bool m_isLoaded;
+    bool m_channelReady = false;  // Page has connected to updatesPushed
     WebBridge *m_bridge;
+
+    // Updates go out as one batch per frame instead of one per call
+    QList<PendingUpdate> m_pendingUpdates;
+    QTimer *m_flushTimer;
+
+    // Large payloads are served through katecode://blob/ URLs, see BlobSchemeHandler
+    QPointer<BlobSchemeHandler> m_blobs;     // Null if the scheme isn't registered
+    bool m_blobText = false;                 // Long text can go as blobs (page can fetch them)
+    QSet<QString> m_blobUrls;                 // Blobs this view stored
+    QHash<QString, QString> m_terminalBlobs;  // Terminal id -> blob of its latest output
+
+    // Code in tool calls and messages is highlighted here, see requestHighlight() in chat.js
+    CodeHighlighter *m_highlighter;
+
+    static const int FLUSH_INTERVAL_MS = 16;
+    static const int BLOB_THRESHOLD = 16 * 1024;  // Characters of text sent inline
 };
 
 // Bridge class for JavaScript to call C++
@@ -65,13 +113,22 @@ public:
     explicit WebBridge(QObject *parent = nullptr) : QObject(parent) {}
 
 public Q_SLOTS:
+    Q_INVOKABLE void notifyReady();
     Q_INVOKABLE void respondToPermission(int requestId, const QString &optionId);
     Q_INVOKABLE void logFromJS(const QString &message);
-    Q_INVOKABLE void jumpToEdit(const QString &filePath, int startLine, int endLine);
+    Q_INVOKABLE void jumpToEdit(const QString &filePath, int startLine, int endLine, int editId);
+    Q_INVOKABLE void revertFile(const QString &filePath);
     Q_INVOKABLE void submitQuestionAnswers(const QString &requestId, const QString &answersJson);
+    Q_INVOKABLE void highlightCode(int requestId, const QString &code, const QString &filePath, const QString &language);
 
 Q_SIGNALS:
+    // Batch of typed page updates, see applyUpdates() in chat.js
+    void updatesPushed(const QJsonArray &updates);
+
+    void pageReady();
     void permissionResponse(int requestId, const QString &optionId);
-    void jumpToEditRequested(const QString &filePath, int startLine, int endLine);
+    void jumpToEditRequested(const QString &filePath, int startLine, int endLine, int editId);
+    void revertFileRequested(const QString &filePath);
     void questionAnswersSubmitted(const QString &requestId, const QString &answersJson);
+    void highlightRequested(int requestId, const QString &code, const QString &filePath, const QString &language);
 };
@@ -129,6 +129,7 @@ ChatWidget::ChatWidget(QWidget *parent)
     connect(m_session, &ACPSession::messageUpdated, this, &ChatWidget::onMessageUpdated);
     connect(m_session, &ACPSession::messageFinished, this, &ChatWidget::onMessageFinished);
     connect(m_session, &ACPSession::toolCallAdded, this, &ChatWidget::onToolCallAdded);
+    connect(m_session, &ACPSession::toolCallEditsApplied, this, &ChatWidget::onToolCallEditsApplied);
     connect(m_session, &ACPSession::toolCallUpdated, this, &ChatWidget::onToolCallUpdated);
     connect(m_session, &ACPSession::todosUpdated, this, &ChatWidget::onTodosUpdated);
     connect(m_session, &ACPSession::permissionRequested, this, &ChatWidget::onPermissionRequested);
@@ -198,6 +199,21 @@ void ChatWidget::setDocumentProvider(DocumentProvider provider)
     m_session->setDocumentProvider(provider);
 }
 
+void ChatWidget::setAvailableFiles(const QStringList &files)
+{
+    m_inputWidget->setAvailableFiles(files);
+}
+
+void ChatWidget::updateAvailableFiles(const QStringList &added, const QStringList &removed)
+{
+    m_inputWidget->updateAvailableFiles(added, removed);
+}
+
+void ChatWidget::setSnapshotStore(SnapshotStore *store)
+{
+    m_session->setSnapshotStore(store);
+}
+
 void ChatWidget::setSettingsStore(SettingsStore *settings)
 {
     m_settingsStore = settings;
@@ -374,6 +390,12 @@ void ChatWidget::onMessageSubmitted(const QString &message)
     // Track that user has sent a real message (for summary generation)
     m_userSentMessage = true;
 
+    // Highlights of applied edits last until the next prompt
+    for (const QString &toolCallId : std::as_const(m_highlightedToolCalls)) {
+        Q_EMIT toolCallClearRequested(toolCallId);
+    }
+    m_highlightedToolCalls.clear();
+
     // Get current Kate context
     QString filePath = m_filePathProvider ? m_filePathProvider() : QString();
     QString selection = m_selectionProvider ? m_selectionProvider() : QString();
@@ -498,22 +520,33 @@ void ChatWidget::onMessageFinished(const QString &messageId)
 void ChatWidget::onToolCallAdded(const QString &messageId, const ToolCall &toolCall)
 {
     m_chatWebView->addToolCall(messageId, toolCall);
-
-    // Request diff highlighting for edits (Edit tool)
-    if (!toolCall.edits.isEmpty()) {
-        Q_EMIT toolCallHighlightRequested(toolCall.id, toolCall);
-    }
 }
 
 void ChatWidget::onToolCallUpdated(const QString &messageId, const QString &toolCallId, const QString &status, const QString &result, const QString &filePath, const QString &toolName)
 {
     Q_UNUSED(messageId);
     m_chatWebView->updateToolCall(messageId, toolCallId, status, result, filePath, toolName);
+}
 
-    // Clear highlights when tool call completes or fails
-    if (status == QStringLiteral("completed") || status == QStringLiteral("failed")) {
-        Q_EMIT toolCallClearRequested(toolCallId);
+void ChatWidget::onToolCallEditsApplied(const QString &toolCallId, const QList<EditDiff> &edits)
+{
+    // Request diff highlighting now that the edits' positions are known
+    ToolCall toolCall;
+    toolCall.id = toolCallId;
+    toolCall.edits = edits;
+    if (!m_highlightedToolCalls.contains(toolCallId)) {
+        m_highlightedToolCalls.append(toolCallId);
     }
+    Q_EMIT toolCallHighlightRequested(toolCallId, toolCall);
+}
+
+void ChatWidget::showAppliedEdits(const QString &toolCallId, const QList<EditDiff> &edits)
+{
+    // Every window hears the shared editor service; only the session that made the call highlights
+    if (toolCallId.isEmpty() || edits.isEmpty() || !m_session->hasToolCall(toolCallId)) {
+        return;
+    }
+    onToolCallEditsApplied(toolCallId, edits);
 }
 
 void ChatWidget::onTodosUpdated(const QList<TodoItem> &todos)
@@ -1120,6 +1153,29 @@ void ChatWidget::removeUserQuestion(const QString &requestId)
     m_chatWebView->removeUserQuestion(requestId);
 }
 
+void ChatWidget::onJumpToEditRequested(const QString &filePath, int startLine, int endLine, int editId)
+{
+    // The summary shows lines as recorded; later edits may have moved them
+    if (!m_session->editTracker()->currentLines(editId, &startLine, &endLine)) {
+        qDebug() << "[ChatWidget] Edit" << editId << "no longer tracked, using recorded lines";
+    }
+    Q_EMIT jumpToEditRequested(filePath, startLine, endLine);
+}
+
+void ChatWidget::showRevertResult(const QString &filePath, const QString &result)
+{
+    Message sysMsg;
+    sysMsg.id = QStringLiteral("sys_revert_%1").arg(QDateTime::currentMSecsSinceEpoch());
+    sysMsg.role = QStringLiteral("system");
+    sysMsg.timestamp = QDateTime::currentDateTime();
+    if (result.startsWith(QStringLiteral("ERROR:"))) {
+        sysMsg.content = QStringLiteral("Could not revert %1: %2").arg(filePath, result.mid(6).trimmed());
+    } else {
+        sysMsg.content = QStringLiteral("Reverted %1 to its version before the agent's edits").arg(filePath);
+    }
+    m_chatWebView->addMessage(sysMsg);
+}
+
 void ChatWidget::onUserQuestionAnswered(const QString &requestId, const QJsonObject &answers)
 {
     qDebug() << "[ChatWidget] onUserQuestionAnswered, requestId:" << requestId;
@@ -1148,8 +1204,9 @@ void ChatWidget::connectWebViewSignals()
     connect(m_session->editTracker(), &EditTracker::editRecorded, m_chatWebView, &ChatWebView::addTrackedEdit);
     connect(m_session->editTracker(), &EditTracker::editsCleared, m_chatWebView, &ChatWebView::clearEditSummary);
 
-    // Forward jump to edit requests from WebView
-    connect(m_chatWebView, &ChatWebView::jumpToEditRequested, this, &ChatWidget::jumpToEditRequested);
+    // Resolve jump to edit requests from WebView to current positions
+    connect(m_chatWebView, &ChatWebView::jumpToEditRequested, this, &ChatWidget::onJumpToEditRequested);
+    connect(m_chatWebView, &ChatWebView::revertFileRequested, this, &ChatWidget::revertFileRequested);
 
     // Apply diff colors when WebView is ready (after page load)
     connect(m_chatWebView, &ChatWebView::webViewReady, this, &ChatWidget::applyDiffColors);
@@ -16,6 +16,7 @@ class SessionStore;
 class SummaryStore;
 class SummaryGenerator;
 class SettingsStore;
+class SnapshotStore;
 class QComboBox;
 class QPushButton;
 class QToolButton;
@@ -31,6 +32,7 @@ public:
 
     // Settings injection (from KateCodePlugin via KateCodeView)
     void setSettingsStore(SettingsStore *settings);
+    void setSnapshotStore(SnapshotStore *store);
 
     // Context providers (callbacks to get current file/selection/project root from Kate)
     using ContextProvider = std::function<QString()>;
@@ -42,6 +44,10 @@ public:
     void setFileListProvider(FileListProvider provider);
     void setDocumentProvider(DocumentProvider provider);
 
+    // Refresh the @-completion file list (e.g. when the project index changes)
+    void setAvailableFiles(const QStringList &files);
+    void updateAvailableFiles(const QStringList &added, const QStringList &removed);
+
     // Context chunk management
     void addContextChunk(const QString &filePath, int startLine, int endLine, const QString &content);
     void removeContextChunk(const QString &id);
@@ -61,6 +67,10 @@ public Q_SLOTS:
     void showUserQuestion(const QString &requestId, const QString &questionsJson);
     // Remove user question UI (on timeout or cancel)
     void removeUserQuestion(const QString &requestId);
+    // Report the outcome of a revert ("OK" or "ERROR: ...") in the chat
+    void showRevertResult(const QString &filePath, const QString &result);
+    // Highlight edits the editor service applied, if the tool call is this session's
+    void showAppliedEdits(const QString &toolCallId, const QList<EditDiff> &edits);
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
@@ -73,6 +83,9 @@ Q_SIGNALS:
     // Edit navigation signal
     void jumpToEditRequested(const QString &filePath, int startLine, int endLine);
 
+    // User asked to restore a file to its version before the agent's edits
+    void revertFileRequested(const QString &filePath);
+
     // Debug logging signal (forwarded to Kate Output view by KateCodeView)
     void debugLogMessage(const QString &message);
 
@@ -92,6 +105,7 @@ private Q_SLOTS:
     void onMessageFinished(const QString &messageId);
     void onToolCallAdded(const QString &messageId, const ToolCall &toolCall);
     void onToolCallUpdated(const QString &messageId, const QString &toolCallId, const QString &status, const QString &result, const QString &filePath = QString(), const QString &toolName = QString());
+    void onToolCallEditsApplied(const QString &toolCallId, const QList<EditDiff> &edits);
     void onTodosUpdated(const QList<TodoItem> &todos);
     void onPermissionRequested(const PermissionRequest &request);
     void onModesAvailable(const QJsonArray &modes);
@@ -115,6 +129,9 @@ private Q_SLOTS:
     // User question handling
     void onUserQuestionAnswered(const QString &requestId, const QJsonObject &answers);
 
+    // Edit navigation
+    void onJumpToEditRequested(const QString &filePath, int startLine, int endLine, int editId);
+
 private:
     void triggerSummaryGeneration();
     void applyDiffColors();
@@ -140,6 +157,9 @@ private:
     ContextProvider m_projectRootProvider;
     FileListProvider m_fileListProvider;
 
+    // Tool calls with editor diff highlights, cleared on the next prompt
+    QStringList m_highlightedToolCalls;
+
     // Context chunks
     QList<ContextChunk> m_contextChunks;
     int m_nextChunkId = 0;
@@ -0,0 +1,99 @@
+#include "AsyncFileMatcher.h"
+#include "FuzzyFileMatcher.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+
+namespace {
+
+const int SLOW_MATCH_MS = 16;  // Matches slower than a frame are logged
+
+} // namespace
+
+AsyncFileMatcher::AsyncFileMatcher(QObject *parent)
+    : QObject(parent)
+    , m_thread(new QThread)
+    , m_context(new QObject)
+    , m_matcher(std::make_unique<FuzzyFileMatcher>())
+{
+    m_context->moveToThread(m_thread);
+    m_thread->start();
+}
+
+AsyncFileMatcher::~AsyncFileMatcher()
+{
+    if (m_cancelled) {
+        *m_cancelled = true;
+    }
+    m_thread->quit();
+    m_thread->wait();
+    delete m_context;
+    delete m_thread;
+}
+
+void AsyncFileMatcher::setFiles(const QStringList &files)
+{
+    m_fileCount = files.size();
+
+    FuzzyFileMatcher *matcher = m_matcher.get();
+    QMetaObject::invokeMethod(m_context, [matcher, files]() {
+        matcher->setFiles(files);
+    }, Qt::QueuedConnection);
+}
+
+void AsyncFileMatcher::updateFiles(const QStringList &added, const QStringList &removed)
+{
+    m_fileCount += added.size() - removed.size();
+
+    FuzzyFileMatcher *matcher = m_matcher.get();
+    QMetaObject::invokeMethod(m_context, [matcher, added, removed]() {
+        matcher->updateFiles(added, removed);
+    }, Qt::QueuedConnection);
+}
+
+quint64 AsyncFileMatcher::match(const QString &query, int limit)
+{
+    // Typing faster than matching: the older scan stops at its next check
+    if (m_cancelled) {
+        *m_cancelled = true;
+    }
+    m_cancelled = std::make_shared<std::atomic_bool>(false);
+    const quint64 generation = ++m_generation;
+
+    FuzzyFileMatcher *matcher = m_matcher.get();
+    const auto cancelled = m_cancelled;
+    QMetaObject::invokeMethod(m_context, [this, matcher, query, limit, generation, cancelled]() {
+        if (*cancelled) {
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const QStringList paths = matcher->match(query, limit, cancelled.get());
+        if (*cancelled) {
+            return;
+        }
+        if (timer.elapsed() > SLOW_MATCH_MS) {
+            qDebug() << "[AsyncFileMatcher] Matched" << query << "against" << matcher->fileCount()
+                     << "paths in" << timer.elapsed() << "ms";
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, query, paths]() {
+            if (generation != m_generation) {
+                return;
+            }
+            Q_EMIT matched(generation, query, paths);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    return generation;
+}
+
+void AsyncFileMatcher::recordUse(const QString &path)
+{
+    FuzzyFileMatcher *matcher = m_matcher.get();
+    QMetaObject::invokeMethod(m_context, [matcher, path]() {
+        matcher->recordUse(path);
+    }, Qt::QueuedConnection);
+}
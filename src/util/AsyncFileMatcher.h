@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+
+#include <atomic>
+#include <memory>
+
+class FuzzyFileMatcher;
+class QThread;
+
+/**
+ * AsyncFileMatcher - Runs FuzzyFileMatcher on a worker thread.
+ *
+ * Indexing and matching a large project's paths can take tens of
+ * milliseconds, too long to do per keystroke on the UI thread. Each request
+ * bumps a generation; a newer request cancels the scan of an older one, and
+ * results that are no longer the latest are dropped before they reach
+ * matched().
+ */
+class AsyncFileMatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AsyncFileMatcher(QObject *parent = nullptr);
+    ~AsyncFileMatcher() override;
+
+    void setFiles(const QStringList &files);
+    void updateFiles(const QStringList &added, const QStringList &removed);
+    int fileCount() const { return m_fileCount; }
+
+    // Start matching query; the result arrives through matched() unless a
+    // newer request supersedes it. Returns the request's generation.
+    quint64 match(const QString &query, int limit);
+
+    // Remember a picked file so it ranks higher next time
+    void recordUse(const QString &path);
+
+Q_SIGNALS:
+    void matched(quint64 generation, const QString &query, const QStringList &paths);
+
+private:
+    QThread *m_thread;
+    QObject *m_context;  // Lives on m_thread; jobs are queued to it
+    std::unique_ptr<FuzzyFileMatcher> m_matcher;  // Only touched on m_thread
+
+    int m_fileCount = 0;
+    quint64 m_generation = 0;
+    std::shared_ptr<std::atomic_bool> m_cancelled;  // Of the latest request
+};
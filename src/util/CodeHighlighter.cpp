@@ -0,0 +1,226 @@
+#include "CodeHighlighter.h"
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <KSyntaxHighlighting/AbstractHighlighter>
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Format>
+#include <KSyntaxHighlighting/Repository>
+#include <KSyntaxHighlighting/State>
+#include <KSyntaxHighlighting/Theme>
+
+namespace {
+
+const int MAX_HIGHLIGHT_CHARS = 2 * 1024 * 1024;  // Larger input is returned as plain text
+const int CACHE_CHARS = 8 * 1024 * 1024;          // Total size of cached HTML
+
+// Collects one line's formats as inline-styled spans
+class HtmlRenderer : public KSyntaxHighlighting::AbstractHighlighter
+{
+public:
+    QString render(const QString &code)
+    {
+        QString html;
+        html.reserve(code.size() * 2);
+
+        KSyntaxHighlighting::State state;
+        const QStringList lines = code.split(QLatin1Char('\n'));
+        for (int i = 0; i < lines.size(); ++i) {
+            if (i > 0) {
+                html += QLatin1Char('\n');
+            }
+            m_line = lines[i];
+            m_lineHtml.clear();
+            m_end = 0;
+            state = highlightLine(m_line, state);
+            // Text after the last format, if any
+            if (m_end < m_line.size()) {
+                m_lineHtml += m_line.mid(m_end).toHtmlEscaped();
+            }
+            html += m_lineHtml;
+        }
+        return html;
+    }
+
+protected:
+    void applyFormat(int offset, int length, const KSyntaxHighlighting::Format &format) override
+    {
+        if (length <= 0) {
+            return;
+        }
+        if (offset > m_end) {
+            m_lineHtml += m_line.mid(m_end, offset - m_end).toHtmlEscaped();
+        }
+        m_end = offset + length;
+
+        const QString text = m_line.mid(offset, length).toHtmlEscaped();
+        const QString style = styleFor(format);
+        if (style.isEmpty()) {
+            m_lineHtml += text;
+        } else {
+            m_lineHtml += QStringLiteral("<span style=\"%1\">%2</span>").arg(style, text);
+        }
+    }
+
+private:
+    QString styleFor(const KSyntaxHighlighting::Format &format) const
+    {
+        const KSyntaxHighlighting::Theme &t = theme();
+        QStringList style;
+        if (format.hasTextColor(t)) {
+            style << QStringLiteral("color:") + format.textColor(t).name();
+        }
+        if (format.hasBackgroundColor(t)) {
+            style << QStringLiteral("background-color:") + format.backgroundColor(t).name();
+        }
+        if (format.isBold(t)) {
+            style << QStringLiteral("font-weight:bold");
+        }
+        if (format.isItalic(t)) {
+            style << QStringLiteral("font-style:italic");
+        }
+        if (format.isUnderline(t)) {
+            style << QStringLiteral("text-decoration:underline");
+        } else if (format.isStrikeThrough(t)) {
+            style << QStringLiteral("text-decoration:line-through");
+        }
+        return style.join(QLatin1Char(';'));
+    }
+
+    QString m_line;
+    QString m_lineHtml;
+    int m_end = 0;
+};
+
+} // namespace
+
+// State only touched on the worker thread
+struct CodeHighlighter::Worker {
+    std::unique_ptr<KSyntaxHighlighting::Repository> repository;
+    HtmlRenderer renderer;
+    QString themeName;
+    bool light = false;
+    QCache<QByteArray, QString> cache;  // Cost = HTML length
+
+    KSyntaxHighlighting::Repository &repo()
+    {
+        // Loading definitions takes a moment, so it waits for the first job
+        if (!repository) {
+            repository = std::make_unique<KSyntaxHighlighting::Repository>();
+            cache.setMaxCost(CACHE_CHARS);
+        }
+        return *repository;
+    }
+
+    KSyntaxHighlighting::Definition definitionFor(const QString &filePath, const QString &language)
+    {
+        KSyntaxHighlighting::Repository &r = repo();
+        KSyntaxHighlighting::Definition definition;
+        if (!filePath.isEmpty()) {
+            definition = r.definitionForFileName(filePath);
+        }
+        if (definition.isValid() || language.isEmpty()) {
+            return definition;
+        }
+
+        // Info strings are usually a name ("python") or an extension ("py")
+        definition = r.definitionForName(language);
+        if (!definition.isValid()) {
+            definition = r.definitionForFileName(QStringLiteral("file.") + language);
+        }
+        if (!definition.isValid()) {
+            const auto definitions = r.definitions();
+            for (const KSyntaxHighlighting::Definition &candidate : definitions) {
+                if (candidate.name().compare(language, Qt::CaseInsensitive) == 0) {
+                    return candidate;
+                }
+            }
+        }
+        return definition;
+    }
+
+    QString highlight(const QString &code, const QString &filePath, const QString &language)
+    {
+        const KSyntaxHighlighting::Definition definition = definitionFor(filePath, language);
+        if (!definition.isValid()) {
+            return QString();
+        }
+        if (code.size() > MAX_HIGHLIGHT_CHARS) {
+            return code.toHtmlEscaped();
+        }
+
+        KSyntaxHighlighting::Theme theme = repo().theme(themeName);
+        if (!theme.isValid()) {
+            theme = repo().defaultTheme(light ? KSyntaxHighlighting::Repository::LightTheme
+                                              : KSyntaxHighlighting::Repository::DarkTheme);
+        }
+
+        const QByteArray key = QCryptographicHash::hash(code.toUtf8(), QCryptographicHash::Sha1)
+                               + '\0' + definition.name().toUtf8() + '\0' + theme.name().toUtf8();
+        if (const QString *cached = cache.object(key)) {
+            return *cached;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        renderer.setDefinition(definition);
+        renderer.setTheme(theme);
+        const QString html = renderer.render(code);
+        if (timer.elapsed() > 100) {
+            qDebug() << "[CodeHighlighter] Highlighted" << code.size() << "chars as" << definition.name()
+                     << "in" << timer.elapsed() << "ms";
+        }
+
+        cache.insert(key, new QString(html), qMax(1, int(html.size())));
+        return html;
+    }
+};
+
+CodeHighlighter::CodeHighlighter(QObject *parent)
+    : QObject(parent)
+    , m_thread(new QThread)
+    , m_context(new QObject)
+    , m_worker(std::make_unique<Worker>())
+{
+    m_context->moveToThread(m_thread);
+    m_thread->start(QThread::LowPriority);
+}
+
+CodeHighlighter::~CodeHighlighter()
+{
+    // The repository has to go on the thread that created it
+    Worker *worker = m_worker.get();
+    QMetaObject::invokeMethod(m_context, [worker]() {
+        worker->cache.clear();
+        worker->repository.reset();
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread->quit();
+    m_thread->wait();
+    delete m_context;
+    delete m_thread;
+}
+
+void CodeHighlighter::setTheme(const QString &themeName, bool light)
+{
+    Worker *worker = m_worker.get();
+    QMetaObject::invokeMethod(m_context, [worker, themeName, light]() {
+        worker->themeName = themeName;
+        worker->light = light;
+    }, Qt::QueuedConnection);
+}
+
+void CodeHighlighter::highlight(int requestId, const QString &code, const QString &filePath, const QString &language)
+{
+    Worker *worker = m_worker.get();
+    QMetaObject::invokeMethod(m_context, [this, worker, requestId, code, filePath, language]() {
+        const QString html = worker->highlight(code, filePath, language);
+        QMetaObject::invokeMethod(this, [this, requestId, html]() {
+            Q_EMIT highlighted(requestId, html);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+class QThread;
+
+/**
+ * CodeHighlighter - KSyntaxHighlighting to HTML for the chat view.
+ *
+ * Highlighting runs on a worker thread that owns its own Repository, so it
+ * uses the same definitions and theme as Kate's editor instead of the page's
+ * highlight.js guesses. Each line becomes inline-styled spans that never
+ * cross a line break, so callers can split the result per line. Results are
+ * cached by content hash, definition and theme.
+ */
+class CodeHighlighter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CodeHighlighter(QObject *parent = nullptr);
+    ~CodeHighlighter() override;
+
+    // Kate theme by name; an empty or unknown name picks the default light or dark theme
+    void setTheme(const QString &themeName, bool light);
+
+    // Highlight code in the background and report it through highlighted().
+    // The definition comes from filePath, else from a language name such as a
+    // fenced code block's info string.
+    void highlight(int requestId, const QString &code, const QString &filePath, const QString &language);
+
+Q_SIGNALS:
+    // html is null when no definition matched
+    void highlighted(int requestId, const QString &html);
+
+private:
+    struct Worker;
+
+    QThread *m_thread;
+    QObject *m_context;  // Lives on m_thread; jobs are queued to it
+    std::unique_ptr<Worker> m_worker;
+};
@@ -1,22 +1,21 @@
 #include "DiffHighlightManager.h"
+#include "DocumentIndex.h"
 #include "KateThemeConverter.h"
 #include "../config/SettingsStore.h"
 
-#include <KTextEditor/Application>
 #include <KTextEditor/Document>
-#include <KTextEditor/Editor>
 #include <KTextEditor/Range>
 #include <QColor>
 #include <QDebug>
-#include <QDir>
-#include <QUrl>
 
-DiffHighlightManager::DiffHighlightManager(KTextEditor::MainWindow *mainWindow, SettingsStore *settings, QObject *parent)
+DiffHighlightManager::DiffHighlightManager(KTextEditor::MainWindow *mainWindow, DocumentIndex *documents,
+                                           SettingsStore *settings, QObject *parent)
     : QObject(parent)
     , m_mainWindow(mainWindow)
+    , m_documents(documents)
     , m_settings(settings)
 {
-    createDeletionAttribute();
+    createAttributes();
 
     // Connect to settings changes to update colors dynamically
     if (m_settings) {
@@ -32,8 +31,9 @@ DiffHighlightManager::~DiffHighlightManager()
     clearAllHighlights();
 }
 
-void DiffHighlightManager::createDeletionAttribute()
+void DiffHighlightManager::createAttributes()
 {
+    m_additionAttr = KTextEditor::Attribute::Ptr(new KTextEditor::Attribute());
     m_deletionAttr = KTextEditor::Attribute::Ptr(new KTextEditor::Attribute());
 
     // Detect if Kate theme has a light background
@@ -43,28 +43,31 @@ void DiffHighlightManager::createDeletionAttribute()
     DiffColorScheme scheme = m_settings ? m_settings->diffColorScheme() : DiffColorScheme::RedGreen;
     DiffColors colors = SettingsStore::colorsForScheme(scheme, isLightBackground);
 
-    // Apply deletion colors
-    m_deletionAttr->setBackground(colors.deletionBackground);
-    m_deletionAttr->setForeground(colors.deletionForeground);
+    // Added or rewritten lines
+    m_additionAttr->setBackground(colors.additionBackground);
+    m_additionAttr->setForeground(colors.additionForeground);
 
-    // Strikethrough effect
-    m_deletionAttr->setFontStrikeOut(true);
+    // The line following a pure deletion - the removed text itself is gone
+    // from the buffer, so only mark where it was (no strikethrough)
+    m_deletionAttr->setBackground(colors.deletionBackground);
 
-    qDebug() << "[DiffHighlightManager] Created deletion attribute with colors:"
-             << "bg=" << colors.deletionBackground.name()
-             << "fg=" << colors.deletionForeground.name()
+    qDebug() << "[DiffHighlightManager] Created diff attributes with colors:"
+             << "addition bg=" << colors.additionBackground.name()
+             << "deletion bg=" << colors.deletionBackground.name()
              << "isLightBackground:" << isLightBackground;
 }
 
 void DiffHighlightManager::onSettingsChanged()
 {
-    // Recreate the attribute with new colors
-    createDeletionAttribute();
+    const KTextEditor::Attribute::Ptr oldDeletionAttr = m_deletionAttr;
+
+    // Recreate the attributes with new colors
+    createAttributes();
 
-    // Update existing highlights to use the new attribute
+    // Update existing highlights to use the new attributes
     for (auto it = m_highlights.begin(); it != m_highlights.end(); ++it) {
         for (KTextEditor::MovingRange *range : it.value()) {
-            range->setAttribute(m_deletionAttr);
+            range->setAttribute(range->attribute() == oldDeletionAttr ? m_deletionAttr : m_additionAttr);
         }
     }
 
@@ -73,15 +76,13 @@ void DiffHighlightManager::onSettingsChanged()
 
 void DiffHighlightManager::highlightToolCall(const QString &toolCallId, const ToolCall &toolCall)
 {
-    // Clear any existing highlights for this tool call
-    clearToolCallHighlights(toolCallId);
-
     // Skip if no edits
     if (toolCall.edits.isEmpty()) {
         qDebug() << "[DiffHighlightManager] No edits to highlight for tool call:" << toolCallId;
         return;
     }
 
+    // Highlights accumulate - a tool call may write the same or several files more than once
     int successCount = 0;
     for (const EditDiff &edit : toolCall.edits) {
         // Use edit's filePath if available, otherwise fall back to toolCall's filePath
@@ -128,62 +129,18 @@ void DiffHighlightManager::clearAllHighlights()
 
 KTextEditor::Document *DiffHighlightManager::findDocument(const QString &filePath)
 {
-    if (filePath.isEmpty()) {
-        return nullptr;
-    }
-
-    // Normalize the file path
-    QString normalizedPath = QDir::cleanPath(filePath);
-    QUrl fileUrl = QUrl::fromLocalFile(normalizedPath);
-
-    // Get all documents from the application
-    KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
-    if (!app) {
-        qWarning() << "[DiffHighlightManager] No KTextEditor application available";
-        return nullptr;
-    }
-
-    const QList<KTextEditor::Document *> docs = app->documents();
-    for (KTextEditor::Document *doc : docs) {
-        if (doc->url() == fileUrl || doc->url().toLocalFile() == normalizedPath) {
-            return doc;
-        }
-    }
-
-    qDebug() << "[DiffHighlightManager] Document not found for path:" << filePath;
-    return nullptr;
-}
-
-KTextEditor::Range DiffHighlightManager::findTextInDocument(KTextEditor::Document *doc, const QString &text)
-{
-    if (!doc || text.isEmpty()) {
-        return KTextEditor::Range::invalid();
-    }
-
-    // Search the entire document
-    KTextEditor::Range searchRange(0, 0, doc->lines(), 0);
-
-    // Use document's searchText to find the text
-    QList<KTextEditor::Range> results = doc->searchText(searchRange, text);
-
-    if (results.isEmpty()) {
-        qDebug() << "[DiffHighlightManager] Text not found in document:" << doc->url().toLocalFile()
-                 << "text preview:" << text.left(50);
-        return KTextEditor::Range::invalid();
-    }
-
-    if (results.size() > 1) {
-        qDebug() << "[DiffHighlightManager] Found" << results.size() << "matches, using first";
+    KTextEditor::Document *doc = m_documents ? m_documents->find(filePath) : nullptr;
+    if (!doc && !filePath.isEmpty()) {
+        qDebug() << "[DiffHighlightManager] Document not found for path:" << filePath;
     }
-
-    return results.first();
+    return doc;
 }
 
 bool DiffHighlightManager::highlightEdit(const QString &toolCallId, const EditDiff &edit, const QString &fallbackFilePath)
 {
-    // Skip if no old text to highlight (this is an insertion-only edit)
-    if (edit.oldText.isEmpty()) {
-        qDebug() << "[DiffHighlightManager] Skipping edit with no oldText (insertion only)";
+    // Positions are filled in when the edit is applied; without them there is nothing to anchor to
+    if (edit.startLine < 0) {
+        qDebug() << "[DiffHighlightManager] Skipping edit without a known position";
         return false;
     }
 
@@ -201,17 +158,22 @@ bool DiffHighlightManager::highlightEdit(const QString &toolCallId, const EditDi
         return false;
     }
 
-    // Check text size limit for performance
-    const int MAX_HIGHLIGHT_SIZE = 10000;
-    if (edit.oldText.length() > MAX_HIGHLIGHT_SIZE) {
-        qDebug() << "[DiffHighlightManager] Text too large to highlight:" << edit.oldText.length() << "chars";
+    const int lineCount = doc->lines();
+    if (edit.startLine >= lineCount) {
+        qDebug() << "[DiffHighlightManager] Edit position past end of document:" << edit.startLine + 1;
         return false;
     }
 
-    // Find the text in the document
-    KTextEditor::Range textRange = findTextInDocument(doc, edit.oldText);
-    if (!textRange.isValid()) {
-        qWarning() << "[DiffHighlightManager] Could not find text in document:" << filePath;
+    // Added lines, or the line the removed text used to precede
+    const bool isDeletion = edit.newLineCount == 0;
+    const int lastLine = qMin(lineCount - 1, edit.startLine + qMax(1, edit.newLineCount) - 1);
+
+    // End at the start of the next line so empty lines are covered too
+    const KTextEditor::Cursor end = lastLine + 1 < lineCount
+        ? KTextEditor::Cursor(lastLine + 1, 0)
+        : KTextEditor::Cursor(lastLine, doc->lineLength(lastLine));
+    const KTextEditor::Range textRange(KTextEditor::Cursor(edit.startLine, 0), end);
+    if (textRange.isEmpty()) {
         return false;
     }
 
@@ -226,14 +188,13 @@ bool DiffHighlightManager::highlightEdit(const QString &toolCallId, const EditDi
         return false;
     }
 
-    // Apply the deletion attribute
-    movingRange->setAttribute(m_deletionAttr);
+    movingRange->setAttribute(isDeletion ? m_deletionAttr : m_additionAttr);
 
     // Store the range for later cleanup
     m_highlights[toolCallId].append(movingRange);
 
-    qDebug() << "[DiffHighlightManager] Highlighted deletion at" << textRange.start().line() + 1 << ":"
-             << textRange.start().column() << "to" << textRange.end().line() + 1 << ":" << textRange.end().column();
+    qDebug() << "[DiffHighlightManager] Highlighted" << (isDeletion ? "deletion" : "addition")
+             << "at lines" << edit.startLine + 1 << "-" << lastLine + 1;
 
     return true;
 }
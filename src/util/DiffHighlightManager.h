@@ -8,11 +8,11 @@
 #include <QHash>
 #include <QObject>
 
+class DocumentIndex;
 class SettingsStore;
 
 namespace KTextEditor {
 class Document;
-class Range;
 }
 
 class DiffHighlightManager : public QObject
@@ -20,10 +20,12 @@ class DiffHighlightManager : public QObject
     Q_OBJECT
 
 public:
-    explicit DiffHighlightManager(KTextEditor::MainWindow *mainWindow, SettingsStore *settings = nullptr, QObject *parent = nullptr);
+    explicit DiffHighlightManager(KTextEditor::MainWindow *mainWindow, DocumentIndex *documents,
+                                  SettingsStore *settings = nullptr, QObject *parent = nullptr);
     ~DiffHighlightManager() override;
 
-    // Highlight a tool call's edits in the editor
+    // Highlight a tool call's applied edits (EditDiff positions must be filled in).
+    // Adds to the tool call's existing highlights.
     void highlightToolCall(const QString &toolCallId, const ToolCall &toolCall);
 
     // Clear highlights for a specific tool call
@@ -39,17 +41,16 @@ private:
     // Find an open document by file path
     KTextEditor::Document *findDocument(const QString &filePath);
 
-    // Search for text in a document and return its range
-    KTextEditor::Range findTextInDocument(KTextEditor::Document *doc, const QString &text);
-
     // Apply highlight to a single edit
     bool highlightEdit(const QString &toolCallId, const EditDiff &edit, const QString &fallbackFilePath);
 
-    // Create the deletion highlight attribute based on current settings
-    void createDeletionAttribute();
+    // Create the addition/deletion highlight attributes based on current settings
+    void createAttributes();
 
     KTextEditor::MainWindow *m_mainWindow;
+    DocumentIndex *m_documents;
     SettingsStore *m_settings;
     QHash<QString, QList<KTextEditor::MovingRange *>> m_highlights;
+    KTextEditor::Attribute::Ptr m_additionAttr;
     KTextEditor::Attribute::Ptr m_deletionAttr;
 };
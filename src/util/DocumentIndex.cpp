@@ -0,0 +1,100 @@
+#include "DocumentIndex.h"
+
+#include <KTextEditor/Application>
+#include <KTextEditor/Document>
+#include <KTextEditor/Editor>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+DocumentIndex::DocumentIndex(QObject *parent)
+    : QObject(parent)
+{
+    KTextEditor::Application *app = KTextEditor::Editor::instance()->application();
+    if (!app) {
+        qWarning() << "[DocumentIndex] No KTextEditor application available";
+        return;
+    }
+
+    connect(app, &KTextEditor::Application::documentCreated,
+            this, &DocumentIndex::onDocumentCreated);
+    connect(app, &KTextEditor::Application::documentWillBeDeleted,
+            this, &DocumentIndex::onDocumentWillBeDeleted);
+
+    const QList<KTextEditor::Document *> docs = app->documents();
+    for (KTextEditor::Document *doc : docs) {
+        onDocumentCreated(doc);
+    }
+}
+
+KTextEditor::Document *DocumentIndex::find(const QString &path) const
+{
+    if (path.isEmpty()) {
+        return nullptr;
+    }
+
+    // The path as given usually hits; resolving symlinks costs a few syscalls
+    const QString cleanPath = QDir::cleanPath(path);
+    if (KTextEditor::Document *doc = m_byPath.value(cleanPath)) {
+        return doc;
+    }
+
+    const QString canonicalPath = QFileInfo(cleanPath).canonicalFilePath();
+    if (canonicalPath.isEmpty() || canonicalPath == cleanPath) {
+        return nullptr;
+    }
+    return m_byPath.value(canonicalPath);
+}
+
+void DocumentIndex::onDocumentCreated(KTextEditor::Document *doc)
+{
+    connect(doc, &KTextEditor::Document::documentUrlChanged,
+            this, &DocumentIndex::onDocumentUrlChanged, Qt::UniqueConnection);
+    // Saving a new file can give its path a canonical form it didn't have yet
+    connect(doc, &KTextEditor::Document::documentSavedOrUploaded,
+            this, &DocumentIndex::onDocumentUrlChanged, Qt::UniqueConnection);
+    insert(doc);
+}
+
+void DocumentIndex::onDocumentWillBeDeleted(KTextEditor::Document *doc)
+{
+    disconnect(doc, nullptr, this, nullptr);
+    remove(doc);
+}
+
+void DocumentIndex::onDocumentUrlChanged(KTextEditor::Document *doc)
+{
+    remove(doc);
+    insert(doc);
+}
+
+void DocumentIndex::insert(KTextEditor::Document *doc)
+{
+    const QUrl url = doc->url();
+    if (!url.isLocalFile()) {
+        return;
+    }
+
+    const QString cleanPath = QDir::cleanPath(url.toLocalFile());
+    QStringList keys{cleanPath};
+    const QString canonicalPath = QFileInfo(cleanPath).canonicalFilePath();
+    if (!canonicalPath.isEmpty() && canonicalPath != cleanPath) {
+        keys.append(canonicalPath);
+    }
+
+    for (const QString &key : std::as_const(keys)) {
+        m_byPath.insert(key, doc);
+    }
+    m_keys.insert(doc, keys);
+}
+
+void DocumentIndex::remove(KTextEditor::Document *doc)
+{
+    const QStringList keys = m_keys.take(doc);
+    for (const QString &key : keys) {
+        // Another document may have taken over the path since
+        if (m_byPath.value(key) == doc) {
+            m_byPath.remove(key);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+namespace KTextEditor {
+class Document;
+}
+
+/**
+ * DocumentIndex - Path to open document lookup shared across the plugin.
+ *
+ * Kept current from the application's documentCreated/documentWillBeDeleted
+ * signals and each document's URL changes, so a lookup is a hash hit instead
+ * of a scan over Application::documents(). Documents are keyed by their
+ * cleaned path and by the path with symlinks resolved.
+ */
+class DocumentIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DocumentIndex(QObject *parent = nullptr);
+    ~DocumentIndex() override = default;
+
+    // Open document for a local file path, or nullptr
+    KTextEditor::Document *find(const QString &path) const;
+
+private Q_SLOTS:
+    void onDocumentCreated(KTextEditor::Document *doc);
+    void onDocumentWillBeDeleted(KTextEditor::Document *doc);
+    void onDocumentUrlChanged(KTextEditor::Document *doc);
+
+private:
+    void insert(KTextEditor::Document *doc);
+    void remove(KTextEditor::Document *doc);
+
+    QHash<QString, KTextEditor::Document *> m_byPath;
+    QHash<KTextEditor::Document *, QStringList> m_keys;  // Reverse map for removal
+};
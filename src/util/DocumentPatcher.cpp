@@ -0,0 +1,218 @@
+#include "DocumentPatcher.h"
+#include "../acp/ACPModels.h"
+
+#include <KTextEditor/Document>
+#include <KTextEditor/Range>
+#include <QDebug>
+#include <QHash>
+
+QList<DocumentPatcher::LineChange> DocumentPatcher::computeLineChanges(const QStringList &oldLines, const QStringList &newLines)
+{
+    QList<LineChange> changes;
+
+    const int oldSize = oldLines.size();
+    const int newSize = newLines.size();
+
+    // Trim common prefix and suffix - most writes touch a small region
+    int prefix = 0;
+    while (prefix < oldSize && prefix < newSize && oldLines[prefix] == newLines[prefix]) {
+        ++prefix;
+    }
+    int suffix = 0;
+    while (suffix < oldSize - prefix && suffix < newSize - prefix
+           && oldLines[oldSize - 1 - suffix] == newLines[newSize - 1 - suffix]) {
+        ++suffix;
+    }
+
+    const int oldEnd = oldSize - suffix;
+    const int newEnd = newSize - suffix;
+    if (prefix == oldEnd && prefix == newEnd) {
+        return changes;
+    }
+
+    // Intern lines so the diff compares integers
+    QHash<QString, int> ids;
+    auto internLine = [&ids](const QString &line) {
+        auto it = ids.constFind(line);
+        if (it != ids.constEnd()) {
+            return it.value();
+        }
+        const int id = int(ids.size());
+        ids.insert(line, id);
+        return id;
+    };
+
+    QList<int> a;
+    QList<int> b;
+    a.reserve(oldEnd - prefix);
+    b.reserve(newEnd - prefix);
+    for (int i = prefix; i < oldEnd; ++i) {
+        a.append(internLine(oldLines[i]));
+    }
+    for (int j = prefix; j < newEnd; ++j) {
+        b.append(internLine(newLines[j]));
+    }
+
+    if (!diffRange(a, 0, a.size(), b, 0, b.size(), newLines.mid(prefix, newEnd - prefix), &changes)) {
+        // Too different to be worth splitting - replace the middle as one hunk
+        changes.clear();
+        changes.append({0, int(a.size()), int(b.size()), newLines.mid(prefix, newEnd - prefix)});
+    }
+
+    for (LineChange &change : changes) {
+        change.startLine += prefix;
+    }
+    return changes;
+}
+
+bool DocumentPatcher::diffRange(const QList<int> &a, int aStart, int aEnd,
+                                const QList<int> &b, int bStart, int bEnd,
+                                const QStringList &newLines, QList<LineChange> *changes)
+{
+    const int n = aEnd - aStart;
+    const int m = bEnd - bStart;
+    const int maxD = qMin(n + m, int(MAX_EDIT_DISTANCE));
+    const int offset = maxD + 1;
+
+    // Greedy forward Myers; V[k] = furthest x on diagonal k. Keep each round for backtracking.
+    QList<int> v(2 * maxD + 3, 0);
+    QList<QList<int>> trace;
+    int finalD = -1;
+
+    for (int d = 0; d <= maxD && finalD < 0; ++d) {
+        trace.append(v);
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+                x = v[offset + k + 1];
+            } else {
+                x = v[offset + k - 1] + 1;
+            }
+            int y = x - k;
+            while (x < n && y < m && a[aStart + x] == b[bStart + y]) {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                finalD = d;
+                break;
+            }
+        }
+    }
+
+    if (finalD < 0) {
+        return false;
+    }
+
+    // Backtrack to collect matched line pairs (in reverse)
+    QList<QPair<int, int>> matches;
+    int x = n;
+    int y = m;
+    for (int d = finalD; d >= 0; --d) {
+        const QList<int> &vd = trace[d];
+        const int k = x - y;
+        int prevK;
+        if (k == -d || (k != d && vd[offset + k - 1] < vd[offset + k + 1])) {
+            prevK = k + 1;
+        } else {
+            prevK = k - 1;
+        }
+        const int prevX = d > 0 ? vd[offset + prevK] : 0;
+        const int prevY = d > 0 ? prevX - prevK : 0;
+
+        while (x > prevX && y > prevY) {
+            --x;
+            --y;
+            matches.append({x, y});
+        }
+        x = prevX;
+        y = prevY;
+    }
+
+    // Turn the gaps between matches into hunks
+    int oldPos = 0;
+    int newPos = 0;
+    for (int i = matches.size(); i >= 0; --i) {
+        const int matchX = i > 0 ? matches[i - 1].first : n;
+        const int matchY = i > 0 ? matches[i - 1].second : m;
+        if (matchX > oldPos || matchY > newPos) {
+            changes->append({aStart + oldPos, matchX - oldPos, matchY - newPos,
+                             newLines.mid(bStart + newPos, matchY - newPos)});
+        }
+        oldPos = matchX + 1;
+        newPos = matchY + 1;
+    }
+
+    return true;
+}
+
+QList<DocumentPatcher::LineChange> DocumentPatcher::apply(KTextEditor::Document *doc, const QString &newContent)
+{
+    const QString oldContent = doc->text();
+
+    // If content is identical, no changes needed
+    if (oldContent == newContent) {
+        return QList<LineChange>();
+    }
+
+    const QStringList oldLines = oldContent.split(QLatin1Char('\n'));
+    const QStringList newLines = newContent.split(QLatin1Char('\n'));
+    const QList<LineChange> changes = computeLineChanges(oldLines, newLines);
+    const int oldSize = oldLines.size();
+
+    // Start an editing transaction for undo grouping (RAII - finishes when scope exits)
+    KTextEditor::Document::EditingTransaction transaction(doc);
+
+    // Apply changes in reverse order so earlier line numbers stay valid.
+    // Untouched text keeps its cursors, marks and moving ranges.
+    for (int changeIdx = changes.size() - 1; changeIdx >= 0; --changeIdx) {
+        const LineChange &change = changes[changeIdx];
+        const int startLine = change.startLine;
+        const int endLine = change.startLine + change.oldLineCount;
+        const QString joined = change.newLines.join(QLatin1Char('\n'));
+
+        if (change.oldLineCount == 0) {
+            if (startLine < oldSize) {
+                // Insert whole lines before an existing line
+                doc->insertText(KTextEditor::Cursor(startLine, 0), joined + QLatin1Char('\n'));
+            } else {
+                // Append after the last line
+                doc->insertText(KTextEditor::Cursor(oldSize - 1, oldLines.last().length()), QLatin1Char('\n') + joined);
+            }
+        } else if (endLine < oldSize) {
+            // Replace whole lines up to the start of the next unchanged line
+            const QString replacement = change.newLines.isEmpty() ? QString() : joined + QLatin1Char('\n');
+            doc->replaceText(KTextEditor::Range(startLine, 0, endLine, 0), replacement);
+        } else if (!change.newLines.isEmpty() || startLine == 0) {
+            // Replace through the end of the document
+            doc->replaceText(KTextEditor::Range(startLine, 0, oldSize - 1, oldLines.last().length()), joined);
+        } else {
+            // Delete trailing lines, including the line break before them
+            doc->removeText(KTextEditor::Range(startLine - 1, oldLines[startLine - 1].length(),
+                                               oldSize - 1, oldLines.last().length()));
+        }
+    }
+
+    qDebug() << "[DocumentPatcher] Applied" << changes.size() << "hunk(s) to" << doc->url().toLocalFile();
+
+    return changes;
+}
+
+QList<EditDiff> DocumentPatcher::toEditDiffs(const QList<LineChange> &changes, const QString &filePath)
+{
+    QList<EditDiff> edits;
+    edits.reserve(changes.size());
+    int lineShift = 0;  // Changes are in old coordinates
+    for (const LineChange &change : changes) {
+        EditDiff edit;
+        edit.newText = change.newLines.join(QLatin1Char('\n'));
+        edit.filePath = filePath;
+        edit.startLine = change.startLine + lineShift;
+        edit.oldLineCount = change.oldLineCount;
+        edit.newLineCount = change.newLineCount;
+        edits.append(edit);
+        lineShift += change.newLineCount - change.oldLineCount;
+    }
+    return edits;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+struct EditDiff;
+
+namespace KTextEditor {
+class Document;
+}
+
+/**
+ * DocumentPatcher - Applies full-content writes to an open document as a
+ * minimal set of line replacements.
+ *
+ * Replacing the buffer with setText() discards cursors, bookmarks and moving
+ * ranges and forces a full re-highlight. Instead, the old and new contents
+ * are diffed line by line (common prefix/suffix trimmed, Myers diff on the
+ * rest) and only the changed hunks are replaced, in one editing transaction,
+ * so re-layout cost scales with the size of the change.
+ */
+class DocumentPatcher
+{
+public:
+    struct LineChange {
+        int startLine;         // 0-based start line in the old document
+        int oldLineCount;      // Number of lines to remove
+        int newLineCount;      // Number of lines to insert
+        QStringList newLines;  // The new lines to insert
+    };
+
+    // Line changes turning oldLines into newLines, ascending, in old coordinates
+    static QList<LineChange> computeLineChanges(const QStringList &oldLines, const QStringList &newLines);
+
+    // Replace the document's content with newContent as one undo step.
+    // Returns the changes applied (empty if the content was identical).
+    static QList<LineChange> apply(KTextEditor::Document *doc, const QString &newContent);
+
+    // Changes as EditDiffs positioned in the new document, for tracking and highlighting
+    static QList<EditDiff> toEditDiffs(const QList<LineChange> &changes, const QString &filePath);
+
+private:
+    // Myers diff of a[aStart..aEnd) against b[bStart..bEnd); false if more
+    // than MAX_EDIT_DISTANCE line insertions/deletions would be needed
+    static bool diffRange(const QList<int> &a, int aStart, int aEnd,
+                          const QList<int> &b, int bStart, int bEnd,
+                          const QStringList &newLines, QList<LineChange> *changes);
+
+    // Beyond this the middle region is replaced as a single hunk
+    static const int MAX_EDIT_DISTANCE = 500;
+};
@@ -0,0 +1,173 @@
+#include "DocumentRevisionTracker.h"
+
+#include <KTextEditor/Document>
+#include <KTextEditor/Range>
+#include <QDebug>
+
+#include <algorithm>
+
+DocumentRevisionTracker::DocumentRevisionTracker(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void DocumentRevisionTracker::track(KTextEditor::Document *doc)
+{
+    if (!doc || m_logs.contains(doc)) {
+        return;
+    }
+
+    Log log;
+    log.startRevision = doc->revision();
+    m_logs.insert(doc, log);
+
+    connect(doc, &KTextEditor::Document::textInsertedRange,
+            this, &DocumentRevisionTracker::onTextInserted);
+    connect(doc, &KTextEditor::Document::textRemoved,
+            this, &DocumentRevisionTracker::onTextRemoved);
+    connect(doc, &KTextEditor::Document::reloaded,
+            this, &DocumentRevisionTracker::onReloaded);
+    connect(doc, &QObject::destroyed,
+            this, &DocumentRevisionTracker::onDocumentDestroyed);
+
+    qDebug() << "[DocumentRevisionTracker] Tracking" << doc->url().toLocalFile()
+             << "from revision" << log.startRevision;
+}
+
+bool DocumentRevisionTracker::changedHunksSince(KTextEditor::Document *doc, qint64 revision,
+                                                QList<Hunk> *hunks) const
+{
+    auto it = m_logs.constFind(doc);
+    if (it == m_logs.constEnd() || revision < it->startRevision || revision > doc->revision()) {
+        return false;
+    }
+
+    // Replay later changes into sorted half-open spans, old ends in the
+    // caller's revision and new ends in the coordinates after each change.
+    // Lines between spans map across by the size differences before them.
+    struct Span {
+        int oldStart, oldEnd, newStart, newEnd;
+        int shift() const { return (newEnd - newStart) - (oldEnd - oldStart); }
+    };
+    QList<Span> spans;
+    for (const Change &change : it->changes) {
+        if (change.revision <= revision) {
+            continue;
+        }
+
+        // The first and last touched lines may be partially edited
+        const int start = change.line;
+        const int end = change.line + change.removedLines + 1;
+        const int delta = change.addedLines - change.removedLines;
+
+        QList<Span> next;
+        int shiftBefore = 0;
+        int first = -1;
+        int last = -1;
+        for (int i = 0; i < spans.size(); ++i) {
+            const Span &span = spans[i];
+            if (span.newEnd < start) {
+                next.append(span);
+                shiftBefore += span.shift();
+            } else if (span.newStart <= end) {
+                // Overlapping or adjacent - absorbed below
+                if (first < 0) {
+                    first = i;
+                }
+                last = i;
+            }
+        }
+
+        Span merged{start - shiftBefore, end - shiftBefore, start, end};
+        if (first >= 0) {
+            int shiftThrough = shiftBefore;
+            for (int i = first; i <= last; ++i) {
+                shiftThrough += spans[i].shift();
+            }
+            if (spans[first].newStart <= start) {
+                merged.oldStart = spans[first].oldStart;
+                merged.newStart = spans[first].newStart;
+            }
+            if (spans[last].newEnd >= end) {
+                merged.oldEnd = spans[last].oldEnd;
+                merged.newEnd = spans[last].newEnd;
+            } else {
+                merged.oldEnd = end - shiftThrough;
+            }
+        }
+        merged.newEnd += delta;
+        next.append(merged);
+
+        for (const Span &span : std::as_const(spans)) {
+            if (span.newStart > end) {
+                next.append({span.oldStart, span.oldEnd, span.newStart + delta, span.newEnd + delta});
+            }
+        }
+        spans = next;
+    }
+
+    // Spans may reach one line past the end of either revision
+    int totalShift = 0;
+    for (const Span &span : std::as_const(spans)) {
+        totalShift += span.shift();
+    }
+    const int newLineCount = doc->lines();
+    const int oldLineCount = newLineCount - totalShift;
+
+    hunks->clear();
+    for (const Span &span : std::as_const(spans)) {
+        const int oldStart = qBound(0, span.oldStart, oldLineCount);
+        const int oldEnd = qBound(oldStart, span.oldEnd, oldLineCount);
+        const int newStart = qBound(0, span.newStart, newLineCount);
+        const int newEnd = qBound(newStart, span.newEnd, newLineCount);
+        hunks->append({oldStart, oldEnd - oldStart, newStart, newEnd - newStart});
+    }
+
+    return true;
+}
+
+void DocumentRevisionTracker::onTextInserted(KTextEditor::Document *doc, const KTextEditor::Range &range)
+{
+    appendChange(doc, range.start().line(), 0, range.end().line() - range.start().line());
+}
+
+void DocumentRevisionTracker::onTextRemoved(KTextEditor::Document *doc, const KTextEditor::Range &range, const QString &oldText)
+{
+    Q_UNUSED(oldText);
+    appendChange(doc, range.start().line(), range.end().line() - range.start().line(), 0);
+}
+
+void DocumentRevisionTracker::onReloaded(KTextEditor::Document *doc)
+{
+    // Revisions before a reload from disk are meaningless
+    auto it = m_logs.find(doc);
+    if (it != m_logs.end()) {
+        it->changes.clear();
+        it->startRevision = doc->revision();
+    }
+}
+
+void DocumentRevisionTracker::onDocumentDestroyed(QObject *object)
+{
+    for (auto it = m_logs.begin(); it != m_logs.end(); ++it) {
+        if (static_cast<QObject *>(it.key()) == object) {
+            m_logs.erase(it);
+            return;
+        }
+    }
+}
+
+void DocumentRevisionTracker::appendChange(KTextEditor::Document *doc, int line, int removedLines, int addedLines)
+{
+    auto it = m_logs.find(doc);
+    if (it == m_logs.end()) {
+        return;
+    }
+
+    it->changes.append({doc->revision(), line, removedLines, addedLines});
+
+    // Bound the log; callers older than the window fall back to full reads
+    if (it->changes.size() > MAX_CHANGES_PER_DOCUMENT) {
+        it->startRevision = it->changes.takeFirst().revision;
+    }
+}
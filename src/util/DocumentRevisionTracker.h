@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+namespace KTextEditor {
+class Document;
+class Range;
+}
+
+/**
+ * DocumentRevisionTracker - Logs line-level changes of open documents against
+ * the KTextEditor revision counter, so callers holding an older revision can
+ * ask which lines changed since then instead of re-reading the whole buffer.
+ *
+ * Documents are tracked from the first call to track(); changes before that
+ * (or older than the bounded log) cannot be answered and require a full read.
+ */
+class DocumentRevisionTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 0-based lines [oldStart, oldStart + oldCount) of the earlier revision
+    // became [newStart, newStart + newCount) of the current one
+    struct Hunk {
+        int oldStart;
+        int oldCount;
+        int newStart;
+        int newCount;
+    };
+
+    explicit DocumentRevisionTracker(QObject *parent = nullptr);
+    ~DocumentRevisionTracker() override = default;
+
+    // Start logging changes for a document (no-op if already tracked)
+    void track(KTextEditor::Document *doc);
+    bool isTracked(KTextEditor::Document *doc) const { return m_logs.contains(doc); }
+
+    // Compute the hunks changed since revision, sorted and non-overlapping.
+    // Returns false if the revision predates tracking or the log window.
+    bool changedHunksSince(KTextEditor::Document *doc, qint64 revision, QList<Hunk> *hunks) const;
+
+private Q_SLOTS:
+    void onTextInserted(KTextEditor::Document *doc, const KTextEditor::Range &range);
+    void onTextRemoved(KTextEditor::Document *doc, const KTextEditor::Range &range, const QString &oldText);
+    void onReloaded(KTextEditor::Document *doc);
+    void onDocumentDestroyed(QObject *object);
+
+private:
+    struct Change {
+        qint64 revision;   // Document revision after the change
+        int line;          // First affected line
+        int removedLines;  // Line breaks removed
+        int addedLines;    // Line breaks added
+    };
+
+    struct Log {
+        qint64 startRevision = 0;  // Oldest revision changes can be computed from
+        QList<Change> changes;
+    };
+
+    void appendChange(KTextEditor::Document *doc, int line, int removedLines, int addedLines);
+
+    QHash<KTextEditor::Document *, Log> m_logs;
+
+    static const int MAX_CHANGES_PER_DOCUMENT = 10000;
+};
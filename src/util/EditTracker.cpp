@@ -1,30 +1,60 @@
 #include "EditTracker.h"
 
+#include <KTextEditor/Document>
+#include <KTextEditor/MovingRange>
 #include <QDebug>
 
+#include <algorithm>
+
 EditTracker::EditTracker(QObject *parent)
     : QObject(parent)
 {
 }
 
+EditTracker::~EditTracker()
+{
+    for (Entry &entry : m_entries) {
+        delete entry.range;
+    }
+}
+
+void EditTracker::setDocumentProvider(DocumentProvider provider)
+{
+    m_documentProvider = provider;
+}
+
 void EditTracker::recordEdit(const QString &toolCallId, const QString &filePath,
                               int startLine, int oldLineCount, int newLineCount)
 {
-    TrackedEdit edit;
-    edit.toolCallId = toolCallId;
-    edit.filePath = filePath;
-    edit.startLine = startLine;
-    edit.oldLineCount = oldLineCount;
-    edit.newLineCount = newLineCount;
-    edit.isNewFile = false;
-    edit.timestamp = QDateTime::currentDateTime();
+    recordEdits(toolCallId, filePath, {EditSpan{startLine, oldLineCount, newLineCount}});
+}
 
-    m_edits.append(edit);
+void EditTracker::recordEdits(const QString &toolCallId, const QString &filePath,
+                               const QList<EditSpan> &spans)
+{
+    if (spans.isEmpty()) {
+        return;
+    }
 
-    qDebug() << "[EditTracker] Recorded edit:" << filePath
-             << "L" << startLine + 1 << "+" << newLineCount << "/-" << oldLineCount;
+    const QDateTime timestamp = QDateTime::currentDateTime();
+    QList<TrackedEdit> edits;
+    edits.reserve(spans.size());
+    for (const EditSpan &span : spans) {
+        TrackedEdit edit;
+        edit.toolCallId = toolCallId;
+        edit.filePath = filePath;
+        edit.startLine = span.startLine;
+        edit.oldLineCount = span.oldLineCount;
+        edit.newLineCount = span.newLineCount;
+        edit.isNewFile = false;
+        edit.timestamp = timestamp;
+        edits.append(edit);
 
-    Q_EMIT editRecorded(edit);
+        qDebug() << "[EditTracker] Recorded edit:" << filePath
+                 << "L" << span.startLine + 1 << "+" << span.newLineCount << "/-" << span.oldLineCount;
+    }
+
+    addEntries(edits);
 }
 
 void EditTracker::recordNewFile(const QString &toolCallId, const QString &filePath, int lineCount)
@@ -38,27 +68,180 @@ void EditTracker::recordNewFile(const QString &toolCallId, const QString &filePa
     edit.isNewFile = true;
     edit.timestamp = QDateTime::currentDateTime();
 
-    m_edits.append(edit);
+    addEntries({edit});
 
     qDebug() << "[EditTracker] Recorded new file:" << filePath << "with" << lineCount << "lines";
+}
 
-    Q_EMIT editRecorded(edit);
+QList<TrackedEdit> EditTracker::getEdits() const
+{
+    QList<TrackedEdit> result;
+    result.reserve(m_order.size());
+    for (int id : m_order) {
+        result.append(current(m_entries.value(id)));
+    }
+    return result;
 }
 
 QList<TrackedEdit> EditTracker::getEditsForFile(const QString &filePath) const
 {
     QList<TrackedEdit> result;
-    for (const TrackedEdit &edit : m_edits) {
-        if (edit.filePath == filePath) {
-            result.append(edit);
-        }
+    const QList<int> ids = m_idsByFile.value(filePath);
+    result.reserve(ids.size());
+    for (int id : ids) {
+        result.append(current(m_entries.value(id)));
     }
     return result;
 }
 
+bool EditTracker::currentLines(int editId, int *startLine, int *endLine) const
+{
+    auto it = m_entries.constFind(editId);
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+
+    if (const KTextEditor::MovingRange *range = it->range) {
+        *startLine = range->start().line();
+        // A range ending at column 0 doesn't include that line
+        const KTextEditor::Cursor end = range->end().toCursor();
+        *endLine = end.column() > 0 ? end.line() + 1 : end.line();
+    } else {
+        *startLine = it->edit.startLine;
+        *endLine = it->edit.startLine + qMax(0, it->edit.newLineCount);
+    }
+    return true;
+}
+
 void EditTracker::clear()
 {
-    m_edits.clear();
+    for (Entry &entry : m_entries) {
+        delete entry.range;
+    }
+    m_entries.clear();
+    m_idsByFile.clear();
+    m_order.clear();
+    for (KTextEditor::Document *doc : std::as_const(m_watchedDocs)) {
+        disconnect(doc, nullptr, this, nullptr);
+    }
+    m_watchedDocs.clear();
+
     qDebug() << "[EditTracker] Cleared all edits";
     Q_EMIT editsCleared();
 }
+
+void EditTracker::onDocumentContentGone(KTextEditor::Document *doc)
+{
+    // Keep the last known positions and fall back to line arithmetic
+    for (Entry &entry : m_entries) {
+        if (entry.range && entry.range->document() == doc) {
+            entry.edit.startLine = entry.range->start().line();
+            delete entry.range;
+            entry.range = nullptr;
+        }
+    }
+    disconnect(doc, nullptr, this, nullptr);
+    m_watchedDocs.remove(doc);
+}
+
+void EditTracker::addEntries(QList<TrackedEdit> edits)
+{
+    const QString filePath = edits.constFirst().filePath;
+    QList<int> &ids = m_idsByFile[filePath];
+
+    // Earlier edits without a range are still in pre-edit coordinates. Each
+    // change's startLine already counts the changes above it, so replaying
+    // them in order moves those edits to post-patch lines. A full
+    // replacement (oldLineCount -1) leaves nothing to shift against.
+    for (const TrackedEdit &edit : std::as_const(edits)) {
+        if (edit.oldLineCount >= 0) {
+            shiftDetached(ids, edit.startLine, edit.oldLineCount, edit.newLineCount - edit.oldLineCount);
+        }
+    }
+
+    // Only now do all positions match the document, which is already patched
+    KTextEditor::Document *doc = m_documentProvider ? m_documentProvider(filePath) : nullptr;
+    if (doc) {
+        for (int id : std::as_const(ids)) {
+            Entry &earlier = m_entries[id];
+            if (!earlier.range) {
+                attach(earlier, doc);
+            }
+        }
+    }
+
+    for (TrackedEdit &edit : edits) {
+        edit.id = m_nextId++;
+        Entry &entry = m_entries[edit.id];
+        entry.edit = edit;
+        if (doc) {
+            attach(entry, doc);
+        }
+
+        auto pos = std::upper_bound(ids.begin(), ids.end(), edit.startLine,
+                                    [this](int line, int id) { return line < startOf(id); });
+        ids.insert(pos, edit.id);
+        m_order.append(edit.id);
+    }
+
+    for (const TrackedEdit &edit : std::as_const(edits)) {
+        Q_EMIT editRecorded(edit);
+    }
+}
+
+void EditTracker::shiftDetached(QList<int> &ids, int startLine, int oldLineCount, int delta)
+{
+    if (delta == 0) {
+        return;
+    }
+
+    // Only edits starting at or below the replaced lines move
+    const int threshold = startLine + oldLineCount;
+    auto first = std::lower_bound(ids.begin(), ids.end(), threshold,
+                                  [this](int id, int line) { return startOf(id) < line; });
+    for (auto it = first; it != ids.end(); ++it) {
+        Entry &entry = m_entries[*it];
+        if (!entry.range) {
+            entry.edit.startLine += delta;
+        }
+    }
+}
+
+void EditTracker::attach(Entry &entry, KTextEditor::Document *doc)
+{
+    const int docLines = doc->lines();
+    auto clampedCursor = [doc, docLines](int line) {
+        if (line < docLines) {
+            return KTextEditor::Cursor(qMax(0, line), 0);
+        }
+        const int lastLine = docLines - 1;
+        return KTextEditor::Cursor(lastLine, doc->lineLength(lastLine));
+    };
+
+    const KTextEditor::Cursor start = clampedCursor(entry.edit.startLine);
+    const KTextEditor::Cursor end = clampedCursor(entry.edit.startLine + qMax(0, entry.edit.newLineCount));
+    entry.range = doc->newMovingRange(KTextEditor::Range(start, end));
+
+    if (!m_watchedDocs.contains(doc)) {
+        m_watchedDocs.insert(doc);
+        connect(doc, &KTextEditor::Document::aboutToDeleteMovingInterfaceContent,
+                this, &EditTracker::onDocumentContentGone);
+        connect(doc, &KTextEditor::Document::aboutToInvalidateMovingInterfaceContent,
+                this, &EditTracker::onDocumentContentGone);
+    }
+}
+
+TrackedEdit EditTracker::current(const Entry &entry) const
+{
+    TrackedEdit edit = entry.edit;
+    if (entry.range) {
+        edit.startLine = entry.range->start().line();
+    }
+    return edit;
+}
+
+int EditTracker::startOf(int id) const
+{
+    auto it = m_entries.constFind(id);
+    return it->range ? it->range->start().line() : it->edit.startLine;
+}
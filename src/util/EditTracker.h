@@ -1,29 +1,68 @@
 #pragma once
 
 #include "../acp/ACPModels.h"
+#include <QHash>
 #include <QObject>
+#include <QSet>
 
+#include <functional>
+
+namespace KTextEditor {
+class Document;
+class MovingRange;
+}
+
+/**
+ * EditTracker - Per-file index of agent edits with positions kept current.
+ *
+ * Edits to open documents are backed by MovingRanges, so later changes by the
+ * agent or the user move them along. Edits to files that aren't open store
+ * plain line numbers, shifted by each later edit recorded above them, and
+ * pick up a MovingRange once their document is seen open. Each file's edits
+ * stay sorted by start line.
+ */
 class EditTracker : public QObject
 {
     Q_OBJECT
 
 public:
+    using DocumentProvider = std::function<KTextEditor::Document*(const QString &path)>;
+
     explicit EditTracker(QObject *parent = nullptr);
-    ~EditTracker() override = default;
+    ~EditTracker() override;
+
+    // Used to back edits to open documents with MovingRanges
+    void setDocumentProvider(DocumentProvider provider);
+
+    // One replaced block of lines. startLine is in post-edit coordinates.
+    struct EditSpan {
+        int startLine;
+        int oldLineCount;
+        int newLineCount;
+    };
 
-    // Record an edit operation
+    // Record an edit operation. startLine is in post-edit coordinates.
     void recordEdit(const QString &toolCallId, const QString &filePath,
                     int startLine, int oldLineCount, int newLineCount);
 
+    // Record every change of one patch to a file, in ascending line order.
+    // All shifts are applied before any range is attached, so the document
+    // may already hold the whole patch.
+    void recordEdits(const QString &toolCallId, const QString &filePath,
+                     const QList<EditSpan> &spans);
+
     // Record a new file creation
     void recordNewFile(const QString &toolCallId, const QString &filePath, int lineCount);
 
-    // Get all tracked edits
-    QList<TrackedEdit> getEdits() const { return m_edits; }
+    // Get all tracked edits in recording order, at their current positions
+    QList<TrackedEdit> getEdits() const;
 
-    // Get edits for a specific file
+    // Get edits for a specific file, sorted by current start line
     QList<TrackedEdit> getEditsForFile(const QString &filePath) const;
 
+    // Current 0-based lines [startLine, endLine) of an edit; false if the id is unknown
+    bool currentLines(int editId, int *startLine, int *endLine) const;
+
     // Clear all tracked edits
     void clear();
 
@@ -34,6 +73,25 @@ Q_SIGNALS:
     // Emitted when edits are cleared
     void editsCleared();
 
+private Q_SLOTS:
+    void onDocumentContentGone(KTextEditor::Document *doc);
+
 private:
-    QList<TrackedEdit> m_edits;
+    struct Entry {
+        TrackedEdit edit;
+        KTextEditor::MovingRange *range = nullptr;  // Set while the document is open
+    };
+
+    void addEntries(QList<TrackedEdit> edits);
+    void shiftDetached(QList<int> &ids, int startLine, int oldLineCount, int delta);
+    void attach(Entry &entry, KTextEditor::Document *doc);
+    TrackedEdit current(const Entry &entry) const;
+    int startOf(int id) const;
+
+    QHash<int, Entry> m_entries;
+    QHash<QString, QList<int>> m_idsByFile;  // Edit ids sorted by current start line
+    QList<int> m_order;                      // Edit ids in recording order
+    QSet<KTextEditor::Document*> m_watchedDocs;
+    DocumentProvider m_documentProvider;
+    int m_nextId = 1;
 };
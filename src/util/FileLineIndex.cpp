@@ -0,0 +1,117 @@
+#include "FileLineIndex.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+FileLineIndex::FileLineIndex()
+    : m_cache(32 * 1024 * 1024)  // 32 MB of offsets = 4M lines
+{
+}
+
+bool FileLineIndex::readLines(const QString &filePath, int startLine, int limit,
+                              QStringList *lines, int *totalLines, QString *errorMessage)
+{
+    const Index *index = indexFor(filePath, errorMessage);
+    if (!index) {
+        return false;
+    }
+
+    const int total = index->lineStarts.size();
+    *totalLines = total;
+    lines->clear();
+
+    if (startLine >= total || limit <= 0) {
+        return true;
+    }
+
+    const int endLine = qMin(startLine + limit, total);
+    const qint64 begin = index->lineStarts[startLine];
+    const qint64 end = endLine < total ? index->lineStarts[endLine] : index->size;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(begin)) {
+        *errorMessage = QStringLiteral("Cannot open file: %1").arg(file.errorString());
+        return false;
+    }
+
+    const QByteArray bytes = file.read(end - begin);
+    *lines = QString::fromUtf8(bytes).split(QLatin1Char('\n'));
+
+    // A range ending before EOF includes the newline of its last line
+    if (endLine < total && !lines->isEmpty()) {
+        lines->removeLast();
+    }
+    for (QString &line : *lines) {
+        if (line.endsWith(QLatin1Char('\r'))) {
+            line.chop(1);
+        }
+    }
+
+    return true;
+}
+
+int FileLineIndex::lineCount(const QString &filePath, QString *errorMessage)
+{
+    const Index *index = indexFor(filePath, errorMessage);
+    return index ? index->lineStarts.size() : -1;
+}
+
+const FileLineIndex::Index *FileLineIndex::indexFor(const QString &filePath, QString *errorMessage)
+{
+    const QFileInfo info(filePath);
+    if (!info.exists()) {
+        *errorMessage = QStringLiteral("File not found: %1").arg(filePath);
+        return nullptr;
+    }
+
+    const Index *cached = m_oversizedPath == filePath ? m_oversized.get() : m_cache.object(filePath);
+    if (cached && cached->size == info.size() && cached->modified == info.lastModified()) {
+        return cached;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorMessage = QStringLiteral("Cannot open file: %1").arg(file.errorString());
+        return nullptr;
+    }
+
+    auto *index = new Index;
+    index->modified = info.lastModified();
+    index->lineStarts.append(0);
+
+    // Scan in chunks so huge files never need to be resident
+    qint64 offset = 0;
+    while (!file.atEnd()) {
+        const QByteArray chunk = file.read(1024 * 1024);
+        if (chunk.isEmpty()) {
+            break;
+        }
+        const char *data = chunk.constData();
+        for (qsizetype i = 0; i < chunk.size(); ++i) {
+            if (data[i] == '\n') {
+                index->lineStarts.append(offset + i + 1);
+            }
+        }
+        offset += chunk.size();
+    }
+    index->size = offset;
+
+    qDebug() << "[FileLineIndex] Indexed" << filePath << "-" << index->lineStarts.size() << "lines";
+
+    const qsizetype cost = qMax<qsizetype>(1, index->lineStarts.size() * qsizetype(sizeof(qint64)));
+    if (cost > m_cache.maxCost()) {
+        // Larger than the whole cache - keep only the most recent such index
+        m_cache.remove(filePath);
+        m_oversized.reset(index);
+        m_oversizedPath = filePath;
+        return index;
+    }
+
+    if (m_oversizedPath == filePath) {
+        m_oversized.reset();
+        m_oversizedPath.clear();
+    }
+    m_cache.insert(filePath, index, cost);
+    return m_cache.object(filePath);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QCache>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+/**
+ * FileLineIndex - Cached byte offsets of line starts for files on disk.
+ *
+ * Lets ranged reads of files that are not open in Kate seek straight to the
+ * requested lines instead of loading and splitting the whole file. An index
+ * is rebuilt when the file's size or modification time changes.
+ */
+class FileLineIndex
+{
+public:
+    FileLineIndex();
+
+    // Read limit lines starting at 0-based line startLine.
+    // Returns false with errorMessage set if the file cannot be read.
+    bool readLines(const QString &filePath, int startLine, int limit,
+                   QStringList *lines, int *totalLines, QString *errorMessage);
+
+    // Total number of lines (split on '\n', like QString::split)
+    int lineCount(const QString &filePath, QString *errorMessage);
+
+private:
+    struct Index {
+        QDateTime modified;
+        qint64 size = 0;
+        QList<qint64> lineStarts;  // Byte offset of each line's first character
+    };
+
+    const Index *indexFor(const QString &filePath, QString *errorMessage);
+
+    QCache<QString, Index> m_cache;  // Cost = bytes of offsets
+    std::unique_ptr<Index> m_oversized;
+    QString m_oversizedPath;
+};
@@ -0,0 +1,288 @@
+#include "FuzzyFileMatcher.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSet>
+
+#include <algorithm>
+
+namespace {
+
+const int SCORE_MATCH = 16;
+const int PENALTY_GAP_START = 3;
+const int PENALTY_GAP_EXTENSION = 1;
+const int BONUS_SEGMENT = 10;      // Match right after '/' or at the start
+const int BONUS_WORD = 8;          // Match after '_', '-', '.' or ' '
+const int BONUS_CAMEL = 7;         // Match at a lower-to-upper case transition
+const int BONUS_CONSECUTIVE = 5;
+const int BONUS_BASENAME = 20;     // Whole query matched within the file name
+const int BONUS_RECENT = 40;       // Most recently picked file, decaying with age
+
+int boundaryBonus(const QString &path, const QString &lower, int i)
+{
+    if (i == 0) {
+        return BONUS_SEGMENT;
+    }
+    const QChar prev = lower[i - 1];
+    if (prev == QLatin1Char('/')) {
+        return BONUS_SEGMENT;
+    }
+    if (prev == QLatin1Char('_') || prev == QLatin1Char('-') || prev == QLatin1Char('.') || prev == QLatin1Char(' ')) {
+        return BONUS_WORD;
+    }
+    // Case lookups need the original path; lowercasing rarely changes the length
+    if (path.size() == lower.size() && path[i - 1].isLower() && path[i].isUpper()) {
+        return BONUS_CAMEL;
+    }
+    return 0;
+}
+
+} // namespace
+
+void FuzzyFileMatcher::setFiles(const QStringList &files)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_entries.clear();
+    m_entries.reserve(files.size());
+    for (const QString &path : files) {
+        m_entries.append(makeEntry(path));
+    }
+
+    m_lastQuery.clear();
+    m_lastCandidates.clear();
+
+    qDebug() << "[FuzzyFileMatcher] Indexed" << m_entries.size() << "paths in" << timer.elapsed() << "ms";
+}
+
+void FuzzyFileMatcher::updateFiles(const QStringList &added, const QStringList &removed)
+{
+    if (!removed.isEmpty()) {
+        const QSet<QString> gone(removed.cbegin(), removed.cend());
+        m_entries.removeIf([&gone](const Entry &entry) {
+            return gone.contains(entry.path);
+        });
+    }
+    for (const QString &path : added) {
+        m_entries.append(makeEntry(path));
+    }
+
+    // Candidate indices refer to the old entry positions
+    m_lastQuery.clear();
+    m_lastCandidates.clear();
+}
+
+FuzzyFileMatcher::Entry FuzzyFileMatcher::makeEntry(const QString &path) const
+{
+    Entry entry;
+    entry.path = path;
+    entry.lower = path.toLower();
+    entry.mask = charMask(entry.lower);
+    entry.basenameStart = entry.lower.lastIndexOf(QLatin1Char('/')) + 1;
+    if (!m_recent.isEmpty()) {
+        entry.lastUsed = m_recent.value(path);
+    }
+    return entry;
+}
+
+QStringList FuzzyFileMatcher::match(const QString &query, int limit, const std::atomic_bool *cancelled)
+{
+    QStringList result;
+    const QString needle = query.toLower();
+
+    if (needle.isEmpty()) {
+        m_lastQuery.clear();
+        m_lastCandidates.clear();
+
+        // Recently picked files first, then the index in order
+        auto isRecent = [this](const Entry &entry) {
+            return entry.lastUsed > 0 && m_useCounter - entry.lastUsed < MAX_RECENT;
+        };
+        QList<int> recent;
+        for (int i = 0; i < m_entries.size(); ++i) {
+            if (isRecent(m_entries[i])) {
+                recent.append(i);
+            }
+        }
+        std::sort(recent.begin(), recent.end(), [this](int a, int b) {
+            return m_entries[a].lastUsed > m_entries[b].lastUsed;
+        });
+        for (int i = 0; i < recent.size() && result.size() < limit; ++i) {
+            result.append(m_entries[recent[i]].path);
+        }
+        for (int i = 0; i < m_entries.size() && result.size() < limit; ++i) {
+            if (!isRecent(m_entries[i])) {
+                result.append(m_entries[i].path);
+            }
+        }
+        return result;
+    }
+
+    const quint64 needleMask = charMask(needle);
+    QList<int> candidates;
+    QList<QPair<int, int>> scored;  // (score, entry index)
+
+    auto consider = [&](int index) {
+        const Entry &entry = m_entries[index];
+        if ((entry.mask & needleMask) != needleMask) {
+            return;
+        }
+        const int points = score(entry, needle);
+        if (points < 0) {
+            return;
+        }
+        candidates.append(index);
+        scored.append({points, index});
+    };
+
+    // Typing narrows the previous result; anything else scans everything
+    const bool narrowing = !m_lastQuery.isEmpty() && needle.startsWith(m_lastQuery);
+    const int total = narrowing ? m_lastCandidates.size() : m_entries.size();
+    for (int i = 0; i < total; ++i) {
+        if (cancelled && (i & 0xfff) == 0 && *cancelled) {
+            // Partial candidates can't seed the next query
+            m_lastQuery.clear();
+            m_lastCandidates.clear();
+            return QStringList();
+        }
+        consider(narrowing ? m_lastCandidates.at(i) : i);
+    }
+    m_lastQuery = needle;
+    m_lastCandidates = candidates;
+
+    // Ties go to shorter, then alphabetically earlier paths
+    const int count = qMin(limit, int(scored.size()));
+    std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                      [this](const QPair<int, int> &a, const QPair<int, int> &b) {
+        if (a.first != b.first) {
+            return a.first > b.first;
+        }
+        const QString &pathA = m_entries[a.second].path;
+        const QString &pathB = m_entries[b.second].path;
+        if (pathA.size() != pathB.size()) {
+            return pathA.size() < pathB.size();
+        }
+        return pathA < pathB;
+    });
+
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result.append(m_entries[scored[i].second].path);
+    }
+    return result;
+}
+
+void FuzzyFileMatcher::recordUse(const QString &path)
+{
+    const int used = ++m_useCounter;
+    m_recent.insert(path, used);
+
+    // Forget files picked too long ago to still earn a bonus
+    for (auto it = m_recent.begin(); it != m_recent.end();) {
+        if (used - it.value() >= MAX_RECENT) {
+            it = m_recent.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (Entry &entry : m_entries) {
+        if (entry.path == path) {
+            entry.lastUsed = used;
+            break;
+        }
+    }
+}
+
+quint64 FuzzyFileMatcher::charMask(const QString &lower)
+{
+    quint64 mask = 0;
+    for (const QChar c : lower) {
+        const char16_t u = c.unicode();
+        if (u >= u'a' && u <= u'z') {
+            mask |= quint64(1) << (u - u'a');
+        } else if (u >= u'0' && u <= u'9') {
+            mask |= quint64(1) << (26 + u - u'0');
+        } else {
+            // Everything else shares the remaining 28 bits
+            mask |= quint64(1) << (36 + u % 28);
+        }
+    }
+    return mask;
+}
+
+int FuzzyFileMatcher::score(const Entry &entry, const QString &query) const
+{
+    int points = scoreRange(entry, query, entry.basenameStart);
+    if (points >= 0) {
+        points += BONUS_BASENAME;
+    } else {
+        points = scoreRange(entry, query, 0);
+        if (points < 0) {
+            return -1;
+        }
+    }
+
+    if (entry.lastUsed > 0) {
+        const int age = m_useCounter - entry.lastUsed;
+        if (age < MAX_RECENT) {
+            points += BONUS_RECENT * (MAX_RECENT - age) / MAX_RECENT;
+        }
+    }
+    return points;
+}
+
+int FuzzyFileMatcher::scoreRange(const Entry &entry, const QString &query, int from) const
+{
+    const QString &text = entry.lower;
+    const int n = text.size();
+    const int m = query.size();
+
+    // Forward: end of the earliest in-order match, or no match at all
+    int end = -1;
+    for (int i = from, j = 0; i < n; ++i) {
+        if (text[i] == query[j] && ++j == m) {
+            end = i;
+            break;
+        }
+    }
+    if (end < 0) {
+        return -1;
+    }
+
+    // Backward from there: the latest start, i.e. the tightest window
+    int start = end;
+    for (int i = end, j = m - 1; i >= from; --i) {
+        if (text[i] == query[j] && --j < 0) {
+            start = i;
+            break;
+        }
+    }
+
+    // Score the window, matching greedily left to right
+    int points = 0;
+    int lastMatch = -2;
+    bool inGap = false;
+    for (int i = start, j = 0; i <= end && j < m; ++i) {
+        if (text[i] != query[j]) {
+            points -= inGap ? PENALTY_GAP_EXTENSION : PENALTY_GAP_START;
+            inGap = true;
+            continue;
+        }
+
+        int bonus = boundaryBonus(entry.path, text, i);
+        if (lastMatch == i - 1) {
+            bonus = qMax(bonus, BONUS_CONSECUTIVE);
+        }
+        if (j == 0) {
+            bonus *= 2;
+        }
+        points += SCORE_MATCH + bonus;
+        lastMatch = i;
+        inGap = false;
+        ++j;
+    }
+    // Negative scores are reserved for "no match"
+    return qMax(0, points);
+}
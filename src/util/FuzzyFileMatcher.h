@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+/**
+ * FuzzyFileMatcher - Ranked fuzzy matching of project paths for @-completion.
+ *
+ * Query characters must appear in order in a path (case-insensitive). Matches
+ * score higher when they start path segments or words, run consecutively,
+ * fall in the file's basename, or name a recently picked file. A per-path
+ * character bitmask built once in setFiles() rejects most paths before
+ * scoring, and a query that extends the previous one only rescans the
+ * previous candidates. Not thread-safe; AsyncFileMatcher runs it off the UI
+ * thread.
+ */
+class FuzzyFileMatcher
+{
+public:
+    void setFiles(const QStringList &files);
+    // Apply an incremental change without re-indexing the unchanged paths
+    void updateFiles(const QStringList &added, const QStringList &removed);
+    int fileCount() const { return m_entries.size(); }
+
+    // Best limit paths for query, best first. An empty query lists recent files first.
+    // Returns an empty list as soon as cancelled is set.
+    QStringList match(const QString &query, int limit, const std::atomic_bool *cancelled = nullptr);
+
+    // Remember a picked file so it ranks higher next time
+    void recordUse(const QString &path);
+
+private:
+    struct Entry {
+        QString path;
+        QString lower;
+        quint64 mask = 0;       // Characters present, see charMask()
+        int basenameStart = 0;
+        int lastUsed = 0;       // m_useCounter value when last picked, 0 if never
+    };
+
+    Entry makeEntry(const QString &path) const;
+    static quint64 charMask(const QString &lower);
+    int score(const Entry &entry, const QString &query) const;
+    int scoreRange(const Entry &entry, const QString &query, int from) const;
+
+    QList<Entry> m_entries;
+    QHash<QString, int> m_recent;  // Path -> lastUsed, kept across setFiles()
+    int m_useCounter = 0;
+
+    // Candidates of the previous query, reused while the query grows
+    QString m_lastQuery;
+    QList<int> m_lastCandidates;
+
+    static const int MAX_RECENT = 50;
+};
@@ -0,0 +1,802 @@
+#include "ProjectFileIndex.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+
+const quint32 CACHE_MAGIC = 0x4b434649;  // "KCFI"
+const quint32 CACHE_VERSION = 1;
+
+// Version control metadata is never part of the project
+const QStringList VCS_DIRS = {
+    QStringLiteral(".git"),
+    QStringLiteral(".hg"),
+    QStringLiteral(".svn")
+};
+
+// Build output and tool caches, skipped when the project has no ignore rules of its own
+const QStringList DEFAULT_IGNORED_DIRS = {
+    QStringLiteral("node_modules"),
+    QStringLiteral("build"),
+    QStringLiteral("dist"),
+    QStringLiteral("target"),
+    QStringLiteral(".idea"),
+    QStringLiteral(".vscode"),
+    QStringLiteral("__pycache__"),
+    QStringLiteral(".pytest_cache"),
+    QStringLiteral(".tox"),
+    QStringLiteral("venv"),
+    QStringLiteral(".venv"),
+    QStringLiteral("env")
+};
+
+QString joinPath(const QString &dir, const QString &name)
+{
+    return dir.isEmpty() ? name : dir + QLatin1Char('/') + name;
+}
+
+QString parentDir(const QString &path)
+{
+    const int slash = path.lastIndexOf(QLatin1Char('/'));
+    return slash < 0 ? QString() : path.left(slash);
+}
+
+bool useDefaultIgnores(const QString &root)
+{
+    return !QFileInfo::exists(root + QStringLiteral("/.gitignore"))
+        && !QFileInfo::exists(root + QStringLiteral("/.git"));
+}
+
+// Translate a gitignore glob into a regular expression body
+QString globToRegex(const QString &glob)
+{
+    QString regex;
+    for (int i = 0; i < glob.size(); ++i) {
+        const QChar c = glob[i];
+        if (c == QLatin1Char('*')) {
+            if (i + 1 < glob.size() && glob[i + 1] == QLatin1Char('*')) {
+                ++i;
+                if (i + 1 < glob.size() && glob[i + 1] == QLatin1Char('/')) {
+                    // "**/" matches zero or more directories
+                    ++i;
+                    regex += QStringLiteral("(?:.*/)?");
+                } else {
+                    regex += QStringLiteral(".*");
+                }
+            } else {
+                regex += QStringLiteral("[^/]*");
+            }
+        } else if (c == QLatin1Char('?')) {
+            regex += QStringLiteral("[^/]");
+        } else if (c == QLatin1Char('[')) {
+            const int close = glob.indexOf(QLatin1Char(']'), i + 1);
+            if (close < 0) {
+                regex += QStringLiteral("\\[");
+                continue;
+            }
+            QString set = glob.mid(i + 1, close - i - 1);
+            if (set.startsWith(QLatin1Char('!'))) {
+                set[0] = QLatin1Char('^');
+            }
+            regex += QLatin1Char('[') + set + QLatin1Char(']');
+            i = close;
+        } else if (c == QLatin1Char('\\') && i + 1 < glob.size()) {
+            regex += QRegularExpression::escape(QString(glob[++i]));
+        } else {
+            regex += QRegularExpression::escape(QString(c));
+        }
+    }
+    return regex;
+}
+
+// Rules from the .gitignore files along a directory walk
+class IgnoreRules
+{
+public:
+    void addFile(const QString &filePath, const QString &base)
+    {
+        if (m_loaded.contains(filePath)) {
+            return;
+        }
+        m_loaded.insert(filePath);
+
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+
+        QList<Rule> rules;
+        while (!file.atEnd()) {
+            QString pattern = QString::fromUtf8(file.readLine());
+            while (pattern.endsWith(QLatin1Char('\n')) || pattern.endsWith(QLatin1Char('\r'))) {
+                pattern.chop(1);
+            }
+            while (pattern.endsWith(QLatin1Char(' ')) && !pattern.endsWith(QStringLiteral("\\ "))) {
+                pattern.chop(1);
+            }
+            if (pattern.isEmpty() || pattern.startsWith(QLatin1Char('#'))) {
+                continue;
+            }
+
+            Rule rule;
+            if (pattern.startsWith(QLatin1Char('!'))) {
+                rule.negated = true;
+                pattern.remove(0, 1);
+            } else if (pattern.startsWith(QStringLiteral("\\!")) || pattern.startsWith(QStringLiteral("\\#"))) {
+                pattern.remove(0, 1);
+            }
+            if (pattern.endsWith(QLatin1Char('/'))) {
+                rule.directoryOnly = true;
+                pattern.chop(1);
+            }
+            if (pattern.isEmpty()) {
+                continue;
+            }
+
+            // A pattern containing a slash is relative to the .gitignore's directory,
+            // otherwise it matches a name at any depth below it
+            const bool anchored = pattern.contains(QLatin1Char('/'));
+            if (pattern.startsWith(QLatin1Char('/'))) {
+                pattern.remove(0, 1);
+            }
+            rule.regex.setPattern(QStringLiteral("^") + (anchored ? QString() : QStringLiteral("(?:.*/)?"))
+                                  + globToRegex(pattern) + QStringLiteral("$"));
+            if (rule.regex.isValid()) {
+                rules.append(rule);
+            }
+        }
+
+        if (!rules.isEmpty()) {
+            m_rules[base].append(rules);
+        }
+    }
+
+    bool isIgnored(const QString &relPath, bool isDir) const
+    {
+        if (m_rules.isEmpty()) {
+            return false;
+        }
+
+        // Walk the applicable .gitignore files from the root down: deeper files
+        // override shallower ones and within a file the last match wins
+        bool ignored = false;
+        QString base;
+        int from = 0;
+        for (;;) {
+            auto it = m_rules.constFind(base);
+            if (it != m_rules.constEnd()) {
+                const QString subject = base.isEmpty() ? relPath : relPath.mid(base.size() + 1);
+                for (const Rule &rule : *it) {
+                    if (rule.directoryOnly && !isDir) {
+                        continue;
+                    }
+                    if (rule.regex.match(subject).hasMatch()) {
+                        ignored = !rule.negated;
+                    }
+                }
+            }
+
+            const int slash = relPath.indexOf(QLatin1Char('/'), from);
+            if (slash < 0) {
+                break;
+            }
+            base = relPath.left(slash);
+            from = slash + 1;
+        }
+        return ignored;
+    }
+
+private:
+    struct Rule {
+        QRegularExpression regex;
+        bool negated = false;
+        bool directoryOnly = false;
+    };
+
+    QHash<QString, QList<Rule>> m_rules;  // Directory of the .gitignore -> its rules
+    QSet<QString> m_loaded;
+};
+
+// Rules in effect for dir: the repository excludes plus every .gitignore from the root down
+IgnoreRules rulesFor(const QString &root, const QString &dir)
+{
+    IgnoreRules rules;
+    rules.addFile(root + QStringLiteral("/.git/info/exclude"), QString());
+    rules.addFile(root + QStringLiteral("/.gitignore"), QString());
+
+    int from = 0;
+    while (from < dir.size()) {
+        int slash = dir.indexOf(QLatin1Char('/'), from);
+        if (slash < 0) {
+            slash = dir.size();
+        }
+        const QString base = dir.left(slash);
+        rules.addFile(root + QLatin1Char('/') + base + QStringLiteral("/.gitignore"), base);
+        from = slash + 1;
+    }
+    return rules;
+}
+
+void insertFile(QHash<QString, QStringList> *dirs, const QString &relPath)
+{
+    const QString dir = parentDir(relPath);
+    // Every ancestor gets an entry so directories without files are still known
+    for (QString ancestor = dir; !dirs->contains(ancestor); ancestor = parentDir(ancestor)) {
+        dirs->insert(ancestor, QStringList());
+        if (ancestor.isEmpty()) {
+            break;
+        }
+    }
+    (*dirs)[dir].append(dir.isEmpty() ? relPath : relPath.mid(dir.size() + 1));
+}
+
+// List tracked and untracked-but-not-ignored files; false if root is not a git work tree
+bool listGitFiles(const QString &root, const std::atomic_bool &cancelled, QHash<QString, QStringList> *dirs)
+{
+    QProcess git;
+    git.setWorkingDirectory(root);
+    git.start(QStringLiteral("git"), {QStringLiteral("ls-files"), QStringLiteral("-z"), QStringLiteral("--cached"),
+                                      QStringLiteral("--others"), QStringLiteral("--exclude-standard")});
+    if (!git.waitForStarted()) {
+        return false;
+    }
+    while (!git.waitForFinished(100)) {
+        if (git.state() == QProcess::NotRunning) {
+            break;
+        }
+        if (cancelled) {
+            git.kill();
+            git.waitForFinished();
+            return false;
+        }
+    }
+    if (git.exitStatus() != QProcess::NormalExit || git.exitCode() != 0) {
+        return false;
+    }
+
+    const QByteArray output = git.readAllStandardOutput();
+    dirs->insert(QString(), QStringList());
+    for (const QByteArray &entry : output.split('\0')) {
+        if (!entry.isEmpty()) {
+            insertFile(dirs, QString::fromUtf8(entry));
+        }
+    }
+
+    // Unmerged paths are listed once per stage
+    for (auto it = dirs->begin(); it != dirs->end(); ++it) {
+        std::sort(it->begin(), it->end());
+        it->erase(std::unique(it->begin(), it->end()), it->end());
+    }
+    return true;
+}
+
+void walkDirectory(const QString &root, const QString &startDir, IgnoreRules &rules, bool defaultIgnores,
+                   const std::atomic_bool &cancelled, QHash<QString, QStringList> *dirs)
+{
+    QStringList pending{startDir};
+    while (!pending.isEmpty() && !cancelled) {
+        const QString dir = pending.takeLast();
+        const QString absDir = dir.isEmpty() ? root : root + QLatin1Char('/') + dir;
+        rules.addFile(absDir + QStringLiteral("/.gitignore"), dir);
+
+        QStringList names;
+        const QFileInfoList entries = QDir(absDir).entryInfoList(
+            QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden, QDir::Name);
+        for (const QFileInfo &entry : entries) {
+            const QString name = entry.fileName();
+            const QString relPath = joinPath(dir, name);
+            if (entry.isDir()) {
+                // Symlinked directories are not followed, they can form cycles
+                if (entry.isSymLink() || VCS_DIRS.contains(name)
+                    || (defaultIgnores && DEFAULT_IGNORED_DIRS.contains(name))
+                    || rules.isIgnored(relPath, true)) {
+                    continue;
+                }
+                pending.append(relPath);
+            } else if (!rules.isIgnored(relPath, false)) {
+                names.append(name);
+            }
+        }
+        dirs->insert(dir, names);
+    }
+}
+
+} // namespace
+
+ProjectFileIndex::ProjectFileIndex(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounceTimer(new QTimer(this))
+    , m_saveTimer(new QTimer(this))
+    , m_unwatchedTimer(new QTimer(this))
+{
+    // Coalesce bursts of changes (checkouts, builds) into one rescan
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(300);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(10000);
+    // Changes in unwatched directories show up within this interval
+    m_unwatchedTimer->setInterval(60000);
+
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &ProjectFileIndex::onDirectoryChanged);
+    connect(m_debounceTimer, &QTimer::timeout, this, &ProjectFileIndex::flushDirtyDirectories);
+    connect(m_saveTimer, &QTimer::timeout, this, &ProjectFileIndex::saveCache);
+    connect(m_unwatchedTimer, &QTimer::timeout, this, &ProjectFileIndex::rescanUnwatchedDirectories);
+}
+
+ProjectFileIndex::~ProjectFileIndex()
+{
+    if (m_saveTimer->isActive()) {
+        m_saveTimer->stop();
+        saveCache();
+    }
+
+    if (m_cancelled) {
+        *m_cancelled = true;
+    }
+    for (QThread *worker : std::as_const(m_workers)) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+void ProjectFileIndex::setRoot(const QString &root)
+{
+    if (root.isEmpty()) {
+        return;
+    }
+    const QString cleanRoot = QDir::cleanPath(root);
+    if (cleanRoot == m_root) {
+        return;
+    }
+
+    // Persist pending incremental changes of the previous project
+    if (m_saveTimer->isActive()) {
+        m_saveTimer->stop();
+        saveCache();
+    }
+
+    if (m_cancelled) {
+        *m_cancelled = true;
+    }
+    m_cancelled = std::make_shared<std::atomic_bool>(false);
+    ++m_generation;
+
+    m_root = cleanRoot;
+    m_dirs.clear();
+    m_files.clear();
+    m_filesStale = false;
+    m_dirtyDirs.clear();
+    m_updating = false;
+
+    const QStringList watched = m_watcher->directories();
+    if (!watched.isEmpty()) {
+        m_watcher->removePaths(watched);
+    }
+    m_watchedCount = 0;
+    m_unwatchedDirs.clear();
+    m_unwatchedTimer->stop();
+
+    qDebug() << "[ProjectFileIndex] Indexing" << m_root;
+    Q_EMIT filesChanged();
+
+    startFullScan(true);
+}
+
+QStringList ProjectFileIndex::files() const
+{
+    if (m_filesStale) {
+        m_files.clear();
+        for (auto it = m_dirs.constBegin(); it != m_dirs.constEnd(); ++it) {
+            for (const QString &name : it.value()) {
+                m_files.append(joinPath(it.key(), name));
+            }
+        }
+        m_filesStale = false;
+    }
+    return m_files;
+}
+
+void ProjectFileIndex::onDirectoryChanged(const QString &path)
+{
+    const QString dir = path == m_root ? QString() : QDir(m_root).relativeFilePath(path);
+    if (dir.startsWith(QStringLiteral(".."))) {
+        return;
+    }
+    m_dirtyDirs.insert(dir);
+    m_debounceTimer->start();
+}
+
+void ProjectFileIndex::flushDirtyDirectories()
+{
+    // A running job re-arms the timer when it finishes
+    if (m_dirtyDirs.isEmpty() || m_scanning || m_updating) {
+        return;
+    }
+
+    const QStringList dirs(m_dirtyDirs.cbegin(), m_dirtyDirs.cend());
+    m_dirtyDirs.clear();
+    m_updating = true;
+
+    const QString root = m_root;
+    const DirectoryMap known = m_dirs;
+    const qint64 scanStart = m_scanStartMSecs;
+    const quint64 generation = m_generation;
+    const auto cancelled = m_cancelled;
+    startWorker([this, root, dirs, known, scanStart, generation, cancelled]() {
+        const Update update = rescanDirectories(root, dirs, known, scanStart, *cancelled);
+        if (*cancelled) {
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, generation, update]() {
+            applyUpdate(generation, update);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ProjectFileIndex::rescanUnwatchedDirectories()
+{
+    if (m_unwatchedDirs.isEmpty()) {
+        m_unwatchedTimer->stop();
+        return;
+    }
+    // A full scan in progress reads these directories anyway
+    if (m_scanning) {
+        return;
+    }
+    m_dirtyDirs.unite(m_unwatchedDirs);
+    flushDirtyDirectories();
+}
+
+void ProjectFileIndex::saveCache()
+{
+    if (m_root.isEmpty() || m_scanning) {
+        return;
+    }
+
+    const QString root = m_root;
+    const DirectoryMap dirs = m_dirs;
+    const QString cachePath = cacheFilePath(root);
+    startWorker([root, dirs, cachePath]() {
+        writeCache(cachePath, root, dirs);
+    });
+}
+
+void ProjectFileIndex::startFullScan(bool loadCache)
+{
+    m_scanning = true;
+    m_scanStartMSecs = QDateTime::currentMSecsSinceEpoch();
+
+    const QString root = m_root;
+    const QString cachePath = cacheFilePath(root);
+    const quint64 generation = m_generation;
+    const auto cancelled = m_cancelled;
+    startWorker([this, root, cachePath, generation, cancelled, loadCache]() {
+        DirectoryMap cached;
+        if (loadCache && readCache(cachePath, root, &cached)) {
+            QMetaObject::invokeMethod(this, [this, generation, cached]() {
+                applyScan(generation, cached, false);
+            }, Qt::QueuedConnection);
+        }
+
+        const DirectoryMap dirs = scanProject(root, *cancelled);
+        if (*cancelled) {
+            return;
+        }
+        writeCache(cachePath, root, dirs);
+        QMetaObject::invokeMethod(this, [this, generation, dirs]() {
+            applyScan(generation, dirs, true);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ProjectFileIndex::startWorker(std::function<void()> job)
+{
+    QThread *worker = QThread::create(std::move(job));
+    m_workers.append(worker);
+    connect(worker, &QThread::finished, this, [this, worker]() {
+        m_workers.removeOne(worker);
+        worker->deleteLater();
+    });
+    worker->start(QThread::LowPriority);
+}
+
+void ProjectFileIndex::applyScan(quint64 generation, const DirectoryMap &dirs, bool complete)
+{
+    if (generation != m_generation) {
+        return;
+    }
+
+    m_dirs = dirs;
+    m_filesStale = true;
+
+    if (complete) {
+        m_scanning = false;
+
+        const QStringList watched = m_watcher->directories();
+        if (!watched.isEmpty()) {
+            m_watcher->removePaths(watched);
+        }
+        m_watchedCount = 0;
+        m_unwatchedDirs.clear();
+        watchDirectories(m_dirs.keys());
+
+        // Changes seen while scanning may postdate what the scan read
+        if (!m_dirtyDirs.isEmpty()) {
+            m_debounceTimer->start();
+        }
+    }
+
+    qDebug() << "[ProjectFileIndex]" << (complete ? "Scanned" : "Loaded cached index of")
+             << m_root << "-" << m_dirs.size() << "directories";
+    Q_EMIT filesChanged();
+}
+
+void ProjectFileIndex::applyUpdate(quint64 generation, const Update &update)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    m_updating = false;
+
+    if (update.needsFullScan) {
+        qDebug() << "[ProjectFileIndex] .gitignore changed, rescanning" << m_root;
+        startFullScan(false);
+        return;
+    }
+
+    // Files of the touched directories before and after, to report the difference
+    QSet<QString> before;
+    QSet<QString> after;
+
+    QStringList unwatch;
+    for (const QString &removed : update.removedDirs) {
+        const QString prefix = removed + QLatin1Char('/');
+        for (auto it = m_dirs.begin(); it != m_dirs.end();) {
+            if (it.key() == removed || (!removed.isEmpty() && it.key().startsWith(prefix))) {
+                for (const QString &name : std::as_const(it.value())) {
+                    before.insert(joinPath(it.key(), name));
+                }
+                if (!m_unwatchedDirs.remove(it.key())) {
+                    unwatch.append(m_root + QLatin1Char('/') + it.key());
+                }
+                it = m_dirs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (!unwatch.isEmpty()) {
+        m_watcher->removePaths(unwatch);
+        m_watchedCount = m_watcher->directories().size();
+    }
+
+    QStringList newDirs;
+    for (auto it = update.replaced.constBegin(); it != update.replaced.constEnd(); ++it) {
+        auto existing = m_dirs.constFind(it.key());
+        if (existing == m_dirs.constEnd()) {
+            newDirs.append(it.key());
+        } else {
+            for (const QString &name : existing.value()) {
+                before.insert(joinPath(it.key(), name));
+            }
+        }
+        for (const QString &name : it.value()) {
+            after.insert(joinPath(it.key(), name));
+        }
+        m_dirs.insert(it.key(), it.value());
+    }
+    watchDirectories(newDirs);
+
+    QStringList addedFiles;
+    for (const QString &path : std::as_const(after)) {
+        if (!before.contains(path)) {
+            addedFiles.append(path);
+        }
+    }
+    QStringList removedFiles;
+    for (const QString &path : std::as_const(before)) {
+        if (!after.contains(path)) {
+            removedFiles.append(path);
+        }
+    }
+
+    m_filesStale = true;
+    m_saveTimer->start();
+    if (!addedFiles.isEmpty() || !removedFiles.isEmpty()) {
+        Q_EMIT filesUpdated(addedFiles, removedFiles);
+    }
+
+    if (!m_dirtyDirs.isEmpty()) {
+        m_debounceTimer->start();
+    }
+}
+
+void ProjectFileIndex::watchDirectories(QStringList dirs)
+{
+    if (dirs.isEmpty()) {
+        return;
+    }
+
+    // Shallow directories first - they see most of the churn
+    std::stable_sort(dirs.begin(), dirs.end(), [](const QString &a, const QString &b) {
+        return a.count(QLatin1Char('/')) < b.count(QLatin1Char('/'));
+    });
+
+    QStringList paths;
+    const int watchable = qMax(0, MAX_WATCHED_DIRECTORIES - m_watchedCount);
+    for (const QString &dir : std::as_const(dirs)) {
+        if (paths.size() < watchable) {
+            paths.append(dir.isEmpty() ? m_root : m_root + QLatin1Char('/') + dir);
+        } else {
+            m_unwatchedDirs.insert(dir);
+        }
+    }
+
+    const QStringList failed = m_watcher->addPaths(paths);
+    m_watchedCount += paths.size() - failed.size();
+    for (const QString &path : failed) {
+        m_unwatchedDirs.insert(path == m_root ? QString() : path.mid(m_root.size() + 1));
+    }
+
+    if (!m_unwatchedDirs.isEmpty() && !m_unwatchedTimer->isActive()) {
+        qDebug() << "[ProjectFileIndex]" << m_unwatchedDirs.size()
+                 << "directories beyond the watch limit, rescanning them periodically";
+        m_unwatchedTimer->start();
+    }
+}
+
+ProjectFileIndex::DirectoryMap ProjectFileIndex::scanProject(const QString &root, const std::atomic_bool &cancelled)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    DirectoryMap dirs;
+    if (listGitFiles(root, cancelled, &dirs)) {
+        qDebug() << "[ProjectFileIndex] git ls-files listed" << root << "in" << timer.elapsed() << "ms";
+        return dirs;
+    }
+    if (cancelled) {
+        return dirs;
+    }
+
+    dirs.clear();
+    IgnoreRules rules;
+    rules.addFile(root + QStringLiteral("/.git/info/exclude"), QString());
+    walkDirectory(root, QString(), rules, useDefaultIgnores(root), cancelled, &dirs);
+
+    qDebug() << "[ProjectFileIndex] Walked" << root << "in" << timer.elapsed() << "ms";
+    return dirs;
+}
+
+ProjectFileIndex::Update ProjectFileIndex::rescanDirectories(const QString &root, const QStringList &dirs,
+                                                             const DirectoryMap &known, qint64 scanStartMSecs,
+                                                             const std::atomic_bool &cancelled)
+{
+    Update update;
+    const bool defaultIgnores = useDefaultIgnores(root);
+
+    // Known subdirectories per directory; periodic rescans pass thousands of dirs
+    QHash<QString, QStringList> knownChildren;
+    for (auto it = known.constBegin(); it != known.constEnd(); ++it) {
+        if (!it.key().isEmpty()) {
+            knownChildren[parentDir(it.key())].append(it.key());
+        }
+    }
+
+    for (const QString &dir : dirs) {
+        if (cancelled) {
+            break;
+        }
+
+        const QString absDir = dir.isEmpty() ? root : root + QLatin1Char('/') + dir;
+        if (!QFileInfo(absDir).isDir()) {
+            update.removedDirs.append(dir);
+            continue;
+        }
+
+        // Edited ignore rules can affect the whole subtree
+        const QFileInfo ignoreFile(absDir + QStringLiteral("/.gitignore"));
+        if (ignoreFile.exists() && ignoreFile.lastModified().toMSecsSinceEpoch() >= scanStartMSecs) {
+            update.needsFullScan = true;
+            return update;
+        }
+
+        IgnoreRules rules = rulesFor(root, dir);
+        const QStringList knownNames = known.value(dir);
+        const QSet<QString> knownFiles(knownNames.cbegin(), knownNames.cend());
+        QSet<QString> presentDirs;
+
+        QStringList names;
+        const QFileInfoList entries = QDir(absDir).entryInfoList(
+            QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden, QDir::Name);
+        for (const QFileInfo &entry : entries) {
+            const QString name = entry.fileName();
+            const QString relPath = joinPath(dir, name);
+            if (entry.isDir()) {
+                if (known.contains(relPath)) {
+                    presentDirs.insert(relPath);
+                    continue;
+                }
+                if (entry.isSymLink() || VCS_DIRS.contains(name)
+                    || (defaultIgnores && DEFAULT_IGNORED_DIRS.contains(name))
+                    || rules.isIgnored(relPath, true)) {
+                    continue;
+                }
+                walkDirectory(root, relPath, rules, defaultIgnores, cancelled, &update.replaced);
+            } else if (knownFiles.contains(name) || !rules.isIgnored(relPath, false)) {
+                // Already indexed files stay even if ignored - git can track those
+                names.append(name);
+            }
+        }
+        update.replaced.insert(dir, names);
+
+        for (const QString &child : knownChildren.value(dir)) {
+            if (!presentDirs.contains(child)) {
+                update.removedDirs.append(child);
+            }
+        }
+    }
+
+    return update;
+}
+
+bool ProjectFileIndex::readCache(const QString &cachePath, const QString &root, DirectoryMap *dirs)
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString cachedRoot;
+    in >> magic >> version >> cachedRoot;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION || cachedRoot != root) {
+        return false;
+    }
+
+    in >> *dirs;
+    return in.status() == QDataStream::Ok;
+}
+
+void ProjectFileIndex::writeCache(const QString &cachePath, const QString &root, const DirectoryMap &dirs)
+{
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[ProjectFileIndex] Cannot write cache:" << cachePath;
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << CACHE_MAGIC << CACHE_VERSION << root << dirs;
+    if (!file.commit()) {
+        qWarning() << "[ProjectFileIndex] Cannot write cache:" << cachePath;
+    }
+}
+
+QString ProjectFileIndex::cacheFilePath(const QString &root)
+{
+    const QByteArray hash = QCryptographicHash::hash(root.toUtf8(), QCryptographicHash::Sha1);
+    return QDir::homePath() + QStringLiteral("/.kate-code/file-index/%1.cache").arg(QString::fromLatin1(hash.toHex()));
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class QFileSystemWatcher;
+class QThread;
+class QTimer;
+
+/**
+ * ProjectFileIndex - Background index of the files in a project, for @-file
+ * completion.
+ *
+ * The initial scan runs on a worker thread, using `git ls-files` when the
+ * project is a git work tree and a directory walk honouring .gitignore files
+ * otherwise. Afterwards, directories are watched with QFileSystemWatcher and
+ * only the directories that changed are rescanned; their added and removed
+ * files are reported through filesUpdated(). Directories beyond the watch
+ * limit are rescanned periodically instead. The index is cached under
+ * ~/.kate-code/file-index/ so the next start has files before the scan ends.
+ *
+ * KateCodePlugin shares one index per project root between its views.
+ */
+class ProjectFileIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectFileIndex(QObject *parent = nullptr);
+    ~ProjectFileIndex() override;
+
+    // Switch to a project root (no-op if unchanged); loads the cache and rescans
+    void setRoot(const QString &root);
+    QString root() const { return m_root; }
+
+    // Project-relative paths of all indexed files
+    QStringList files() const;
+    bool isScanning() const { return m_scanning; }
+
+Q_SIGNALS:
+    // The whole list was replaced (new root, scan or cache load); re-read files()
+    void filesChanged();
+    // Incremental change to the list, as project-relative paths
+    void filesUpdated(const QStringList &added, const QStringList &removed);
+
+private Q_SLOTS:
+    void onDirectoryChanged(const QString &path);
+    void flushDirtyDirectories();
+    void rescanUnwatchedDirectories();
+    void saveCache();
+
+private:
+    // Directory (relative, "" for the root) -> names of the files directly in it
+    using DirectoryMap = QHash<QString, QStringList>;
+
+    struct Update {
+        DirectoryMap replaced;    // Directories whose contents were rescanned
+        QStringList removedDirs;  // Directories (with their subtrees) that vanished
+        bool needsFullScan = false;
+    };
+
+    void startFullScan(bool loadCache);
+    void startWorker(std::function<void()> job);
+    void applyScan(quint64 generation, const DirectoryMap &dirs, bool complete);
+    void applyUpdate(quint64 generation, const Update &update);
+    void watchDirectories(QStringList dirs);
+
+    static DirectoryMap scanProject(const QString &root, const std::atomic_bool &cancelled);
+    static Update rescanDirectories(const QString &root, const QStringList &dirs, const DirectoryMap &known,
+                                    qint64 scanStartMSecs, const std::atomic_bool &cancelled);
+    static bool readCache(const QString &cachePath, const QString &root, DirectoryMap *dirs);
+    static void writeCache(const QString &cachePath, const QString &root, const DirectoryMap &dirs);
+    static QString cacheFilePath(const QString &root);
+
+    QString m_root;
+    DirectoryMap m_dirs;
+    mutable QStringList m_files;  // Flattened m_dirs, rebuilt lazily
+    mutable bool m_filesStale = false;
+
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_debounceTimer;
+    QTimer *m_saveTimer;
+    QTimer *m_unwatchedTimer;
+    QSet<QString> m_dirtyDirs;
+    QSet<QString> m_unwatchedDirs;  // Indexed directories the watcher doesn't cover
+    int m_watchedCount = 0;
+
+    quint64 m_generation = 0;  // Bumped per root so stale worker results are dropped
+    bool m_scanning = false;
+    bool m_updating = false;
+    qint64 m_scanStartMSecs = 0;
+    std::shared_ptr<std::atomic_bool> m_cancelled;
+    QList<QThread *> m_workers;
+
+    static const int MAX_WATCHED_DIRECTORIES = 4096;
+};
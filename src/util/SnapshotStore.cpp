@@ -0,0 +1,394 @@
+#include "SnapshotStore.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSet>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <signal.h>
+#endif
+
+SnapshotStore::SnapshotStore(QObject *parent)
+    : QObject(parent)
+    , m_memoryBudget(64LL * 1024 * 1024)
+    , m_diskBudget(512LL * 1024 * 1024)
+{
+    // Per-process directory so concurrent Kate instances don't evict each other's blobs
+    const QString snapshotsDir = QDir::homePath() + QStringLiteral("/.kate-code/snapshots");
+    m_diskDir = snapshotsDir + QStringLiteral("/%1").arg(QCoreApplication::applicationPid());
+    removeStaleDirectories(snapshotsDir);
+}
+
+SnapshotStore::~SnapshotStore()
+{
+    // Snapshots only live as long as the editor session
+    QDir dir(m_diskDir);
+    if (dir.exists()) {
+        dir.removeRecursively();
+    }
+}
+
+void SnapshotStore::setBudgets(qint64 memoryBytes, qint64 diskBytes)
+{
+    m_memoryBudget = qMax<qint64>(0, memoryBytes);
+    m_diskBudget = qMax<qint64>(0, diskBytes);
+    enforceBudgets();
+
+    qDebug() << "[SnapshotStore] Budgets set - memory:" << m_memoryBudget << "disk:" << m_diskBudget;
+}
+
+void SnapshotStore::recordBefore(const QString &toolCallId, const QString &filePath, const QString &content, bool isNewFile)
+{
+    if (toolCallId.isEmpty() || filePath.isEmpty()) {
+        return;
+    }
+
+    QHash<QString, FileVersions> &files = m_toolCalls[toolCallId];
+    if (files.contains(filePath)) {
+        // Keep the version from before the tool call's first write
+        return;
+    }
+
+    FileVersions versions;
+    versions.isNewFile = isNewFile;
+    if (!isNewFile) {
+        versions.beforeHash = storeBlob(content);
+    }
+    files.insert(filePath, versions);
+
+    if (!m_originals.contains(filePath)) {
+        m_originals.insert(filePath, Original{toolCallId, versions.beforeHash});
+        if (!versions.beforeHash.isEmpty()) {
+            retainBlob(versions.beforeHash);
+        }
+    }
+
+    enforceBudgets();
+}
+
+void SnapshotStore::recordAfter(const QString &toolCallId, const QString &filePath, const QString &content)
+{
+    if (toolCallId.isEmpty() || filePath.isEmpty()) {
+        return;
+    }
+
+    auto callIt = m_toolCalls.find(toolCallId);
+    if (callIt == m_toolCalls.end() || !callIt->contains(filePath)) {
+        qWarning() << "[SnapshotStore] recordAfter without recordBefore:" << toolCallId << filePath;
+        return;
+    }
+
+    FileVersions &versions = (*callIt)[filePath];
+    const QByteArray previousAfter = versions.afterHash;
+    versions.afterHash = storeBlob(content);
+    if (!previousAfter.isEmpty()) {
+        releaseBlob(previousAfter);
+    }
+
+    enforceBudgets();
+
+    qDebug() << "[SnapshotStore] Recorded snapshot for" << toolCallId << filePath
+             << "- blobs:" << m_blobs.size() << "memory:" << m_memoryUsed << "disk:" << m_diskUsed;
+
+    Q_EMIT snapshotRecorded(toolCallId, filePath);
+}
+
+bool SnapshotStore::hasSnapshot(const QString &toolCallId, const QString &filePath) const
+{
+    return findVersions(toolCallId, filePath) != nullptr;
+}
+
+QStringList SnapshotStore::filesForToolCall(const QString &toolCallId) const
+{
+    return m_toolCalls.value(toolCallId).keys();
+}
+
+bool SnapshotStore::isNewFile(const QString &toolCallId, const QString &filePath) const
+{
+    const FileVersions *versions = findVersions(toolCallId, filePath);
+    return versions && versions->isNewFile;
+}
+
+QString SnapshotStore::beforeContent(const QString &toolCallId, const QString &filePath, bool *ok) const
+{
+    const FileVersions *versions = findVersions(toolCallId, filePath);
+    if (!versions) {
+        if (ok) {
+            *ok = false;
+        }
+        return QString();
+    }
+    if (versions->isNewFile) {
+        if (ok) {
+            *ok = true;
+        }
+        return QString();
+    }
+    return loadBlob(versions->beforeHash, ok);
+}
+
+QString SnapshotStore::afterContent(const QString &toolCallId, const QString &filePath, bool *ok) const
+{
+    const FileVersions *versions = findVersions(toolCallId, filePath);
+    if (!versions || versions->afterHash.isEmpty()) {
+        if (ok) {
+            *ok = false;
+        }
+        return QString();
+    }
+    return loadBlob(versions->afterHash, ok);
+}
+
+QString SnapshotStore::originalContent(const QString &filePath, bool *ok, bool *isNewFile) const
+{
+    auto it = m_originals.constFind(filePath);
+    if (isNewFile) {
+        *isNewFile = it != m_originals.constEnd() && it->hash.isEmpty();
+    }
+    if (it == m_originals.constEnd()) {
+        if (ok) {
+            *ok = false;
+        }
+        return QString();
+    }
+    if (it->hash.isEmpty()) {
+        // File did not exist before the agent created it
+        if (ok) {
+            *ok = true;
+        }
+        return QString();
+    }
+    return loadBlob(it->hash, ok);
+}
+
+void SnapshotStore::removeToolCalls(const QStringList &toolCallIds)
+{
+    const QSet<QString> ids(toolCallIds.begin(), toolCallIds.end());
+    for (const QString &toolCallId : ids) {
+        const QHash<QString, FileVersions> files = m_toolCalls.take(toolCallId);
+        for (const FileVersions &versions : files) {
+            if (!versions.beforeHash.isEmpty()) {
+                releaseBlob(versions.beforeHash);
+            }
+            if (!versions.afterHash.isEmpty()) {
+                releaseBlob(versions.afterHash);
+            }
+        }
+    }
+
+    for (auto it = m_originals.begin(); it != m_originals.end();) {
+        if (ids.contains(it->toolCallId)) {
+            if (!it->hash.isEmpty()) {
+                releaseBlob(it->hash);
+            }
+            it = m_originals.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    enforceBudgets();
+
+    qDebug() << "[SnapshotStore] Removed" << ids.size() << "tool calls - blobs:" << m_blobs.size()
+             << "memory:" << m_memoryUsed << "disk:" << m_diskUsed;
+}
+
+QByteArray SnapshotStore::storeBlob(const QString &content)
+{
+    const QByteArray raw = content.toUtf8();
+    const QByteArray hash = QCryptographicHash::hash(raw, QCryptographicHash::Sha256);
+
+    auto it = m_blobs.find(hash);
+    if (it != m_blobs.end()) {
+        // Deduplicated - identical content already stored
+        retainBlob(hash);
+        touchBlob(hash, *it);
+        return hash;
+    }
+
+    Blob blob;
+    blob.compressed = qCompress(raw);
+    blob.storedSize = blob.compressed.size();
+    blob.refCount = 1;
+    blob.lastUsed = ++m_useCounter;
+    m_memoryUsed += blob.storedSize;
+    m_blobs.insert(hash, blob);
+    m_memoryLru.insert(blob.lastUsed, hash);
+
+    return hash;
+}
+
+void SnapshotStore::retainBlob(const QByteArray &hash)
+{
+    Blob &blob = m_blobs[hash];
+    if (blob.refCount == 0 && blob.onDisk) {
+        // Referenced again, so no longer a drop candidate
+        m_diskLru.remove(blob.lastUsed);
+    }
+    blob.refCount++;
+}
+
+void SnapshotStore::releaseBlob(const QByteArray &hash)
+{
+    auto it = m_blobs.find(hash);
+    if (it == m_blobs.end() || --it->refCount > 0) {
+        return;
+    }
+
+    // Keep it cached for deduplication until a budget needs the space
+    if (it->onDisk) {
+        m_diskLru.insert(it->lastUsed, hash);
+    }
+}
+
+QString SnapshotStore::loadBlob(const QByteArray &hash, bool *ok) const
+{
+    auto it = m_blobs.find(hash);
+    if (it == m_blobs.end()) {
+        if (ok) {
+            *ok = false;
+        }
+        return QString();
+    }
+
+    touchBlob(hash, *it);
+
+    QByteArray compressed;
+    if (it->onDisk) {
+        QFile file(blobPath(hash));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "[SnapshotStore] Cannot read spilled snapshot:" << file.fileName();
+            if (ok) {
+                *ok = false;
+            }
+            return QString();
+        }
+        compressed = file.readAll();
+    } else {
+        compressed = it->compressed;
+    }
+
+    if (ok) {
+        *ok = true;
+    }
+    return QString::fromUtf8(qUncompress(compressed));
+}
+
+void SnapshotStore::touchBlob(const QByteArray &hash, Blob &blob) const
+{
+    QMap<quint64, QByteArray> *lru = nullptr;
+    if (!blob.onDisk) {
+        lru = &m_memoryLru;
+    } else if (blob.refCount == 0) {
+        lru = &m_diskLru;
+    }
+
+    if (lru) {
+        lru->remove(blob.lastUsed);
+    }
+    blob.lastUsed = ++m_useCounter;
+    if (lru) {
+        lru->insert(blob.lastUsed, hash);
+    }
+}
+
+void SnapshotStore::dropBlob(const QByteArray &hash)
+{
+    auto it = m_blobs.find(hash);
+    if (it == m_blobs.end()) {
+        return;
+    }
+
+    if (it->onDisk) {
+        m_diskLru.remove(it->lastUsed);
+        QFile::remove(blobPath(hash));
+        m_diskUsed -= it->storedSize;
+    } else {
+        m_memoryLru.remove(it->lastUsed);
+        m_memoryUsed -= it->storedSize;
+    }
+    m_blobs.erase(it);
+}
+
+void SnapshotStore::enforceBudgets()
+{
+    // Least recently used in-memory blobs go first: dropped if unreferenced,
+    // spilled to disk otherwise
+    while (m_memoryUsed > m_memoryBudget && !m_memoryLru.isEmpty()) {
+        const QByteArray hash = m_memoryLru.first();
+        Blob &blob = m_blobs[hash];
+        if (blob.refCount == 0) {
+            dropBlob(hash);
+            continue;
+        }
+
+        QDir().mkpath(m_diskDir);
+        QFile file(blobPath(hash));
+        if (!file.open(QIODevice::WriteOnly) || file.write(blob.compressed) != blob.storedSize) {
+            // Keep it in memory rather than lose a version a tool call refers to
+            qWarning() << "[SnapshotStore] Cannot spill snapshot to disk:" << file.fileName();
+            file.remove();
+            break;
+        }
+
+        m_memoryLru.remove(blob.lastUsed);
+        m_memoryUsed -= blob.storedSize;
+        m_diskUsed += blob.storedSize;
+        blob.compressed = QByteArray();
+        blob.onDisk = true;
+    }
+
+    // Over the disk budget only unreferenced blobs can be dropped
+    while (m_diskUsed > m_diskBudget && !m_diskLru.isEmpty()) {
+        dropBlob(m_diskLru.first());
+    }
+
+    if (m_diskUsed > m_diskBudget) {
+        qDebug() << "[SnapshotStore] Referenced snapshots exceed the disk budget:" << m_diskUsed;
+    }
+}
+
+QString SnapshotStore::blobPath(const QByteArray &hash) const
+{
+    return m_diskDir + QStringLiteral("/") + QString::fromLatin1(hash.toHex());
+}
+
+const SnapshotStore::FileVersions *SnapshotStore::findVersions(const QString &toolCallId, const QString &filePath) const
+{
+    auto callIt = m_toolCalls.constFind(toolCallId);
+    if (callIt == m_toolCalls.constEnd()) {
+        return nullptr;
+    }
+    auto fileIt = callIt->constFind(filePath);
+    if (fileIt == callIt->constEnd()) {
+        return nullptr;
+    }
+    return &(*fileIt);
+}
+
+void SnapshotStore::removeStaleDirectories(const QString &snapshotsDir)
+{
+#ifdef Q_OS_UNIX
+    // Directories of Kate instances that exited without cleaning up (crash, kill)
+    const QStringList entries = QDir(snapshotsDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool isPid = false;
+        const qint64 pid = entry.toLongLong(&isPid);
+        if (!isPid || pid <= 0 || pid == QCoreApplication::applicationPid()) {
+            continue;
+        }
+        if (::kill(pid_t(pid), 0) == 0 || errno == EPERM) {
+            // Still running
+            continue;
+        }
+        qDebug() << "[SnapshotStore] Removing snapshots of exited process" << pid;
+        QDir(snapshotsDir + QStringLiteral("/") + entry).removeRecursively();
+    }
+#else
+    Q_UNUSED(snapshotsDir);
+#endif
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+/**
+ * SnapshotStore - Content-addressed store of file versions written by the agent.
+ *
+ * Before every agent write (fs/write_text_file, katecode_edit, katecode_write)
+ * the pre-edit content is recorded, and after it the resulting content, so each
+ * tool call maps to exact before/after versions of every file it touched.
+ *
+ * Blobs are keyed by the SHA-256 of their UTF-8 bytes (identical versions are
+ * stored once) and kept zlib-compressed. Over the memory budget the least
+ * recently used blobs spill to ~/.kate-code/snapshots/<pid>. Blobs no tool call
+ * refers to any more stay cached until a budget needs the space; only those
+ * are ever dropped, so a recorded version is never lost while its tool call
+ * is kept.
+ */
+class SnapshotStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SnapshotStore(QObject *parent = nullptr);
+    ~SnapshotStore() override;
+
+    // Budgets in bytes of compressed data
+    void setBudgets(qint64 memoryBytes, qint64 diskBytes);
+
+    // Record the content of a file before a write. Only the first call per
+    // (toolCallId, filePath) is kept, so multi-step tool calls revert to the true original.
+    void recordBefore(const QString &toolCallId, const QString &filePath, const QString &content, bool isNewFile = false);
+
+    // Record the content of a file after a write (latest call wins)
+    void recordAfter(const QString &toolCallId, const QString &filePath, const QString &content);
+
+    bool hasSnapshot(const QString &toolCallId, const QString &filePath) const;
+    QStringList filesForToolCall(const QString &toolCallId) const;
+
+    // True if the tool call created the file (reverting means deleting it)
+    bool isNewFile(const QString &toolCallId, const QString &filePath) const;
+
+    // Versions for a tool call. ok is false if unknown or unreadable.
+    QString beforeContent(const QString &toolCallId, const QString &filePath, bool *ok = nullptr) const;
+    QString afterContent(const QString &toolCallId, const QString &filePath, bool *ok = nullptr) const;
+
+    // Content of a file before the first agent write recorded for it; forgotten
+    // along with the tool call that made that write. isNewFile is set if that
+    // write created the file.
+    QString originalContent(const QString &filePath, bool *ok = nullptr, bool *isNewFile = nullptr) const;
+
+    // Forget the versions recorded for these tool calls (e.g. when their session ends)
+    void removeToolCalls(const QStringList &toolCallIds);
+
+Q_SIGNALS:
+    void snapshotRecorded(const QString &toolCallId, const QString &filePath);
+
+private:
+    struct Blob {
+        QByteArray compressed;   // Empty when spilled to disk
+        qint64 storedSize = 0;   // Compressed size
+        int refCount = 0;        // 0 = cached only, may be dropped
+        bool onDisk = false;
+        quint64 lastUsed = 0;
+    };
+
+    struct FileVersions {
+        QByteArray beforeHash;   // Empty for new files
+        QByteArray afterHash;    // Empty until recordAfter
+        bool isNewFile = false;
+    };
+
+    struct Original {
+        QString toolCallId;      // Tool call whose before version this is
+        QByteArray hash;         // Empty for new files
+    };
+
+    QByteArray storeBlob(const QString &content);
+    void retainBlob(const QByteArray &hash);
+    void releaseBlob(const QByteArray &hash);
+    QString loadBlob(const QByteArray &hash, bool *ok) const;
+    void touchBlob(const QByteArray &hash, Blob &blob) const;
+    void dropBlob(const QByteArray &hash);
+    void enforceBudgets();
+    QString blobPath(const QByteArray &hash) const;
+    const FileVersions *findVersions(const QString &toolCallId, const QString &filePath) const;
+    static void removeStaleDirectories(const QString &snapshotsDir);
+
+    mutable QHash<QByteArray, Blob> m_blobs;
+    // LRU orders keyed by lastUsed: every in-memory blob (spill candidates),
+    // and unreferenced spilled blobs (drop candidates)
+    mutable QMap<quint64, QByteArray> m_memoryLru;
+    mutable QMap<quint64, QByteArray> m_diskLru;
+    QHash<QString, QHash<QString, FileVersions>> m_toolCalls;  // toolCallId -> filePath -> versions
+    QHash<QString, Original> m_originals;                      // filePath -> earliest kept before version
+
+    QString m_diskDir;
+    qint64 m_memoryBudget;
+    qint64 m_diskBudget;
+    qint64 m_memoryUsed = 0;
+    qint64 m_diskUsed = 0;
+    mutable quint64 m_useCounter = 0;
+};
@@ -1,6 +1,8 @@
 // Chat state
 let messages = {};
 let terminals = {};  // Terminal output state keyed by terminalId
+let toolCallsById = new Map();   // Tool call id -> tool call, across messages
+let terminalOwners = new Map();  // Terminal id -> tool call showing it
 let bridge = null;
 
 // Material Symbols icon helper - returns HTML span with icon ligature
@@ -9,62 +11,6 @@ function materialIcon(name, extraClass = '') {
     return `<span class="${cls}">${name}</span>`;
 }
 
-// Map file extensions to highlight.js language identifiers
-const extToLanguage = {
-    // Web
-    'js': 'javascript', 'mjs': 'javascript', 'cjs': 'javascript',
-    'ts': 'typescript', 'tsx': 'typescript', 'jsx': 'javascript',
-    'html': 'xml', 'htm': 'xml', 'xhtml': 'xml',
-    'css': 'css', 'scss': 'scss', 'sass': 'scss', 'less': 'less',
-    'json': 'json', 'json5': 'json',
-    // Systems
-    'c': 'c', 'h': 'c',
-    'cpp': 'cpp', 'cxx': 'cpp', 'cc': 'cpp', 'hpp': 'cpp', 'hxx': 'cpp',
-    'rs': 'rust',
-    'go': 'go',
-    'zig': 'zig',
-    // JVM
-    'java': 'java', 'kt': 'kotlin', 'kts': 'kotlin', 'scala': 'scala',
-    // Scripting
-    'py': 'python', 'pyw': 'python', 'pyi': 'python',
-    'rb': 'ruby', 'rake': 'ruby',
-    'php': 'php',
-    'pl': 'perl', 'pm': 'perl',
-    'lua': 'lua',
-    'sh': 'bash', 'bash': 'bash', 'zsh': 'bash', 'fish': 'fish',
-    'ps1': 'powershell', 'psm1': 'powershell',
-    // Config/Data
-    'yaml': 'yaml', 'yml': 'yaml',
-    'toml': 'ini', 'ini': 'ini', 'conf': 'ini',
-    'xml': 'xml', 'svg': 'xml', 'xsd': 'xml', 'xsl': 'xml',
-    'md': 'markdown', 'markdown': 'markdown',
-    'sql': 'sql',
-    // Build/DevOps
-    'cmake': 'cmake', 'makefile': 'makefile', 'mk': 'makefile',
-    'dockerfile': 'dockerfile',
-    'gradle': 'gradle', 'groovy': 'groovy',
-    // Other
-    'swift': 'swift',
-    'cs': 'csharp',
-    'fs': 'fsharp', 'fsx': 'fsharp',
-    'ex': 'elixir', 'exs': 'elixir',
-    'erl': 'erlang', 'hrl': 'erlang',
-    'hs': 'haskell',
-    'ml': 'ocaml', 'mli': 'ocaml',
-    'clj': 'clojure', 'cljs': 'clojure', 'cljc': 'clojure',
-    'lisp': 'lisp', 'cl': 'lisp', 'el': 'lisp',
-    'r': 'r',
-    'dart': 'dart',
-    'v': 'verilog', 'sv': 'verilog',
-    'vhd': 'vhdl', 'vhdl': 'vhdl',
-    'tex': 'latex', 'latex': 'latex',
-    'diff': 'diff', 'patch': 'diff',
-    'qml': 'qml',
-    // Qt/KDE
-    'pro': 'qmake', 'pri': 'qmake',
-    'ui': 'xml', 'rc': 'xml', 'qrc': 'xml'
-};
-
 // Check if a tool is a Bash/terminal tool that should get ANSI color processing
 function isBashTool(toolName) {
     if (!toolName) return false;
@@ -110,7 +56,8 @@ function isWriteTool(toolName) {
 // Check if a tool is an Edit tool (standard, ACP MCP, or Kate MCP variant)
 // Uses suffix matching for katecode tools to handle different MCP host prefixes
 function isEditTool(toolName) {
-    return toolName === 'Edit' || toolName === 'mcp__acp__Edit' || (toolName && toolName.endsWith('_katecode_edit'));
+    return toolName === 'Edit' || toolName === 'mcp__acp__Edit' ||
+        (toolName && (toolName.endsWith('_katecode_edit') || toolName.endsWith('_katecode_multi_edit')));
 }
 
 // Check if a tool is a Kate MCP tool (mcp__acp__ prefix or _katecode_ suffix pattern)
@@ -184,181 +131,475 @@ function cleanReadResult(text) {
     return strippedLines.join('\n');
 }
 
-// Get highlight.js language from file path
-function getLanguageFromPath(filePath) {
-    if (!filePath) return null;
-    const fileName = filePath.split('/').pop().toLowerCase();
-
-    // Handle special filenames
-    if (fileName === 'makefile' || fileName === 'gnumakefile') return 'makefile';
-    if (fileName === 'dockerfile') return 'dockerfile';
-    if (fileName === 'cmakelists.txt') return 'cmake';
+// Helper to log to C++ via bridge
+function logToQt(message) {
+    if (window.bridge && window.bridge.logFromJS) {
+        window.bridge.logFromJS(message);
+    }
+    console.log(message);
+}
 
-    const ext = fileName.split('.').pop();
-    return extToLanguage[ext] || null;
+// Large payloads (tool output, Write content, terminal logs) arrive as
+// {blob, size} references to katecode://blob/ URLs and are only fetched when
+// something actually displays them.
+function isBlobRef(value) {
+    return value !== null && typeof value === 'object' && typeof value.blob === 'string';
 }
 
-// Highlight code using highlight.js
-function highlightCode(code, language) {
-    if (typeof hljs === 'undefined') {
-        return escapeHtml(code);
+// Fetch a blob's text once; onLoad gets the text, or a placeholder on failure
+function loadBlobText(ref, onLoad) {
+    if (ref.loading) {
+        return;
     }
+    ref.loading = true;
+    fetch(ref.blob)
+        .then(response => {
+            if (!response.ok) {
+                throw new Error('HTTP ' + response.status);
+            }
+            return response.text();
+        })
+        .then(onLoad)
+        .catch(e => {
+            logToQt('Failed to load ' + ref.blob + ': ' + e);
+            onLoad('[Content unavailable]');
+        });
+}
 
-    try {
-        if (language && hljs.getLanguage(language)) {
-            return hljs.highlight(code, { language: language }).value;
-        } else {
-            // Auto-detect if no language specified
-            return hljs.highlightAuto(code).value;
+// Start loading a tool call's blob fields; true while any is still missing
+function loadToolCallBlobs(toolCall) {
+    let pending = false;
+    for (const field of ['result', 'newText']) {
+        const ref = toolCall[field];
+        if (!isBlobRef(ref)) {
+            continue;
         }
-    } catch (e) {
-        logToQt('Highlight error: ' + e);
-        return escapeHtml(code);
+        pending = true;
+        loadBlobText(ref, text => {
+            if (toolCall[field] === ref) {
+                toolCall[field] = text;
+                invalidateToolCall(toolCall);
+                refreshToolCall(toolCall);
+            }
+        });
     }
+    return pending;
+}
+
+// Code is highlighted by KSyntaxHighlighting on the C++ side (CodeHighlighter),
+// with the definition taken from a file path or a fenced block's language.
+// highlight.js is only loaded for code whose language KSyntaxHighlighting
+// doesn't know, or when the bridge can't highlight at all.
+const NATIVE_CACHE_SIZE = 200;
+let nativeCache = new Map();     // Hint + code -> html, or null without a definition
+let nativePending = new Map();   // Same key -> promise of a request in flight
+let nativeRequests = new Map();  // Request id -> resolve function
+let nextNativeRequestId = 1;
+let highlightJsLoader = null;
+
+function nativeKey(code, filePath, language) {
+    return (filePath || '') + '\u0000' + (language || '') + '\u0000' + code;
 }
 
-// Split highlighted HTML into lines while preserving HTML tag structure
-// Handles tags that span multiple lines by closing and reopening them at line boundaries
-function splitHighlightedLines(html, expectedCount) {
-    const lines = [];
-    let currentLine = '';
-    let openTags = [];  // Stack of open tag names
+function cacheNativeResult(key, html) {
+    nativeCache.delete(key);
+    nativeCache.set(key, html);
+    if (nativeCache.size > NATIVE_CACHE_SIZE) {
+        nativeCache.delete(nativeCache.keys().next().value);
+    }
+}
 
-    let i = 0;
-    while (i < html.length) {
-        const char = html[i];
+// Promise of highlighted HTML for code; null if no definition matched
+function requestNativeHighlight(code, filePath, language) {
+    const key = nativeKey(code, filePath, language);
+    if (nativeCache.has(key)) {
+        return Promise.resolve(nativeCache.get(key));
+    }
+    if (nativePending.has(key)) {
+        return nativePending.get(key);
+    }
+    if (!bridge || !bridge.highlightCode) {
+        return Promise.resolve(null);
+    }
 
-        if (char === '\n') {
-            // Close all open tags for this line
-            let closingTags = '';
-            for (let t = openTags.length - 1; t >= 0; t--) {
-                closingTags += '</span>';
+    const requestId = nextNativeRequestId++;
+    const promise = new Promise(resolve => {
+        nativeRequests.set(requestId, html => {
+            nativePending.delete(key);
+            cacheNativeResult(key, html);
+            resolve(html);
+        });
+    });
+    nativePending.set(key, promise);
+    bridge.highlightCode(requestId, code, filePath || '', language || '');
+    return promise;
+}
+
+function onHighlightResult(requestId, html) {
+    const resolve = nativeRequests.get(requestId);
+    if (resolve) {
+        nativeRequests.delete(requestId);
+        resolve(html === undefined ? null : html);
+    }
+}
+
+// Load highlight.js into the page on first need
+function loadHighlightJs() {
+    if (!highlightJsLoader) {
+        highlightJsLoader = new Promise(resolve => {
+            if (typeof hljs !== 'undefined') {
+                resolve();
+                return;
             }
-            lines.push(currentLine + closingTags);
+            const script = document.createElement('script');
+            script.src = 'vendor/highlight.min.js';
+            script.onload = () => resolve();
+            script.onerror = () => {
+                logToQt('ERROR: highlight.js could not be loaded');
+                resolve();
+            };
+            document.head.appendChild(script);
+        });
+    }
+    return highlightJsLoader;
+}
 
-            // Start new line with reopened tags
-            currentLine = '';
-            for (let t = 0; t < openTags.length; t++) {
-                // Re-open with the same class - we need to track full opening tag
-                currentLine += `<span class="${openTags[t]}">`;
+// Highlighted HTML for code from KSyntaxHighlighting, else from highlight.js
+// for a known language; null if neither can do it
+function highlightAsync(code, filePath, language) {
+    return requestNativeHighlight(code, filePath, language).then(html => {
+        if (html !== null) {
+            return html;
+        }
+        const hljsLanguage = getLanguageFromPath(filePath) || language;
+        if (!hljsLanguage) {
+            return null;
+        }
+        return loadHighlightJs().then(() => {
+            if (typeof hljs === 'undefined' || !hljs.getLanguage(hljsLanguage)) {
+                return null;
             }
-            i++;
-        } else if (char === '<') {
-            // Parse HTML tag
-            const tagEnd = html.indexOf('>', i);
-            if (tagEnd === -1) {
-                currentLine += char;
-                i++;
-                continue;
+            return highlightCode(code, hljsLanguage);
+        });
+    });
+}
+
+// Markdown code blocks and permission previews render as plain text marked
+// with data-highlight-lang or data-highlight-path. This swaps in highlighted
+// markup; blocks still streaming in are left alone until they're complete.
+let highlightingBlocks = new WeakSet();
+
+function highlightCodeBlocks(root) {
+    if (!root) {
+        return;
+    }
+    const blocks = root.querySelectorAll('code[data-highlight-lang], code[data-highlight-path]');
+    for (const el of blocks) {
+        if (highlightingBlocks.has(el) || el.closest('.message-text-tail')) {
+            continue;
+        }
+        highlightingBlocks.add(el);
+        const language = el.dataset.highlightLang || '';
+        const filePath = el.dataset.highlightPath || '';
+        highlightAsync(el.textContent, filePath, language).then(html => {
+            highlightingBlocks.delete(el);
+            if (html !== null) {
+                el.innerHTML = html;
             }
+            el.removeAttribute('data-highlight-lang');
+            el.removeAttribute('data-highlight-path');
+        });
+    }
+}
 
-            const tagContent = html.substring(i + 1, tagEnd);
-            const fullTag = html.substring(i, tagEnd + 1);
-
-            if (tagContent.startsWith('/')) {
-                // Closing tag
-                openTags.pop();
-                currentLine += fullTag;
-            } else if (tagContent.startsWith('span')) {
-                // Opening span tag - extract class
-                const classMatch = tagContent.match(/class="([^"]+)"/);
-                const className = classMatch ? classMatch[1] : '';
-                openTags.push(className);
-                currentLine += fullTag;
-            } else {
-                // Other tag (shouldn't happen with hljs output)
-                currentLine += fullTag;
+// Markup for a markdown code block: highlighted right away when the result
+// is already cached, else plain text for highlightCodeBlocks() to pick up
+function renderCodeBlock(code, language) {
+    const languageClass = language ? ' language-' + escapeHtml(language) : '';
+    if (!language) {
+        return `<code class="hljs">${escapeHtml(code)}</code>`;
+    }
+    const key = nativeKey(code, '', language);
+    const cached = nativeCache.get(key);
+    if (typeof cached === 'string') {
+        return `<code class="hljs${languageClass}">${cached}</code>`;
+    }
+    if (cached === null && typeof hljs !== 'undefined' && hljs.getLanguage(language)) {
+        return `<code class="hljs${languageClass}">${highlightCode(code, language)}</code>`;
+    }
+    return `<code class="hljs${languageClass}" data-highlight-lang="${escapeHtml(language)}">${escapeHtml(code)}</code>`;
+}
+
+// Re-render a plain diff once both sides are highlighted
+function highlightDiffInto(diffEl, oldText, newText, fileName) {
+    if (!diffEl) {
+        return;
+    }
+    Promise.all([
+        requestNativeHighlight(oldText, fileName, ''),
+        requestNativeHighlight(newText, fileName, '')
+    ]).then(([oldHtml, newHtml]) => {
+        if (oldHtml !== null && newHtml !== null) {
+            diffEl.innerHTML = generateUnifiedDiff(oldText, newText, fileName, oldHtml, newHtml);
+        }
+    });
+}
+
+// Tool call content is highlighted by C++ and diffed in a small pool of
+// highlight-worker.js workers. Jobs are keyed by tool call id and a slot name;
+// the body shows plain text until the result arrives and is rebuilt then.
+const HIGHLIGHT_WORKER_COUNT = Math.max(1, Math.min(2, (navigator.hardwareConcurrency || 2) - 1));
+const HIGHLIGHT_SYNC_CHARS = 4096;  // Smaller inputs are done inline, no flash of plain text
+let highlightWorkers = null;        // Started on first use; empty if workers are unavailable
+let highlightQueue = [];
+let highlightJobs = new Map();      // Key -> job, queued or running
+let nextHighlightJobId = 1;
+
+function jobInputSize(job) {
+    return job.type === 'diff' ? job.oldText.length + job.newText.length : job.code.length;
+}
+
+function sameJobInput(a, b) {
+    return Object.keys(a).every(key => a[key] === b[key]);
+}
+
+function startHighlightWorkers() {
+    highlightWorkers = [];
+    if (typeof Worker === 'undefined') {
+        return;
+    }
+    for (let i = 0; i < HIGHLIGHT_WORKER_COUNT; i++) {
+        const slot = { worker: null, job: null };
+        try {
+            spawnHighlightWorker(slot);
+        } catch (e) {
+            logToQt('Highlight workers unavailable: ' + e);
+            highlightWorkers = [];
+            return;
+        }
+        highlightWorkers.push(slot);
+    }
+}
+
+function spawnHighlightWorker(slot) {
+    slot.worker = new Worker('highlight-worker.js');
+    slot.worker.onmessage = event => onHighlightWorkerMessage(slot, event.data);
+    slot.worker.onerror = event => {
+        // Typically the worker failed to load; finish everything inline instead
+        logToQt('Highlight worker error: ' + event.message);
+        event.preventDefault();
+        stopHighlightWorkers();
+        const pending = Array.from(highlightJobs.values());
+        highlightJobs.clear();
+        highlightQueue = [];
+        for (const job of pending) {
+            finishHighlightJob(job, null);
+        }
+    };
+}
+
+function stopHighlightWorkers() {
+    for (const slot of highlightWorkers) {
+        slot.worker.terminate();
+    }
+    highlightWorkers = [];
+}
+
+// HTML rendered from job for one part of a tool call body, or null while the
+// workers are still on it
+function renderInWorker(toolCall, slot, job) {
+    const rendered = toolCall.rendered || (toolCall.rendered = {});
+    const done = rendered[slot];
+    if (done && sameJobInput(job, done.input)) {
+        return done.html;
+    }
+
+    const key = toolCall.id + ':' + slot;
+    const pending = highlightJobs.get(key);
+    if (pending && sameJobInput(job, pending.input)) {
+        return null;
+    }
+    if (pending) {
+        cancelHighlightJob(pending);
+    }
+
+    const entry = { id: nextHighlightJobId++, key: key, toolCall: toolCall, slot: slot, input: job };
+    highlightJobs.set(key, entry);
+    highlightNatively(entry);
+    return null;
+}
+
+// Highlighting goes to C++ first; workers then build diffs from its output, or
+// fall back to highlight.js for languages it has no definition for
+function highlightNatively(entry) {
+    const job = entry.input;
+    const isCurrent = () => highlightJobs.get(entry.key) === entry;
+
+    if (job.type === 'highlight') {
+        requestNativeHighlight(job.code, job.filePath, '').then(html => {
+            if (!isCurrent()) {
+                return;
             }
-            i = tagEnd + 1;
-        } else {
-            currentLine += char;
-            i++;
+            if (html === null && job.language) {
+                dispatchHighlightJob(entry);
+                return;
+            }
+            // Without a known language the text stays plain rather than guessed
+            highlightJobs.delete(entry.key);
+            finishHighlightJob(entry, html !== null ? html : escapeHtml(job.code));
+        });
+        return;
+    }
+
+    Promise.all([
+        requestNativeHighlight(job.oldText, job.fileName, ''),
+        requestNativeHighlight(job.newText, job.fileName, '')
+    ]).then(([oldHtml, newHtml]) => {
+        if (!isCurrent()) {
+            return;
         }
+        if (oldHtml !== null && newHtml !== null) {
+            entry.input = Object.assign({}, job, { oldHtml: oldHtml, newHtml: newHtml });
+        }
+        dispatchHighlightJob(entry);
+    });
+}
+
+// Run a job in a worker, or inline when it is small, needs no highlight.js or
+// workers are unavailable
+function dispatchHighlightJob(entry) {
+    if (highlightWorkers === null) {
+        startHighlightWorkers();
+    }
+    const needsHljs = entry.input.type === 'highlight' || entry.input.oldHtml === undefined;
+    const inline = highlightWorkers.length === 0 ||
+        (jobInputSize(entry.input) < HIGHLIGHT_SYNC_CHARS && (!needsHljs || typeof hljs !== 'undefined'));
+    if (!inline) {
+        highlightQueue.push(entry);
+        pumpHighlightQueue();
+        return;
+    }
+
+    const run = () => {
+        if (highlightJobs.get(entry.key) === entry) {
+            highlightJobs.delete(entry.key);
+            finishHighlightJob(entry, runHighlightJob(entry.input));
+        }
+    };
+    if (needsHljs) {
+        loadHighlightJs().then(run);
+    } else {
+        run();
     }
+}
 
-    // Don't forget the last line (if no trailing newline)
-    if (currentLine || lines.length < expectedCount) {
-        // Close any remaining open tags
-        let closingTags = '';
-        for (let t = openTags.length - 1; t >= 0; t--) {
-            closingTags += `</span>`;
+function pumpHighlightQueue() {
+    for (const slot of highlightWorkers) {
+        if (highlightQueue.length === 0) {
+            return;
+        }
+        if (!slot.job) {
+            slot.job = highlightQueue.shift();
+            slot.worker.postMessage(Object.assign({ jobId: slot.job.id }, slot.job.input));
         }
-        lines.push(currentLine + closingTags);
     }
+}
 
-    // Ensure we have the expected number of lines
-    while (lines.length < expectedCount) {
-        lines.push('');
+function onHighlightWorkerMessage(slot, data) {
+    if (data.log !== undefined) {
+        logToQt(data.log);
+        return;
+    }
+    const job = slot.job;
+    slot.job = null;
+    if (job && job.id === data.jobId && highlightJobs.get(job.key) === job) {
+        highlightJobs.delete(job.key);
+        if (data.error) {
+            logToQt('Highlight job failed: ' + data.error);
+        }
+        finishHighlightJob(job, data.error ? null : data.html);
     }
+    pumpHighlightQueue();
+}
 
-    return lines;
+// Store a result and rebuild the tool call; a null html falls back to inline rendering
+function finishHighlightJob(job, html) {
+    const toolCall = job.toolCall;
+    if (html === null) {
+        try {
+            html = runHighlightJob(job.input);
+        } catch (e) {
+            return;
+        }
+    }
+    toolCall.rendered = toolCall.rendered || {};
+    toolCall.rendered[job.slot] = { input: job.input, html: html };
+    invalidateToolCall(toolCall);
+    refreshToolCall(toolCall);
 }
 
-// Helper to log to C++ via bridge
-function logToQt(message) {
-    if (window.bridge && window.bridge.logFromJS) {
-        window.bridge.logFromJS(message);
+function cancelHighlightJob(job) {
+    highlightJobs.delete(job.key);
+    const queued = highlightQueue.indexOf(job);
+    if (queued >= 0) {
+        highlightQueue.splice(queued, 1);
+        return;
+    }
+    // Already running: a worker can't be interrupted, so replace it
+    for (const slot of highlightWorkers || []) {
+        if (slot.job === job) {
+            slot.worker.terminate();
+            slot.job = null;
+            spawnHighlightWorker(slot);
+            pumpHighlightQueue();
+            return;
+        }
+    }
+}
+
+// Drop work for a message's tool calls, e.g. once it has scrolled away. They
+// show plain text now, so the message is rebuilt (and resubmits) on remount.
+function cancelHighlightJobsForMessage(message) {
+    let cancelled = false;
+    for (const job of Array.from(highlightJobs.values())) {
+        if (job.toolCall.messageId === message.id) {
+            cancelHighlightJob(job);
+            invalidateToolCall(job.toolCall);
+            cancelled = true;
+        }
+    }
+    if (cancelled && message.unmounted) {
+        message.cachedHtml = null;
+    }
+}
+
+function cancelAllHighlightJobs() {
+    for (const job of Array.from(highlightJobs.values())) {
+        cancelHighlightJob(job);
     }
-    console.log(message);
 }
 
 // Configure marked.js with syntax highlighting
 function configureMarked() {
     logToQt('Configuring marked.js...');
     logToQt('marked available: ' + (typeof marked !== 'undefined'));
-    logToQt('hljs available: ' + (typeof hljs !== 'undefined'));
 
     if (typeof marked === 'undefined') {
         logToQt('ERROR: marked.js not loaded!');
         return;
     }
 
-    if (typeof hljs === 'undefined') {
-        logToQt('ERROR: highlight.js not loaded!');
-        return;
-    }
-
     // marked.js v11+ requires using a custom renderer with hooks
     const renderer = {
         code(code, infostring) {
             const lang = (infostring || '').match(/\S*/)[0];
-            logToQt('Renderer code() called - lang: ' + lang + ', code length: ' + code.length);
-
-            if (typeof hljs !== 'undefined') {
-                let highlighted;
-                if (lang && hljs.getLanguage(lang)) {
-                    try {
-                        highlighted = hljs.highlight(code, { language: lang }).value;
-                        logToQt('Highlighted with language: ' + lang);
-                    } catch (e) {
-                        logToQt('Highlight error: ' + e);
-                        highlighted = code;
-                    }
-                } else {
-                    // Auto-detect language if not specified
-                    try {
-                        const result = hljs.highlightAuto(code);
-                        highlighted = result.value;
-                        logToQt('Auto-detected language: ' + result.language);
-                    } catch (e) {
-                        logToQt('Highlight auto error: ' + e);
-                        highlighted = code;
-                    }
-                }
-
-                // Base64 encode the code to safely store in data attribute
-                const encodedCode = btoa(unescape(encodeURIComponent(code)));
-
-                return '<div class="code-block-wrapper">' +
-                       '<button class="code-copy-btn" onclick="copyCode(this)" data-code-b64="' + encodedCode + '" title="Copy code"><span class="material-icon material-icon-sm">content_copy</span></button>' +
-                       '<pre><code class="hljs language-' + lang + '">' + highlighted + '</code></pre>' +
-                       '</div>';
-            }
 
+            // Base64 encode the code to safely store in data attribute
             const encodedCode = btoa(unescape(encodeURIComponent(code)));
+
             return '<div class="code-block-wrapper">' +
                    '<button class="code-copy-btn" onclick="copyCode(this)" data-code-b64="' + encodedCode + '" title="Copy code"><span class="material-icon material-icon-sm">content_copy</span></button>' +
-                   '<pre><code>' + code + '</code></pre>' +
+                   '<pre>' + renderCodeBlock(code, lang) + '</pre>' +
                    '</div>';
         }
     };
@@ -387,10 +628,14 @@ document.addEventListener('DOMContentLoaded', () => {
             configureMarked();
 
             // If libraries aren't loaded yet, try again after a delay
-            if (typeof marked === 'undefined' || typeof hljs === 'undefined') {
+            if (typeof marked === 'undefined') {
                 logToQt('Libraries not ready, retrying in 500ms...');
                 setTimeout(configureMarked, 500);
             }
+
+            // C++ holds its updates until the page listens for them
+            bridge.updatesPushed.connect(applyUpdates);
+            bridge.notifyReady();
         });
     } else {
         console.warn('QWebChannel or qt not available');
@@ -399,6 +644,51 @@ document.addEventListener('DOMContentLoaded', () => {
     }
 });
 
+// Apply a batch of typed updates pushed from C++ (ChatWebView::flushUpdates)
+const updateHandlers = {
+    addMessage: u => addMessage(u.id, u.role, u.content, u.timestamp, u.isStreaming, u.images),
+    updateMessage: u => updateMessage(u.messageId, u.content),
+    finishMessage: u => finishMessage(u.messageId),
+    addToolCall: u => addToolCall(u.messageId, u.toolCallId, u.name, u.status, u.filePath,
+                                  u.input, u.oldText, u.newText, u.edits, u.terminalId),
+    updateToolCall: u => updateToolCall(u.messageId, u.toolCallId, u.status, u.result, u.filePath, u.toolName),
+    setToolCallTerminalId: u => setToolCallTerminalId(u.messageId, u.toolCallId, u.terminalId),
+    updateTerminal: u => updateTerminal(u.terminalId, u.output, u.finished),
+    permissionRequest: u => showPermissionRequest(u.requestId, u.toolName, u.input, u.options),
+    userQuestion: u => showUserQuestion(u.requestId, u.questions),
+    removeUserQuestion: u => removeUserQuestion(u.requestId),
+    updateTodos: u => updateTodos(u.todos),
+    highlightResult: u => onHighlightResult(u.requestId, u.html),
+    clearMessages: () => clearMessages(),
+    addTrackedEdit: u => addTrackedEdit(u.edit),
+    clearEditSummary: () => clearEditSummary(),
+    diffColors: u => applyDiffColors(u.removeBackground, u.addBackground),
+    colorScheme: u => {
+        applyColorScheme(u.cssVars);
+        if (u.highlightCss) {
+            applyCustomHighlightCSS(u.highlightCss);
+        } else {
+            applyHighlightTheme(u.highlightTheme);
+        }
+    }
+};
+
+function applyUpdates(updates) {
+    for (const update of updates) {
+        const handler = updateHandlers[update.type];
+        if (!handler) {
+            logToQt('Unknown update type: ' + update.type);
+            continue;
+        }
+        // One failing update must not take the rest of the batch with it
+        try {
+            handler(update);
+        } catch (e) {
+            console.error('Update ' + update.type + ' failed:', e);
+        }
+    }
+}
+
 // Add a new message
 function addMessage(id, role, content, timestamp, isStreaming, images) {
     const message = {
@@ -408,7 +698,7 @@ function addMessage(id, role, content, timestamp, isStreaming, images) {
         timestamp: timestamp || new Date().toISOString(),
         isStreaming: isStreaming || false,
         toolCalls: [],
-        images: images || []  // Array of {data, mimeType, width, height}
+        images: images || []  // Array of {url, mimeType, width, height}
     };
 
     messages[id] = message;
@@ -418,41 +708,145 @@ function addMessage(id, role, content, timestamp, isStreaming, images) {
 
 // Update message content (for streaming)
 function updateMessage(id, content) {
-    if (!messages[id]) return;
+    const message = messages[id];
+    if (!message) return;
 
-    messages[id].content += content;
-    updateMessageDOM(id);
+    // marked's lexer normalizes line endings; keep offsets in step with it
+    message.content += content.replace(/\r\n?/g, '\n');
+    if (!renderStreamingText(message, false)) {
+        updateMessageDOM(id);
+    }
     scrollToBottom();
 }
 
 // Finish streaming
 function finishMessage(id) {
-    if (!messages[id]) return;
+    const message = messages[id];
+    if (!message) return;
 
-    messages[id].isStreaming = false;
+    message.isStreaming = false;
+    if (message.stream && renderStreamingText(message, true)) {
+        const messageEl = document.getElementById(`message-${id}`);
+        if (messageEl) {
+            messageEl.classList.remove('streaming');
+        }
+        return;
+    }
     updateMessageDOM(id);
 }
 
-// Add tool call to message
-function addToolCall(messageId, toolCallId, name, status, filePath, inputJson, oldText, newText, editsJson, terminalId) {
-    if (!messages[messageId]) return;
+// Incremental rendering of the trailing text of a streaming message.
+// The text is split into top-level blocks with marked.lexer(). A block
+// followed by another block can no longer change, so it is rendered once and
+// inserted as frozen DOM; only the last, still open block (paragraph, list,
+// fenced code) is re-rendered per chunk. Frozen nodes are never replaced,
+// which keeps text selection and scroll position stable while streaming.
+// Returns false if the message has to be rendered in full instead.
+function renderStreamingText(message, final) {
+    if (message.role !== 'assistant' || typeof marked === 'undefined') {
+        return false;
+    }
+
+    let stream = message.stream;
+    if (!stream || !stream.tailEl.isConnected) {
+        stream = startStreamingText(message);
+        if (!stream) {
+            return false;
+        }
+    }
 
-    // Parse input to extract command for Bash tools
-    let input = {};
-    try {
-        input = inputJson ? JSON.parse(inputJson) : {};
-    } catch (e) {
-        console.warn('Failed to parse tool input JSON:', e);
+    const tokens = marked.lexer(message.content.substring(stream.offset));
+
+    // Blocks before the last non-space one are complete. Trailing blank lines
+    // don't close a block yet: a list item can still continue after them.
+    let open = tokens.length;
+    if (!final) {
+        open = tokens.length - 1;
+        while (open > 0 && tokens[open].type === 'space') {
+            open--;
+        }
+        open = Math.max(open, 0);
     }
 
-    // Parse edits array
-    let edits = [];
-    try {
-        edits = editsJson ? JSON.parse(editsJson) : [];
-    } catch (e) {
-        console.warn('Failed to parse edits JSON:', e);
+    if (open > 0) {
+        const frozen = tokens.slice(0, open);
+        frozen.links = tokens.links;
+        stream.tailEl.insertAdjacentHTML('beforebegin', marked.parser(frozen));
+        highlightCodeBlocks(stream.tailEl.parentElement);
+        const lexedLength = frozen.reduce((length, token) => length + token.raw.length, 0);
+        stream.offset += sourceLength(message.content, stream.offset, lexedLength);
+    }
+
+    if (final) {
+        const textEl = stream.tailEl.parentElement;
+        stream.tailEl.remove();
+        highlightCodeBlocks(textEl);
+        message.stream = null;
+        return true;
+    }
+
+    const tail = tokens.slice(open);
+    tail.links = tokens.links;
+    const tailHtml = tail.length > 0 ? marked.parser(tail) : '';
+    if (tailHtml !== stream.tailHtml) {
+        stream.tailEl.innerHTML = tailHtml;
+        stream.tailHtml = tailHtml;
+    }
+    return true;
+}
+
+// marked's lexer expands tabs leading a line to four spaces each, so token.raw
+// can be longer than the text it was lexed from. Returns how many characters
+// of source, starting at offset, produced lexedLength characters of raw.
+function sourceLength(source, offset, lexedLength) {
+    let i = offset;
+    let lexed = 0;
+    let indent = 'spaces';  // 'spaces', then 'tabs', then 'done' for the line
+    while (lexed < lexedLength && i < source.length) {
+        const c = source[i++];
+        if (c === '\n') {
+            indent = 'spaces';
+            lexed++;
+        } else if (c === '\t' && indent !== 'done') {
+            indent = 'tabs';
+            lexed += 4;
+        } else {
+            if (c !== ' ' || indent === 'tabs') {
+                indent = 'done';
+            }
+            lexed++;
+        }
+    }
+    return i - offset;
+}
+
+// Take over the trailing text element rendered by createMessageHTML
+function startStreamingText(message) {
+    const messageEl = document.getElementById(`message-${message.id}`);
+    const textEl = messageEl && messageEl.querySelector('.message-content > .message-text:last-child');
+    if (!textEl) {
+        return null;
     }
 
+    const tailEl = document.createElement('div');
+    tailEl.className = 'message-text-tail';
+    textEl.replaceChildren(tailEl);
+
+    message.stream = {
+        tailEl: tailEl,
+        tailHtml: '',
+        offset: parseInt(textEl.dataset.offset, 10) || 0
+    };
+    return message.stream;
+}
+
+// Add tool call to message
+function addToolCall(messageId, toolCallId, name, status, filePath, input, oldText, newText, edits, terminalId) {
+    if (!messages[messageId]) return;
+
+    input = input || {};
+    edits = edits || [];
+
     // Check if tool call already exists (avoid duplicates)
     const existing = messages[messageId].toolCalls.find(tc => tc.id === toolCallId);
     if (existing) {
@@ -465,10 +859,18 @@ function addToolCall(messageId, toolCallId, name, status, filePath, inputJson, o
         existing.newText = newText || '';
         existing.edits = edits.length > 0 ? edits : existing.edits;
         existing.terminalId = terminalId || existing.terminalId;
+        if (existing.terminalId) {
+            terminalOwners.set(existing.terminalId, existing);
+        }
+        invalidateToolCall(existing);
+        refreshToolCall(existing);
+        scrollToBottom();
+        return;
     } else {
         // Add new tool call at current content length position
         const toolCall = {
             id: toolCallId,
+            messageId: messageId,
             name: name,
             status: status,
             filePath: filePath || '',
@@ -481,34 +883,28 @@ function addToolCall(messageId, toolCallId, name, status, filePath, inputJson, o
             terminalId: terminalId || ''
         };
         messages[messageId].toolCalls.push(toolCall);
+        toolCallsById.set(toolCallId, toolCall);
+        if (toolCall.terminalId) {
+            terminalOwners.set(toolCall.terminalId, toolCall);
+        }
     }
 
     updateMessageDOM(messageId);
     scrollToBottom();
 }
 
-// Update tool call status - result is Base64 encoded to handle ANSI escape codes
-function updateToolCall(messageId, toolCallId, status, base64Result, filePath, toolName) {
+// Update tool call status
+function updateToolCall(messageId, toolCallId, status, result, filePath, toolName) {
     if (!messages[messageId]) return;
 
-    // Decode base64 result
-    let result = '';
-    if (base64Result) {
-        try {
-            result = decodeURIComponent(escape(atob(base64Result)));
-        } catch (e) {
-            console.error('Failed to decode tool result:', e);
-            result = base64Result;  // Fall back to raw value
-        }
-    }
-
-    let toolCall = messages[messageId].toolCalls.find(tc => tc.id === toolCallId);
+    let toolCall = toolCallsById.get(toolCallId);
 
     if (!toolCall) {
         // Tool call doesn't exist yet (happens when tool_call event was skipped, e.g. Gemini)
         // Create it now with the result - use provided toolName or fall back to 'Unknown'
         toolCall = {
             id: toolCallId,
+            messageId: messageId,
             name: toolName || 'Unknown',
             status: status || 'completed',
             filePath: filePath || '',
@@ -519,6 +915,7 @@ function updateToolCall(messageId, toolCallId, status, base64Result, filePath, t
             newText: ''
         };
         messages[messageId].toolCalls.push(toolCall);
+        toolCallsById.set(toolCallId, toolCall);
     } else {
         // Update existing tool call
         if (status) {
@@ -532,6 +929,9 @@ function updateToolCall(messageId, toolCallId, status, base64Result, filePath, t
         if (filePath) {
             toolCall.filePath = filePath;
         }
+        invalidateToolCall(toolCall);
+        refreshToolCall(toolCall);
+        return;
     }
 
     updateMessageDOM(messageId);
@@ -547,9 +947,12 @@ function renderMessage(message) {
         messageEl.classList.add('streaming');
     }
     messageEl.id = `message-${message.id}`;
+    messageEl.dataset.messageId = message.id;
 
     messageEl.innerHTML = createMessageHTML(message);
     container.appendChild(messageEl);
+    highlightCodeBlocks(messageEl);
+    observeMessage(messageEl);
 }
 
 // Update existing message in DOM
@@ -560,12 +963,83 @@ function updateMessageDOM(id) {
     const messageEl = document.getElementById(`message-${id}`);
     if (!messageEl) return;
 
+    // Off-screen messages re-render when they are mounted again
+    if (message.unmounted) {
+        message.cachedHtml = null;
+        return;
+    }
+
     messageEl.className = `message ${message.role}`;
     if (message.isStreaming) {
         messageEl.classList.add('streaming');
     }
 
+    // The streamed text is rebuilt below; streaming picks it up again from there
+    message.stream = null;
     messageEl.innerHTML = createMessageHTML(message);
+    highlightCodeBlocks(messageEl);
+}
+
+// Windowed rendering for long sessions. Only messages near the viewport keep
+// their DOM; the others are emptied into placeholders of the same height,
+// with their HTML cached so mounting them again is one innerHTML assignment.
+const MOUNT_MARGIN_PX = 1500;
+let messageObserver = null;
+
+function observeMessage(messageEl) {
+    if (typeof IntersectionObserver === 'undefined') {
+        return;
+    }
+    if (!messageObserver) {
+        messageObserver = new IntersectionObserver(onMessagesIntersect, {
+            rootMargin: `${MOUNT_MARGIN_PX}px 0px`
+        });
+    }
+    messageObserver.observe(messageEl);
+}
+
+function onMessagesIntersect(entries) {
+    for (const entry of entries) {
+        const message = messages[entry.target.dataset.messageId];
+        if (!message) {
+            continue;
+        }
+        if (entry.isIntersecting) {
+            mountMessage(message, entry.target);
+        } else {
+            unmountMessage(message, entry.target, entry.boundingClientRect.height);
+        }
+    }
+}
+
+function unmountMessage(message, messageEl, height) {
+    // Streaming messages are written to directly, see renderStreamingText()
+    if (message.unmounted || message.isStreaming || height === 0) {
+        return;
+    }
+    message.cachedHtml = messageEl.innerHTML;
+    message.unmounted = true;
+    messageEl.style.height = height + 'px';
+    messageEl.classList.add('message-placeholder');
+    messageEl.replaceChildren();
+    cancelHighlightJobsForMessage(message);
+}
+
+function mountMessage(message, messageEl) {
+    if (!message.unmounted) {
+        return;
+    }
+    message.unmounted = false;
+    messageEl.style.height = '';
+    messageEl.classList.remove('message-placeholder');
+    if (message.cachedHtml !== null) {
+        messageEl.innerHTML = message.cachedHtml;
+        message.cachedHtml = null;
+        highlightCodeBlocks(messageEl);
+    } else {
+        // Changed while unmounted
+        updateMessageDOM(message.id);
+    }
 }
 
 // Create HTML for a message with inline tool calls
@@ -600,8 +1074,10 @@ function createMessageHTML(message) {
             lastPos = toolCall.position;
         }
 
-        // Add remaining content after last tool call
+        // Add remaining content after last tool call. Streaming chunks
+        // continue this element, see renderStreamingText().
         const textAfter = message.content.substring(lastPos);
+        html += `<div class="message-text" data-offset="${lastPos}">`;
         if (textAfter) {
             if (typeof marked !== 'undefined') {
                 html += marked.parse(textAfter);
@@ -609,6 +1085,7 @@ function createMessageHTML(message) {
                 html += escapeHtml(textAfter);
             }
         }
+        html += '</div>';
     } else {
         // No tool calls or not assistant - render content normally
         const content = message.content || '';
@@ -617,8 +1094,10 @@ function createMessageHTML(message) {
             if (message.role === 'user') {
                 html += `<div class="user-markdown">${rendered}</div>`;
             } else {
-                html += rendered;
+                html += `<div class="message-text" data-offset="0">${rendered}</div>`;
             }
+        } else if (message.role === 'assistant') {
+            html += `<div class="message-text" data-offset="0">${escapeHtml(content)}</div>`;
         } else {
             // For system messages, just escape HTML
             html += escapeHtml(message.role === 'system' ? content.trim() : content);
@@ -628,8 +1107,7 @@ function createMessageHTML(message) {
         if (message.role === 'user' && message.images && message.images.length > 0) {
             html += '<div class="message-images">';
             for (const img of message.images) {
-                const dataUrl = `data:${img.mimeType};base64,${img.data}`;
-                html += `<img src="${dataUrl}" class="message-image" alt="Attached image" style="max-width: 300px; max-height: 300px; border-radius: 4px; margin-top: 8px;">`;
+                html += `<img src="${escapeHtml(img.url)}" loading="lazy" class="message-image" alt="Attached image" style="max-width: 300px; max-height: 300px; border-radius: 4px; margin-top: 8px;">`;
             }
             html += '</div>';
         }
@@ -639,11 +1117,39 @@ function createMessageHTML(message) {
     return html;
 }
 
+function isToolCallExpanded(toolCall) {
+    // Edit tools are expanded by default to show the diff inline
+    return toolCall.expanded !== undefined ? toolCall.expanded : isEditTool(toolCall.name);
+}
+
+// Drop a tool call's cached body after its data changed
+function invalidateToolCall(toolCall) {
+    toolCall.bodyHtml = null;
+}
+
+// Re-render one tool call in place, leaving the rest of its message alone.
+// A collapsed body stays unbuilt; an unmounted message re-renders on mount.
+function refreshToolCall(toolCall) {
+    const message = messages[toolCall.messageId];
+    if (!message) return;
+
+    if (message.unmounted) {
+        message.cachedHtml = null;
+        return;
+    }
+
+    const toolCallEl = document.getElementById(`tool-call-${toolCall.id}`);
+    if (!toolCallEl) {
+        updateMessageDOM(toolCall.messageId);
+        return;
+    }
+    toolCallEl.outerHTML = renderToolCall(toolCall);
+}
+
 // Render a single tool call as inline element
 function renderToolCall(toolCall) {
     const fileName = toolCall.filePath ? toolCall.filePath.split('/').pop() : '';
-    // Edit tools are expanded by default to show the diff inline
-    const isExpanded = toolCall.expanded !== undefined ? toolCall.expanded : isEditTool(toolCall.name);
+    const isExpanded = isToolCallExpanded(toolCall);
 
     // Extract command for Bash tools (including MCP variants like mcp__acp__Bash)
     let commandDisplay = '';
@@ -730,7 +1236,7 @@ function renderToolCall(toolCall) {
     const isKate = isKateTool(toolCall.name);
 
     let html = `
-        <div class="tool-call-inline ${toolCall.status}${extraClasses}" data-tool-id="${escapeHtml(toolCall.id)}">
+        <div class="tool-call-inline ${toolCall.status}${extraClasses}" id="tool-call-${escapeHtml(toolCall.id)}" data-tool-id="${escapeHtml(toolCall.id)}">
             <div class="tool-call-summary" onclick="toggleToolCall('${escapeHtml(toolCall.id)}')">
                 <span class="tool-call-icon">${toolIcon}</span>
                 <span class="tool-call-name">${escapeHtml(displayName)}</span>
@@ -746,289 +1252,188 @@ function renderToolCall(toolCall) {
     `;
 
     if (isExpanded) {
-        html += '<div class="tool-call-details">';
-
-        // Show full command for Bash tools (including MCP variants)
-        if (isBashTool(toolCall.name) && toolCall.input && toolCall.input.command) {
-            html += `<div class="tool-call-input"><strong>Command:</strong><pre>${escapeHtml(toolCall.input.command)}</pre></div>`;
-        }
-
-        // Show Edit tool as unified diff(s)
-        if (isEditTool(toolCall.name)) {
-            // Check if we have multiple edits array
-            if (toolCall.edits && toolCall.edits.length > 0) {
-                html += `<div class="tool-call-input">
-                    <strong>Diff${toolCall.edits.length > 1 ? 's' : ''}:</strong>`;
-
-                for (let i = 0; i < toolCall.edits.length; i++) {
-                    const edit = toolCall.edits[i];
-                    const editFileName = edit.filePath || fileName || `edit ${i + 1}`;
-                    const diff = generateUnifiedDiff(edit.oldText, edit.newText, editFileName);
-
-                    if (toolCall.edits.length > 1) {
-                        html += `<div class="edit-section">
-                            <div class="edit-header">Edit ${i + 1} of ${toolCall.edits.length}${edit.filePath ? ': ' + escapeHtml(edit.filePath) : ''}</div>
-                            <pre class="diff">${diff}</pre>
-                        </div>`;
-                    } else {
-                        html += `<pre class="diff">${diff}</pre>`;
-                    }
-                }
-
-                html += `</div>`;
-            } else if (toolCall.oldText !== undefined && toolCall.newText !== undefined) {
-                // Backward compatibility: single edit with oldText/newText
-                const diff = generateUnifiedDiff(toolCall.oldText, toolCall.newText, fileName);
-                html += `<div class="tool-call-input">
-                    <strong>Diff:</strong>
-                    <pre class="diff">${diff}</pre>
-                </div>`;
-            }
-        }
-
-        // Show Write tool content with syntax highlighting
-        if (isWriteTool(toolCall.name) && toolCall.newText) {
-            const language = getLanguageFromPath(toolCall.filePath);
-            const highlighted = highlightCode(toolCall.newText, language);
-            const encodedCode = btoa(unescape(encodeURIComponent(toolCall.newText)));
-            html += `<div class="tool-call-input">
-                <strong>Content:</strong>
-                <div class="code-block-wrapper">
-                    <button class="code-copy-btn" onclick="copyCode(this)" data-code-b64="${encodedCode}" title="Copy code"><span class="material-icon material-icon-sm">content_copy</span></button>
-                    <pre><code class="hljs${language ? ' language-' + language : ''}">${highlighted}</code></pre>
-                </div>
-            </div>`;
-        }
-
-        // Show Task tool details
-        if (toolCall.name === 'Task' && toolCall.input) {
-            const prompt = toolCall.input.prompt || '';
-            const model = toolCall.input.model;
-
-            html += `<div class="tool-call-input task-details">`;
-
-            if (model) {
-                html += `<div class="task-model-info"><strong>Model:</strong> ${escapeHtml(model)}</div>`;
-            }
+        html += renderToolCallBody(toolCall);
+    }
 
-            if (prompt) {
-                html += `<strong>Prompt:</strong><pre class="task-prompt">${escapeHtml(prompt)}</pre>`;
-            }
+    html += '</div>';
+    return html;
+}
 
-            html += `</div>`;
-        }
+// Body of an expanded tool call. Built on first expand and cached in
+// toolCall.bodyHtml until invalidateToolCall(); collapsed bodies are never built.
+function renderToolCallBody(toolCall) {
+    // Payloads still being fetched show a placeholder until they arrive
+    if (loadToolCallBlobs(toolCall)) {
+        return '<div class="tool-call-details"><div class="tool-call-loading">Loading…</div></div>';
+    }
+    if (!toolCall.bodyHtml) {
+        toolCall.bodyHtml = buildToolCallBody(toolCall);
+    }
+    return toolCall.bodyHtml;
+}
 
-        // Show TaskOutput tool details
-        if (toolCall.name === 'TaskOutput' && toolCall.input) {
-            const taskId = toolCall.input.task_id || '';
-            const timeout = toolCall.input.timeout;
+// Unified diff for one edit, or its header and a placeholder while it's computed
+function renderDiffInWorker(toolCall, slot, oldText, newText, fileName) {
+    const job = { type: 'diff', oldText: oldText || '', newText: newText || '', fileName: fileName };
+    const diff = renderInWorker(toolCall, slot, job);
+    if (diff !== null) {
+        return diff;
+    }
+    return `<span class="diff-header">--- ${escapeHtml(fileName || 'file')}</span>` +
+           `<span class="diff-header">+++ ${escapeHtml(fileName || 'file')}</span>` +
+           `<span class="diff-context tool-call-loading">Computing diff…</span>`;
+}
 
-            html += `<div class="tool-call-input task-output-details">`;
-            html += `<strong>Task ID:</strong> <code>${escapeHtml(taskId)}</code>`;
-            if (timeout) {
-                html += `<br><strong>Timeout:</strong> ${timeout}ms`;
-            }
-            html += `</div>`;
-        }
+function buildToolCallBody(toolCall) {
+    const fileName = toolCall.filePath ? toolCall.filePath.split('/').pop() : '';
+    let html = '<div class="tool-call-details">';
 
-        // Show result if available (skip for Write/Edit since we show content above)
-        // Also skip if we have terminal output (terminal replaces the result display)
-        if (toolCall.result && !isWriteTool(toolCall.name) && !isEditTool(toolCall.name) && !toolCall.terminalId) {
-            if (isReadTool(toolCall.name)) {
-                // For Read tool, clean and highlight the result
-                const cleanedCode = cleanReadResult(toolCall.result);
-                const language = getLanguageFromPath(toolCall.filePath);
-                const highlighted = highlightCode(cleanedCode, language);
-                const encodedCode = btoa(unescape(encodeURIComponent(cleanedCode)));
-                html += `<div class="tool-call-result-section">
-                    <strong>Result:</strong>
-                    <div class="code-block-wrapper">
-                        <button class="code-copy-btn" onclick="copyCode(this)" data-code-b64="${encodedCode}" title="Copy code"><span class="material-icon material-icon-sm">content_copy</span></button>
-                        <pre><code class="hljs${language ? ' language-' + language : ''}">${highlighted}</code></pre>
-                    </div>
-                </div>`;
-            } else if (isBashTool(toolCall.name)) {
-                // Bash/terminal tools - parse exit code and render with structured layout
-                const parsed = parseBashResult(toolCall.result);
-                const exitCodeClass = parsed.exitCode === 0 ? 'exit-success' : (parsed.exitCode !== null ? 'exit-error' : '');
+    // Show full command for Bash tools (including MCP variants)
+    if (isBashTool(toolCall.name) && toolCall.input && toolCall.input.command) {
+        html += `<div class="tool-call-input"><strong>Command:</strong><pre>${escapeHtml(toolCall.input.command)}</pre></div>`;
+    }
 
-                html += `<div class="tool-call-result-section bash-result-section ${exitCodeClass}">`;
+    // Show Edit tool as unified diff(s)
+    if (isEditTool(toolCall.name)) {
+        // Check if we have multiple edits array
+        if (toolCall.edits && toolCall.edits.length > 0) {
+            html += `<div class="tool-call-input">
+                <strong>Diff${toolCall.edits.length > 1 ? 's' : ''}:</strong>`;
 
-                // Show exit code if available
-                if (parsed.exitCode !== null) {
-                    html += `<div class="bash-exit-code ${exitCodeClass}"><strong>Exit code:</strong> <span class="exit-code-value">${parsed.exitCode}</span></div>`;
-                }
+            for (let i = 0; i < toolCall.edits.length; i++) {
+                const edit = toolCall.edits[i];
+                const editFileName = edit.filePath || fileName || `edit ${i + 1}`;
+                const diff = renderDiffInWorker(toolCall, 'diff' + i, edit.oldText, edit.newText, editFileName);
 
-                // Show output if available
-                if (parsed.output) {
-                    const ansiRendered = ansiToHtml(parsed.output);
-                    html += `<strong>Output:</strong>
-                    <div class="bash-output"><pre>${ansiRendered}</pre></div>`;
-                } else if (parsed.exitCode !== null) {
-                    html += `<div class="bash-no-output"><em>No output</em></div>`;
+                if (toolCall.edits.length > 1) {
+                    html += `<div class="edit-section">
+                        <div class="edit-header">Edit ${i + 1} of ${toolCall.edits.length}${edit.filePath ? ': ' + escapeHtml(edit.filePath) : ''}</div>
+                        <pre class="diff">${diff}</pre>
+                    </div>`;
+                } else {
+                    html += `<pre class="diff">${diff}</pre>`;
                 }
-
-                html += `</div>`;
-            } else {
-                html += `<div class="tool-call-result-section"><strong>Result:</strong><pre class="tool-call-result">${escapeHtml(toolCall.result)}</pre></div>`;
             }
-        }
 
-        // Show terminal output if this tool call has embedded terminal
-        if (toolCall.terminalId) {
-            html += `<div class="tool-call-terminal-section">
-                <strong>Output:</strong>
-                ${renderTerminalOutput(toolCall.terminalId)}
+            html += `</div>`;
+        } else if (toolCall.oldText !== undefined && toolCall.newText !== undefined) {
+            // Backward compatibility: single edit with oldText/newText
+            const diff = renderDiffInWorker(toolCall, 'diff', toolCall.oldText, toolCall.newText, fileName);
+            html += `<div class="tool-call-input">
+                <strong>Diff:</strong>
+                <pre class="diff">${diff}</pre>
             </div>`;
         }
-
-        html += '</div>';
     }
 
-    html += '</div>';
-    return html;
-}
-
-// Generate unified diff using Myers' diff algorithm (similar to git diff)
-// With syntax highlighting based on file type
-function generateUnifiedDiff(oldText, newText, fileName) {
-    const oldLines = oldText.split('\n');
-    const newLines = newText.split('\n');
-    const language = getLanguageFromPath(fileName);
-
-    logToQt('generateUnifiedDiff: fileName=' + fileName + ', language=' + language +
-            ', oldLines=' + oldLines.length + ', newLines=' + newLines.length);
-
-    // Compute LCS-based diff using Myers' algorithm
-    // Also track original line indices for highlighted lookup
-    const diff = computeDiffWithIndices(oldLines, newLines);
-
-    // Pre-highlight both old and new text blocks
-    let highlightedOld = oldLines.map(l => escapeHtml(l));
-    let highlightedNew = newLines.map(l => escapeHtml(l));
-
-    if (language) {
-        try {
-            const oldHighlighted = highlightCode(oldText, language);
-            const newHighlighted = highlightCode(newText, language);
-            logToQt('Diff highlight: oldHighlighted length=' + oldHighlighted.length +
-                    ', sample=' + oldHighlighted.substring(0, 200));
-            highlightedOld = splitHighlightedLines(oldHighlighted, oldLines.length);
-            highlightedNew = splitHighlightedLines(newHighlighted, newLines.length);
-            logToQt('Diff highlight: split into ' + highlightedOld.length + ' old lines, ' +
-                    highlightedNew.length + ' new lines');
-            if (highlightedNew.length > 0) {
-                logToQt('First highlighted new line: ' + highlightedNew[0]);
-            }
-        } catch (e) {
-            logToQt('Diff highlight error: ' + e);
-            // Fall back to escaped plain text (already set above)
-        }
-    } else {
-        logToQt('Diff highlight: no language detected, using plain text');
+    // Show Write tool content with syntax highlighting
+    if (isWriteTool(toolCall.name) && toolCall.newText) {
+        const language = getLanguageFromPath(toolCall.filePath);
+        const highlighted = renderInWorker(toolCall, 'content', { type: 'highlight', code: toolCall.newText, filePath: toolCall.filePath || '', language: language })
+            ?? escapeHtml(toolCall.newText);
+        const encodedCode = btoa(unescape(encodeURIComponent(toolCall.newText)));
+        html += `<div class="tool-call-input">
+            <strong>Content:</strong>
+            <div class="code-block-wrapper">
+                <button class="code-copy-btn" onclick="copyCode(this)" data-code-b64="${encodedCode}" title="Copy code"><span class="material-icon material-icon-sm">content_copy</span></button>
+                <pre><code class="hljs${language ? ' language-' + language : ''}">${highlighted}</code></pre>
+            </div>
+        </div>`;
     }
 
-    let result = [];
-    result.push(`<span class="diff-header">--- ${escapeHtml(fileName || 'file')}</span>`);
-    result.push(`<span class="diff-header">+++ ${escapeHtml(fileName || 'file')}</span>`);
+    // Show Task tool details
+    if (toolCall.name === 'Task' && toolCall.input) {
+        const prompt = toolCall.input.prompt || '';
+        const model = toolCall.input.model;
 
-    // Render diff with context
-    const contextLines = 3;
-    let i = 0;
+        html += `<div class="tool-call-input task-details">`;
 
-    while (i < diff.length) {
-        // Find next change
-        while (i < diff.length && diff[i].type === 'equal') {
-            i++;
+        if (model) {
+            html += `<div class="task-model-info"><strong>Model:</strong> ${escapeHtml(model)}</div>`;
         }
 
-        if (i >= diff.length) break;
+        if (prompt) {
+            html += `<strong>Prompt:</strong><pre class="task-prompt">${escapeHtml(prompt)}</pre>`;
+        }
 
-        // Start of hunk - show context before
-        const hunkStart = Math.max(0, i - contextLines);
+        html += `</div>`;
+    }
 
-        // Find end of continuous changes
-        let j = i;
-        while (j < diff.length && (diff[j].type !== 'equal' ||
-               (j + 1 < diff.length && diff[j + 1].type !== 'equal' && j < i + 20))) {
-            j++;
-        }
+    // Show TaskOutput tool details
+    if (toolCall.name === 'TaskOutput' && toolCall.input) {
+        const taskId = toolCall.input.task_id || '';
+        const timeout = toolCall.input.timeout;
 
-        // Show context after
-        const hunkEnd = Math.min(diff.length, j + contextLines);
-
-        // Render hunk with highlighted content
-        for (let k = hunkStart; k < hunkEnd; k++) {
-            const item = diff[k];
-            if (item.type === 'equal') {
-                // Context lines - use old index (both are the same content)
-                const content = highlightedOld[item.oldIndex] || '';
-                result.push(`<span class="diff-context"> ${content}</span>`);
-            } else if (item.type === 'delete') {
-                const content = highlightedOld[item.oldIndex] || '';
-                result.push(`<span class="diff-remove">-${content}</span>`);
-            } else if (item.type === 'insert') {
-                const content = highlightedNew[item.newIndex] || '';
-                result.push(`<span class="diff-add">+${content}</span>`);
-            }
+        html += `<div class="tool-call-input task-output-details">`;
+        html += `<strong>Task ID:</strong> <code>${escapeHtml(taskId)}</code>`;
+        if (timeout) {
+            html += `<br><strong>Timeout:</strong> ${timeout}ms`;
         }
-
-        i = hunkEnd;
+        html += `</div>`;
     }
 
-    return result.join('');
-}
+    // Show result if available (skip for Write/Edit since we show content above)
+    // Also skip if we have terminal output (terminal replaces the result display)
+    if (toolCall.result && !isWriteTool(toolCall.name) && !isEditTool(toolCall.name) && !toolCall.terminalId) {
+        if (isReadTool(toolCall.name)) {
+            // For Read tool, clean and highlight the result
+            const cleanedCode = cleanReadResult(toolCall.result);
+            const language = getLanguageFromPath(toolCall.filePath);
+            const highlighted = renderInWorker(toolCall, 'result', { type: 'highlight', code: cleanedCode, filePath: toolCall.filePath || '', language: language })
+                ?? escapeHtml(cleanedCode);
+            const encodedCode = btoa(unescape(encodeURIComponent(cleanedCode)));
+            html += `<div class="tool-call-result-section">
+                <strong>Result:</strong>
+                <div class="code-block-wrapper">
+                    <button class="code-copy-btn" onclick="copyCode(this)" data-code-b64="${encodedCode}" title="Copy code"><span class="material-icon material-icon-sm">content_copy</span></button>
+                    <pre><code class="hljs${language ? ' language-' + language : ''}">${highlighted}</code></pre>
+                </div>
+            </div>`;
+        } else if (isBashTool(toolCall.name)) {
+            // Bash/terminal tools - parse exit code and render with structured layout
+            const parsed = parseBashResult(toolCall.result);
+            const exitCodeClass = parsed.exitCode === 0 ? 'exit-success' : (parsed.exitCode !== null ? 'exit-error' : '');
 
-// Compute diff using LCS (Longest Common Subsequence) approach
-// Returns diff items with original line indices for highlighted lookup
-function computeDiffWithIndices(oldLines, newLines) {
-    const n = oldLines.length;
-    const m = newLines.length;
+            html += `<div class="tool-call-result-section bash-result-section ${exitCodeClass}">`;
 
-    // Build LCS table using dynamic programming
-    const lcs = Array(n + 1).fill(null).map(() => Array(m + 1).fill(0));
+            // Show exit code if available
+            if (parsed.exitCode !== null) {
+                html += `<div class="bash-exit-code ${exitCodeClass}"><strong>Exit code:</strong> <span class="exit-code-value">${parsed.exitCode}</span></div>`;
+            }
 
-    for (let i = 1; i <= n; i++) {
-        for (let j = 1; j <= m; j++) {
-            if (oldLines[i - 1] === newLines[j - 1]) {
-                lcs[i][j] = lcs[i - 1][j - 1] + 1;
-            } else {
-                lcs[i][j] = Math.max(lcs[i - 1][j], lcs[i][j - 1]);
+            // Show output if available
+            if (parsed.output) {
+                const ansiRendered = ansiToHtml(parsed.output);
+                html += `<strong>Output:</strong>
+                <div class="bash-output"><pre>${ansiRendered}</pre></div>`;
+            } else if (parsed.exitCode !== null) {
+                html += `<div class="bash-no-output"><em>No output</em></div>`;
             }
+
+            html += `</div>`;
+        } else {
+            html += `<div class="tool-call-result-section"><strong>Result:</strong><pre class="tool-call-result">${escapeHtml(toolCall.result)}</pre></div>`;
         }
     }
 
-    // Backtrack to build diff with line indices
-    const diff = [];
-    let i = n, j = m;
-
-    while (i > 0 || j > 0) {
-        if (i > 0 && j > 0 && oldLines[i - 1] === newLines[j - 1]) {
-            diff.unshift({ type: 'equal', value: oldLines[i - 1], oldIndex: i - 1, newIndex: j - 1 });
-            i--;
-            j--;
-        } else if (j > 0 && (i === 0 || lcs[i][j - 1] >= lcs[i - 1][j])) {
-            diff.unshift({ type: 'insert', value: newLines[j - 1], newIndex: j - 1 });
-            j--;
-        } else if (i > 0) {
-            diff.unshift({ type: 'delete', value: oldLines[i - 1], oldIndex: i - 1 });
-            i--;
-        }
+    // Show terminal output if this tool call has embedded terminal
+    if (toolCall.terminalId) {
+        html += `<div class="tool-call-terminal-section">
+            <strong>Output:</strong>
+            ${renderTerminalOutput(toolCall.terminalId)}
+        </div>`;
     }
 
-    return diff;
+    html += '</div>';
+    return html;
 }
 
 // Toggle tool call expansion
 function toggleToolCall(toolCallId) {
-    // Find the tool call in messages
-    for (const messageId in messages) {
-        const toolCall = messages[messageId].toolCalls.find(tc => tc.id === toolCallId);
-        if (toolCall) {
-            toolCall.expanded = !toolCall.expanded;
-            updateMessageDOM(messageId);
-            break;
-        }
+    const toolCall = toolCallsById.get(toolCallId);
+    if (toolCall) {
+        toolCall.expanded = !isToolCallExpanded(toolCall);
+        refreshToolCall(toolCall);
     }
 }
 
@@ -1036,8 +1441,14 @@ function toggleToolCall(toolCallId) {
 function clearMessages() {
     messages = {};
     terminals = {};  // Clear terminal output cache
+    toolCallsById.clear();
+    terminalOwners.clear();
+    cancelAllHighlightJobs();
     questionSelections = {};  // Clear any pending question state
 
+    if (messageObserver) {
+        messageObserver.disconnect();
+    }
     document.getElementById('messages').innerHTML = '';
 
     // Clear todos when messages are cleared (new session)
@@ -1057,15 +1468,7 @@ function clearTodos() {
 }
 
 // Update todos display
-function updateTodos(todosJson) {
-    let todos;
-    try {
-        todos = JSON.parse(todosJson);
-    } catch (e) {
-        console.error('Failed to parse todos JSON:', e);
-        return;
-    }
-
+function updateTodos(todos) {
     const container = document.getElementById('todos-container');
     if (!container) return;
 
@@ -1135,15 +1538,19 @@ function toggleTodos() {
 }
 
 // Scroll to bottom
-function scrollToBottom() {
-    window.scrollTo(0, document.body.scrollHeight);
-}
+// Scroll once per frame, after the frame's updates, instead of forcing a
+// layout with a scrollHeight read on every call. Scrolling past the end clamps.
+let scrollScheduled = false;
 
-// Escape HTML
-function escapeHtml(text) {
-    const div = document.createElement('div');
-    div.textContent = text;
-    return div.innerHTML;
+function scrollToBottom() {
+    if (scrollScheduled) {
+        return;
+    }
+    scrollScheduled = true;
+    requestAnimationFrame(() => {
+        scrollScheduled = false;
+        window.scrollTo(0, Number.MAX_SAFE_INTEGER);
+    });
 }
 
 // Copy code to clipboard
@@ -1198,6 +1605,12 @@ function applyColorScheme(cssVars) {
     console.log('Color scheme applied');
 }
 
+// Apply diff colors derived from the editor theme
+function applyDiffColors(removeBackground, addBackground) {
+    document.documentElement.style.setProperty('--diff-remove-bg', removeBackground);
+    document.documentElement.style.setProperty('--diff-add-bg', addBackground);
+}
+
 // Apply highlight.js theme
 function applyHighlightTheme(themePath) {
     const linkElement = document.getElementById('highlight-theme');
@@ -1276,13 +1689,11 @@ function showPermissionRequest(requestId, toolName, input, options) {
         // Write tool - show content with syntax highlighting
         const content = input.content || '';
         if (content) {
-            const language = getLanguageFromPath(filePath);
-            const highlighted = highlightCode(content, language);
             contentHtml = `
                 <div class="permission-content">
                     <div class="permission-file">${escapeHtml(filePath)}</div>
                     <div class="tool-call-input">
-                        <pre><code class="hljs${language ? ' language-' + language : ''}">${highlighted}</code></pre>
+                        <pre><code class="hljs" data-highlight-path="${escapeHtml(filePath)}">${escapeHtml(content)}</code></pre>
                     </div>
                 </div>`;
         }
@@ -1334,7 +1745,12 @@ function showPermissionRequest(requestId, toolName, input, options) {
 
     const permEl = document.createElement('div');
     permEl.innerHTML = html;
-    container.appendChild(permEl.firstElementChild);
+    const requestEl = permEl.firstElementChild;
+    container.appendChild(requestEl);
+    highlightCodeBlocks(requestEl);
+    if (isEditTool(toolName) && (input.old_string || input.new_string)) {
+        highlightDiffInto(requestEl.querySelector('pre.diff'), input.old_string || '', input.new_string || '', fileName);
+    }
     console.log('Permission request added to DOM');
     scrollToBottom();
 }
@@ -1632,64 +2048,82 @@ function submitQuestionAnswers(requestId) {
 
 // Set terminalId on a tool call (for vibe-acp where terminal info arrives in tool_call_update)
 function setToolCallTerminalId(messageId, toolCallId, terminalId) {
-    if (!messages[messageId]) return;
-    const tc = messages[messageId].toolCalls.find(t => t.id === toolCallId);
+    const tc = toolCallsById.get(toolCallId);
     if (tc) {
         tc.terminalId = terminalId;
+        terminalOwners.set(terminalId, tc);
         logToQt('setToolCallTerminalId: ' + toolCallId + ' -> ' + terminalId);
+        invalidateToolCall(tc);
         // Re-render if terminal data already exists
         if (terminals[terminalId]) {
-            updateMessageDOM(messageId);
+            refreshToolCall(tc);
             scrollToBottom();
         }
     }
 }
 
-// Terminal support - update terminal output (called from C++ via base64)
-function updateTerminal(terminalId, base64Output, finished) {
-    // Decode base64 output
-    let output;
-    try {
-        output = decodeURIComponent(escape(atob(base64Output)));
-    } catch (e) {
-        console.error('Failed to decode terminal output:', e);
-        output = '[Decode error]';
-    }
-
+// Terminal support - update terminal output (output is the whole terminal so far)
+function updateTerminal(terminalId, output, finished) {
+    // While a blob loads, keep showing the last text instead of a placeholder
+    const previous = terminals[terminalId];
+    const previousText = previous && (isBlobRef(previous.output) ? previous.previousText : previous.output);
     terminals[terminalId] = {
         output: output,
-        finished: finished
+        finished: finished,
+        previousText: isBlobRef(output) ? previousText : undefined
     };
 
-    logToQt('updateTerminal: ' + terminalId + ' finished=' + finished + ' output=' + output.length + ' chars');
-
-    // Find and update any tool calls with this terminal
-    for (const messageId in messages) {
-        const msg = messages[messageId];
-        if (msg.toolCalls) {
-            for (const tc of msg.toolCalls) {
-                if (tc.terminalId === terminalId) {
-                    // Re-render the message to update terminal display
-                    updateMessageDOM(messageId);
-                    scrollToBottom();
-                    return;
-                }
-            }
-        }
+    logToQt('updateTerminal: ' + terminalId + ' finished=' + finished + ' output=' + (isBlobRef(output) ? output.size : output.length) + ' chars');
+
+    const owner = terminalOwners.get(terminalId);
+    if (!owner) {
+        return;
+    }
+
+    // Patch only the terminal element; the rest of the body is unchanged
+    invalidateToolCall(owner);
+    const message = messages[owner.messageId];
+    if (message && message.unmounted) {
+        message.cachedHtml = null;
+        return;
+    }
+    const terminalEl = document.getElementById(`terminal-${terminalId}`);
+    if (terminalEl) {
+        terminalEl.outerHTML = renderTerminalOutput(terminalId);
+        scrollToBottom();
     }
 }
 
 // Render terminal output with ANSI color support
 function renderTerminalOutput(terminalId) {
+    // Keyed by id so updateTerminal() can patch it in place
+    const elementId = `terminal-${escapeHtml(terminalId)}`;
     const term = terminals[terminalId];
     if (!term) {
-        return '<pre class="terminal-output terminal-waiting">Waiting for output...</pre>';
+        return `<pre id="${elementId}" class="terminal-output terminal-waiting">Waiting for output...</pre>`;
+    }
+    if (isBlobRef(term.output)) {
+        const ref = term.output;
+        loadBlobText(ref, text => {
+            // A newer snapshot may have replaced this one meanwhile
+            if (terminals[terminalId] && terminals[terminalId].output === ref) {
+                updateTerminal(terminalId, text, terminals[terminalId].finished);
+            }
+        });
+        if (typeof term.previousText !== 'string') {
+            return `<pre id="${elementId}" class="terminal-output terminal-waiting">Loading output...</pre>`;
+        }
+        return renderTerminalText(elementId, term.previousText, false);
     }
 
-    const htmlOutput = ansiToHtml(term.output);
-    const statusClass = term.finished ? 'terminal-finished' : 'terminal-running';
+    return renderTerminalText(elementId, term.output, term.finished);
+}
+
+function renderTerminalText(elementId, text, finished) {
+    const htmlOutput = ansiToHtml(text);
+    const statusClass = finished ? 'terminal-finished' : 'terminal-running';
 
-    return `<pre class="terminal-output ${statusClass}">${htmlOutput}${!term.finished ? '<span class="terminal-indicator">Running...</span>' : ''}</pre>`;
+    return `<pre id="${elementId}" class="terminal-output ${statusClass}">${htmlOutput}${!finished ? '<span class="terminal-indicator">Running...</span>' : ''}</pre>`;
 }
 
 // Convert ANSI escape codes to HTML using TerminalRenderer
@@ -1804,26 +2238,15 @@ function ansiToHtmlSimple(text) {
 let trackedEdits = [];
 
 // Update the edit summary panel with tracked edits
-function updateEditSummary(editsJson) {
-    try {
-        trackedEdits = JSON.parse(editsJson);
-    } catch (e) {
-        logToQt('Failed to parse edits JSON: ' + e);
-        return;
-    }
-
+function updateEditSummary(edits) {
+    trackedEdits = edits || [];
     renderEditSummary();
 }
 
 // Add a single edit to the summary
-function addTrackedEdit(editJson) {
-    try {
-        const edit = JSON.parse(editJson);
-        trackedEdits.push(edit);
-        renderEditSummary();
-    } catch (e) {
-        logToQt('Failed to parse edit JSON: ' + e);
-    }
+function addTrackedEdit(edit) {
+    trackedEdits.push(edit);
+    renderEditSummary();
 }
 
 // Clear all tracked edits
@@ -1881,8 +2304,16 @@ function renderEditSummary() {
         const fileName = filePath.split('/').pop();
         const dirPath = filePath.substring(0, filePath.length - fileName.length);
 
+        // Escape filePath for use in JavaScript string literal within HTML attribute
+        const escapedPath = filePath.replace(/\\/g, '\\\\').replace(/'/g, "\\'");
+
         html += `<div class="edit-file-group">`;
-        html += `<div class="edit-file-name" title="${escapeHtml(filePath)}">${escapeHtml(fileName)}</div>`;
+        html += `<div class="edit-file-name" title="${escapeHtml(filePath)}">
+                <span class="edit-file-label">${escapeHtml(fileName)}</span>
+                <button class="edit-file-revert" onclick="revertFile('${escapedPath}')" title="Revert to the version before the agent's first edit">
+                    ${materialIcon('undo')}
+                </button>
+            </div>`;
 
         for (const edit of fileEdits) {
             const lineNum = edit.startLine + 1; // Convert to 1-based
@@ -1908,10 +2339,8 @@ function renderEditSummary() {
                 }
             }
 
-            // Escape filePath for use in JavaScript string literal within HTML attribute
-            const escapedPath = filePath.replace(/\\/g, '\\\\').replace(/'/g, "\\'");
             html += `
-                <div class="edit-entry" onclick="jumpToEdit('${escapedPath}', ${edit.startLine}, ${endLine})">
+                <div class="edit-entry" onclick="jumpToEdit('${escapedPath}', ${edit.startLine}, ${endLine}, ${edit.id})">
                     <span class="edit-line">L${lineNum}</span>
                     <span class="edit-changes">${changeText}</span>
                 </div>
@@ -1934,17 +2363,27 @@ function toggleEditSummary() {
     }
 }
 
-// Jump to an edit location - calls back to Qt
-function jumpToEdit(filePath, startLine, endLine) {
+// Jump to an edit location - calls back to Qt, which resolves the edit's
+// current lines by id; the recorded lines are only a fallback
+function jumpToEdit(filePath, startLine, endLine, editId) {
     logToQt('jumpToEdit called: ' + filePath + ' lines ' + startLine + '-' + endLine);
     if (bridge) {
         logToQt('Calling bridge.jumpToEdit...');
-        bridge.jumpToEdit(filePath, startLine, endLine);
+        bridge.jumpToEdit(filePath, startLine, endLine, editId || 0);
     } else {
         logToQt('Bridge not available for jumpToEdit');
     }
 }
 
+// Restore a file to its content before the agent's first edit of it
+function revertFile(filePath) {
+    if (bridge) {
+        bridge.revertFile(filePath);
+    } else {
+        logToQt('Bridge not available for revertFile');
+    }
+}
+
 // Make functions available globally for Qt calls
 window.addMessage = addMessage;
 window.updateMessage = updateMessage;
@@ -1964,6 +2403,7 @@ window.addTrackedEdit = addTrackedEdit;
 window.clearEditSummary = clearEditSummary;
 window.toggleEditSummary = toggleEditSummary;
 window.jumpToEdit = jumpToEdit;
+window.revertFile = revertFile;
 // Remove user question UI (called when question times out or fails)
 function removeUserQuestion(requestId) {
     console.log('removeUserQuestion called:', requestId);
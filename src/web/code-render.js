@@ -0,0 +1,442 @@
+/**
+ * Code rendering shared by the chat page and highlight-worker.js
+ *
+ * Language detection, highlight.js highlighting and unified diffs. Nothing
+ * here touches the DOM, so the worker can importScripts() it; log messages
+ * go through logToQt(), which both scopes define. highlight.js itself is
+ * optional: without it code is only escaped.
+ */
+
+// Escape text for use in HTML content and attribute values
+function escapeHtml(text) {
+    if (text === undefined || text === null) {
+        return '';
+    }
+    return String(text)
+        .replace(/&/g, '&amp;')
+        .replace(/</g, '&lt;')
+        .replace(/>/g, '&gt;')
+        .replace(/"/g, '&quot;')
+        .replace(/'/g, '&#39;');
+}
+
+// Map file extensions to highlight.js language identifiers
+const extToLanguage = {
+    // Web
+    'js': 'javascript', 'mjs': 'javascript', 'cjs': 'javascript',
+    'ts': 'typescript', 'tsx': 'typescript', 'jsx': 'javascript',
+    'html': 'xml', 'htm': 'xml', 'xhtml': 'xml',
+    'css': 'css', 'scss': 'scss', 'sass': 'scss', 'less': 'less',
+    'json': 'json', 'json5': 'json',
+    // Systems
+    'c': 'c', 'h': 'c',
+    'cpp': 'cpp', 'cxx': 'cpp', 'cc': 'cpp', 'hpp': 'cpp', 'hxx': 'cpp',
+    'rs': 'rust',
+    'go': 'go',
+    'zig': 'zig',
+    // JVM
+    'java': 'java', 'kt': 'kotlin', 'kts': 'kotlin', 'scala': 'scala',
+    // Scripting
+    'py': 'python', 'pyw': 'python', 'pyi': 'python',
+    'rb': 'ruby', 'rake': 'ruby',
+    'php': 'php',
+    'pl': 'perl', 'pm': 'perl',
+    'lua': 'lua',
+    'sh': 'bash', 'bash': 'bash', 'zsh': 'bash', 'fish': 'fish',
+    'ps1': 'powershell', 'psm1': 'powershell',
+    // Config/Data
+    'yaml': 'yaml', 'yml': 'yaml',
+    'toml': 'ini', 'ini': 'ini', 'conf': 'ini',
+    'xml': 'xml', 'svg': 'xml', 'xsd': 'xml', 'xsl': 'xml',
+    'md': 'markdown', 'markdown': 'markdown',
+    'sql': 'sql',
+    // Build/DevOps
+    'cmake': 'cmake', 'makefile': 'makefile', 'mk': 'makefile',
+    'dockerfile': 'dockerfile',
+    'gradle': 'gradle', 'groovy': 'groovy',
+    // Other
+    'swift': 'swift',
+    'cs': 'csharp',
+    'fs': 'fsharp', 'fsx': 'fsharp',
+    'ex': 'elixir', 'exs': 'elixir',
+    'erl': 'erlang', 'hrl': 'erlang',
+    'hs': 'haskell',
+    'ml': 'ocaml', 'mli': 'ocaml',
+    'clj': 'clojure', 'cljs': 'clojure', 'cljc': 'clojure',
+    'lisp': 'lisp', 'cl': 'lisp', 'el': 'lisp',
+    'r': 'r',
+    'dart': 'dart',
+    'v': 'verilog', 'sv': 'verilog',
+    'vhd': 'vhdl', 'vhdl': 'vhdl',
+    'tex': 'latex', 'latex': 'latex',
+    'diff': 'diff', 'patch': 'diff',
+    'qml': 'qml',
+    // Qt/KDE
+    'pro': 'qmake', 'pri': 'qmake',
+    'ui': 'xml', 'rc': 'xml', 'qrc': 'xml'
+};
+
+
+// Get highlight.js language from file path
+function getLanguageFromPath(filePath) {
+    if (!filePath) return null;
+    const fileName = filePath.split('/').pop().toLowerCase();
+
+    // Handle special filenames
+    if (fileName === 'makefile' || fileName === 'gnumakefile') return 'makefile';
+    if (fileName === 'dockerfile') return 'dockerfile';
+    if (fileName === 'cmakelists.txt') return 'cmake';
+
+    const ext = fileName.split('.').pop();
+    return extToLanguage[ext] || null;
+}
+
+// Highlight code using highlight.js
+function highlightCode(code, language) {
+    if (typeof hljs === 'undefined') {
+        return escapeHtml(code);
+    }
+
+    try {
+        if (language && hljs.getLanguage(language)) {
+            return hljs.highlight(code, { language: language }).value;
+        } else {
+            // Auto-detect if no language specified
+            return hljs.highlightAuto(code).value;
+        }
+    } catch (e) {
+        logToQt('Highlight error: ' + e);
+        return escapeHtml(code);
+    }
+}
+
+// Split highlighted HTML into lines while preserving HTML tag structure
+// Handles tags that span multiple lines by closing and reopening them at line boundaries
+function splitHighlightedLines(html, expectedCount) {
+    const lines = [];
+    let currentLine = '';
+    let openTags = [];  // Stack of open tag names
+
+    let i = 0;
+    while (i < html.length) {
+        const char = html[i];
+
+        if (char === '\n') {
+            // Close all open tags for this line
+            let closingTags = '';
+            for (let t = openTags.length - 1; t >= 0; t--) {
+                closingTags += '</span>';
+            }
+            lines.push(currentLine + closingTags);
+
+            // Start new line with reopened tags
+            currentLine = '';
+            for (let t = 0; t < openTags.length; t++) {
+                // Re-open with the same class - we need to track full opening tag
+                currentLine += `<span class="${openTags[t]}">`;
+            }
+            i++;
+        } else if (char === '<') {
+            // Parse HTML tag
+            const tagEnd = html.indexOf('>', i);
+            if (tagEnd === -1) {
+                currentLine += char;
+                i++;
+                continue;
+            }
+
+            const tagContent = html.substring(i + 1, tagEnd);
+            const fullTag = html.substring(i, tagEnd + 1);
+
+            if (tagContent.startsWith('/')) {
+                // Closing tag
+                openTags.pop();
+                currentLine += fullTag;
+            } else if (tagContent.startsWith('span')) {
+                // Opening span tag - extract class
+                const classMatch = tagContent.match(/class="([^"]+)"/);
+                const className = classMatch ? classMatch[1] : '';
+                openTags.push(className);
+                currentLine += fullTag;
+            } else {
+                // Other tag (shouldn't happen with hljs output)
+                currentLine += fullTag;
+            }
+            i = tagEnd + 1;
+        } else {
+            currentLine += char;
+            i++;
+        }
+    }
+
+    // Don't forget the last line (if no trailing newline)
+    if (currentLine || lines.length < expectedCount) {
+        // Close any remaining open tags
+        let closingTags = '';
+        for (let t = openTags.length - 1; t >= 0; t--) {
+            closingTags += `</span>`;
+        }
+        lines.push(currentLine + closingTags);
+    }
+
+    // Ensure we have the expected number of lines
+    while (lines.length < expectedCount) {
+        lines.push('');
+    }
+
+    return lines;
+}
+
+
+// Generate unified diff using Myers' diff algorithm (similar to git diff)
+// With syntax highlighting based on file type, or from oldHtml and newHtml
+// when both sides were already highlighted (one line of markup per line)
+function generateUnifiedDiff(oldText, newText, fileName, oldHtml, newHtml) {
+    const oldLines = oldText.split('\n');
+    const newLines = newText.split('\n');
+    const language = getLanguageFromPath(fileName);
+
+    logToQt('generateUnifiedDiff: fileName=' + fileName + ', language=' + language +
+            ', oldLines=' + oldLines.length + ', newLines=' + newLines.length);
+
+    // Also track original line indices for highlighted lookup
+    const diff = computeDiffWithIndices(oldLines, newLines);
+
+    // Pre-highlight both old and new text blocks
+    let highlightedOld = oldLines.map(l => escapeHtml(l));
+    let highlightedNew = newLines.map(l => escapeHtml(l));
+
+    if (typeof oldHtml === 'string' && typeof newHtml === 'string') {
+        highlightedOld = splitHighlightedLines(oldHtml, oldLines.length);
+        highlightedNew = splitHighlightedLines(newHtml, newLines.length);
+    } else if (language) {
+        try {
+            const oldHighlighted = highlightCode(oldText, language);
+            const newHighlighted = highlightCode(newText, language);
+            logToQt('Diff highlight: oldHighlighted length=' + oldHighlighted.length +
+                    ', sample=' + oldHighlighted.substring(0, 200));
+            highlightedOld = splitHighlightedLines(oldHighlighted, oldLines.length);
+            highlightedNew = splitHighlightedLines(newHighlighted, newLines.length);
+            logToQt('Diff highlight: split into ' + highlightedOld.length + ' old lines, ' +
+                    highlightedNew.length + ' new lines');
+            if (highlightedNew.length > 0) {
+                logToQt('First highlighted new line: ' + highlightedNew[0]);
+            }
+        } catch (e) {
+            logToQt('Diff highlight error: ' + e);
+            // Fall back to escaped plain text (already set above)
+        }
+    } else {
+        logToQt('Diff highlight: no language detected, using plain text');
+    }
+
+    let result = [];
+    result.push(`<span class="diff-header">--- ${escapeHtml(fileName || 'file')}</span>`);
+    result.push(`<span class="diff-header">+++ ${escapeHtml(fileName || 'file')}</span>`);
+
+    // Render diff with context
+    const contextLines = 3;
+    let i = 0;
+
+    while (i < diff.length) {
+        // Find next change
+        while (i < diff.length && diff[i].type === 'equal') {
+            i++;
+        }
+
+        if (i >= diff.length) break;
+
+        // Start of hunk - show context before
+        const hunkStart = Math.max(0, i - contextLines);
+
+        // Find end of continuous changes
+        let j = i;
+        while (j < diff.length && (diff[j].type !== 'equal' ||
+               (j + 1 < diff.length && diff[j + 1].type !== 'equal' && j < i + 20))) {
+            j++;
+        }
+
+        // Show context after
+        const hunkEnd = Math.min(diff.length, j + contextLines);
+
+        // Render hunk with highlighted content
+        for (let k = hunkStart; k < hunkEnd; k++) {
+            const item = diff[k];
+            if (item.type === 'equal') {
+                // Context lines - use old index (both are the same content)
+                const content = highlightedOld[item.oldIndex] || '';
+                result.push(`<span class="diff-context"> ${content}</span>`);
+            } else if (item.type === 'delete') {
+                const content = highlightedOld[item.oldIndex] || '';
+                result.push(`<span class="diff-remove">-${content}</span>`);
+            } else if (item.type === 'insert') {
+                const content = highlightedNew[item.newIndex] || '';
+                result.push(`<span class="diff-add">+${content}</span>`);
+            }
+        }
+
+        i = hunkEnd;
+    }
+
+    return result.join('');
+}
+
+// Compute a line diff with Myers' O(ND) algorithm in its linear-space form
+// Returns diff items with original line indices for highlighted lookup
+function computeDiffWithIndices(oldLines, newLines) {
+    // Lines become small integers so the inner loops compare numbers
+    const ids = new Map();
+    const toIds = lines => {
+        const out = new Int32Array(lines.length);
+        for (let i = 0; i < lines.length; i++) {
+            let id = ids.get(lines[i]);
+            if (id === undefined) {
+                id = ids.size;
+                ids.set(lines[i], id);
+            }
+            out[i] = id;
+        }
+        return out;
+    };
+
+    const diff = [];
+    const state = {
+        a: toIds(oldLines),
+        b: toIds(newLines),
+        oldLines: oldLines,
+        newLines: newLines,
+        diff: diff,
+        budget: DIFF_MAX_COST
+    };
+    diffRange(state, 0, oldLines.length, 0, newLines.length);
+    return diff;
+}
+
+// Work allowed per diff before the rest is shown as whole replaced blocks
+const DIFF_MAX_COST = 10000000;
+
+function pushEqual(state, aLo, aHi, bLo) {
+    for (let i = aLo, j = bLo; i < aHi; i++, j++) {
+        state.diff.push({ type: 'equal', value: state.oldLines[i], oldIndex: i, newIndex: j });
+    }
+}
+
+function pushReplace(state, aLo, aHi, bLo, bHi) {
+    for (let i = aLo; i < aHi; i++) {
+        state.diff.push({ type: 'delete', value: state.oldLines[i], oldIndex: i });
+    }
+    for (let j = bLo; j < bHi; j++) {
+        state.diff.push({ type: 'insert', value: state.newLines[j], newIndex: j });
+    }
+}
+
+// Diff a[aLo, aHi) against b[bLo, bHi), appending items in order
+function diffRange(state, aLo, aHi, bLo, bHi) {
+    const a = state.a;
+    const b = state.b;
+
+    // Common prefix and suffix never need the search
+    let prefix = 0;
+    while (aLo + prefix < aHi && bLo + prefix < bHi && a[aLo + prefix] === b[bLo + prefix]) {
+        prefix++;
+    }
+    pushEqual(state, aLo, aLo + prefix, bLo);
+    aLo += prefix;
+    bLo += prefix;
+
+    let suffix = 0;
+    while (aHi - suffix > aLo && bHi - suffix > bLo && a[aHi - suffix - 1] === b[bHi - suffix - 1]) {
+        suffix++;
+    }
+    aHi -= suffix;
+    bHi -= suffix;
+
+    // Pure insertion or deletion, or out of budget: one replaced block
+    if (aLo === aHi || bLo === bHi || state.budget <= 0) {
+        pushReplace(state, aLo, aHi, bLo, bHi);
+    } else {
+        const snake = middleSnake(state, aLo, aHi, bLo, bHi);
+        if (snake) {
+            diffRange(state, aLo, snake.x, bLo, snake.y);
+            pushEqual(state, snake.x, snake.u, snake.y);
+            diffRange(state, snake.u, aHi, snake.v, bHi);
+        } else {
+            pushReplace(state, aLo, aHi, bLo, bHi);
+        }
+    }
+
+    pushEqual(state, aHi, aHi + suffix, bHi);
+}
+
+// Find the middle snake of an optimal edit path, searching from both ends at
+// once. Returns {x, y, u, v} with the snake running from (x, y) to (u, v) in
+// absolute indices, or null once the cost budget runs out. Both ranges must be
+// non-empty with their first and last lines differing.
+function middleSnake(state, aLo, aHi, bLo, bHi) {
+    const a = state.a;
+    const b = state.b;
+    const n = aHi - aLo;
+    const m = bHi - bLo;
+    const delta = n - m;
+    const odd = (delta & 1) !== 0;
+    const maxD = Math.ceil((n + m) / 2);
+    const offset = maxD + 1;
+
+    // Furthest x reached on each diagonal, forwards and from the end backwards
+    const forward = new Int32Array(2 * offset + 1);
+    const backward = new Int32Array(2 * offset + 1);
+
+    for (let d = 0; d <= maxD; d++) {
+        state.budget -= 2 * d + 1;
+        if (state.budget <= 0) {
+            return null;
+        }
+
+        for (let k = -d; k <= d; k += 2) {
+            let x = (k === -d || (k !== d && forward[offset + k - 1] < forward[offset + k + 1]))
+                ? forward[offset + k + 1]
+                : forward[offset + k - 1] + 1;
+            let y = x - k;
+            const startX = x;
+            const startY = y;
+            while (x < n && y < m && a[aLo + x] === b[bLo + y]) {
+                x++;
+                y++;
+            }
+            forward[offset + k] = x;
+
+            const reverseK = delta - k;
+            if (odd && reverseK >= -(d - 1) && reverseK <= d - 1 && x + backward[offset + reverseK] >= n) {
+                return { x: aLo + startX, y: bLo + startY, u: aLo + x, v: bLo + y };
+            }
+        }
+
+        for (let k = -d; k <= d; k += 2) {
+            let x = (k === -d || (k !== d && backward[offset + k - 1] < backward[offset + k + 1]))
+                ? backward[offset + k + 1]
+                : backward[offset + k - 1] + 1;
+            let y = x - k;
+            const startX = x;
+            const startY = y;
+            while (x < n && y < m && a[aHi - 1 - x] === b[bHi - 1 - y]) {
+                x++;
+                y++;
+            }
+            backward[offset + k] = x;
+
+            const forwardK = delta - k;
+            if (!odd && forwardK >= -d && forwardK <= d && x + forward[offset + forwardK] >= n) {
+                return { x: aHi - x, y: bHi - y, u: aHi - startX, v: bHi - startY };
+            }
+        }
+    }
+    return null;
+}
+
+// Run one job as posted to highlight-worker.js and return its HTML
+function runHighlightJob(job) {
+    if (job.type === 'diff') {
+        return generateUnifiedDiff(job.oldText, job.newText, job.fileName, job.oldHtml, job.newHtml);
+    }
+    return highlightCode(job.code, job.language);
+}
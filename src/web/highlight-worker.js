@@ -0,0 +1,25 @@
+/**
+ * Highlighting and diffing off the chat page's main thread
+ *
+ * Receives {jobId, type, ...} messages from the pool in chat.js, runs them
+ * through runHighlightJob() and answers {jobId, html} or {jobId, error}.
+ * highlight.js is only imported for jobs that C++ couldn't highlight.
+ */
+importScripts('code-render.js');
+
+function logToQt(message) {
+    postMessage({ log: message });
+}
+
+onmessage = event => {
+    const job = event.data;
+    try {
+        const highlighted = job.type === 'diff' && typeof job.oldHtml === 'string';
+        if (!highlighted && typeof hljs === 'undefined') {
+            importScripts('vendor/highlight.min.js');
+        }
+        postMessage({ jobId: job.jobId, html: runHighlightJob(job) });
+    } catch (e) {
+        postMessage({ jobId: job.jobId, error: String(e) });
+    }
+};